@@ -0,0 +1,182 @@
+#include "BatchStateMachine.h"
+
+/**
+ * @brief Construct a new BatchStateMachine object.
+ *
+ * @param states PROGMEM state table, indexed by state id.
+ * @param stateCount Number of rows in the table (at most MAX_STATES).
+ * @param eepromAddress EEPROM address of the persisted state byte.
+ */
+BatchStateMachine::BatchStateMachine(const BatchState* states, byte stateCount, int eepromAddress) {
+    this->states = states;
+    this->stateCount = stateCount < MAX_STATES ? stateCount : MAX_STATES;
+    this->eepromAddress = eepromAddress;
+    this->state = 0;
+    this->subStep = 0;
+    this->isSubStepStart = true;
+}
+
+/**
+ * @brief Restores the persisted state.
+ *
+ * The state is in the high nibble of the byte and the sub-step in the low nibble. A blank EEPROM (0xFF) or a state
+ * id outside the table falls back to state 0.
+ *
+ * @return true if a state other than state 0 was resumed.
+ */
+bool BatchStateMachine::begin() {
+    byte saved = EEPROM.read(eepromAddress);
+    byte savedState = saved >> 4;
+    byte savedSubStep = saved & 0x0F;
+
+    BatchState row;
+    if (savedState == 0 || savedState >= stateCount) {
+        state = 0;
+        subStep = 0;
+        isSubStepStart = true;
+        persist();
+        readState(state, row);
+        if (row.onEnter != nullptr) {
+            row.onEnter();
+        }
+        return false;
+    }
+
+    readState(savedState, row);
+    state = savedState;
+    subStep = (row.onResume != nullptr) ? row.onResume(savedSubStep) : savedSubStep;
+    isSubStepStart = true;
+    persist();
+    return true;
+}
+
+/**
+ * @brief Leaves the current state and enters another one.
+ *
+ * Runs the exit action of the current state, persists the new state at sub-step 0, then runs its entry action.
+ *
+ * @param next The state to enter.
+ */
+void BatchStateMachine::transitionTo(byte next) {
+    if (next >= stateCount) {
+        return;
+    }
+
+    BatchState row;
+    readState(state, row);
+    if (row.onExit != nullptr) {
+        row.onExit();
+    }
+
+    state = next;
+    subStep = 0;
+    isSubStepStart = true;
+    persist();
+
+    readState(state, row);
+    if (row.onEnter != nullptr) {
+        row.onEnter();
+    }
+}
+
+/**
+ * @brief Runs the current step function once and applies its result.
+ *
+ * STEP_NEXT persists the next sub-step; after the last sub-step it completes the state like STEP_DONE.
+ */
+void BatchStateMachine::update() {
+    BatchState row;
+    readState(state, row);
+    if (row.step == nullptr) {
+        return;
+    }
+
+    bool isStart = isSubStepStart;
+    isSubStepStart = false;
+    switch (row.step(subStep, isStart)) {
+        case STEP_RUNNING:
+            break;
+        case STEP_NEXT:
+            if (subStep + 1 < row.subStepCount && subStep + 1 < MAX_SUB_STEPS) {
+                subStep++;
+                isSubStepStart = true;
+                persist();
+            } else {
+                transitionTo(row.doneState);
+            }
+            break;
+        case STEP_DONE:
+            transitionTo(row.doneState);
+            break;
+        case STEP_FAILED:
+            transitionTo(row.failState);
+            break;
+    }
+}
+
+/**
+ * @brief Returns the current state.
+ *
+ * @return The current state id.
+ */
+byte BatchStateMachine::getState() const {
+    return state;
+}
+
+/**
+ * @brief Returns the current sub-step.
+ *
+ * @return The current sub-step of the current state.
+ */
+byte BatchStateMachine::getSubStep() const {
+    return subStep;
+}
+
+/**
+ * @brief Returns the name of the current state.
+ *
+ * @return The PROGMEM name, printable with Serial.print().
+ */
+const __FlashStringHelper* BatchStateMachine::getStateName() const {
+    return getStateName(state);
+}
+
+/**
+ * @brief Returns the name of any state.
+ *
+ * @param id The state id, below getStateCount().
+ * @return The PROGMEM name, printable with Serial.print().
+ */
+const __FlashStringHelper* BatchStateMachine::getStateName(byte id) const {
+    BatchState row;
+    readState(id, row);
+    return reinterpret_cast<const __FlashStringHelper*>(row.name);
+}
+
+/**
+ * @brief Returns the number of states in the table.
+ *
+ * @return The number of states.
+ */
+byte BatchStateMachine::getStateCount() const {
+    return stateCount;
+}
+
+/**
+ * @brief Copies a row of the state table out of PROGMEM.
+ *
+ * @param id The state id.
+ * @param row Receives the row.
+ */
+void BatchStateMachine::readState(byte id, BatchState& row) const {
+    memcpy_P(&row, &states[id], sizeof(BatchState));
+}
+
+/**
+ * @brief Writes the current state and sub-step to EEPROM.
+ *
+ * Uses EEPROM.update() so an unchanged byte is not rewritten.
+ */
+void BatchStateMachine::persist() const {
+    EEPROM.update(eepromAddress, (byte)((state << 4) | (subStep & 0x0F)));
+}
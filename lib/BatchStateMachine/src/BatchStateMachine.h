@@ -0,0 +1,143 @@
+/**
+ * @file BatchStateMachine.h
+ * @brief Header file for the BatchStateMachine class.
+ *
+ * This file contains the declaration of the BatchStateMachine class, a table-driven state machine for a batch
+ * process that survives power cuts. Each state is a row of a PROGMEM table with entry/exit actions, a non-blocking
+ * step function, the number of sub-steps in the state and the states to go to when it completes or fails. The
+ * current state and sub-step are packed into a single EEPROM byte, so every update is one atomic byte write and a
+ * power cut resumes the batch at the sub-step it was in.
+ */
+
+#ifndef BATCHSTATEMACHINE_H
+#define BATCHSTATEMACHINE_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+/**
+ * @brief What a step function reports back to the state machine.
+ */
+enum BatchStepResult {
+    STEP_RUNNING,  ///< The sub-step is still in progress; call again later
+    STEP_NEXT,     ///< The sub-step is finished; go to the next one (or complete the state after the last)
+    STEP_DONE,     ///< The state is finished; go to its done state
+    STEP_FAILED    ///< The state failed; go to its fail state
+};
+
+/**
+ * @brief One row of the state table. Any function pointer may be nullptr.
+ */
+struct BatchState {
+    const char* name;                                    ///< PROGMEM name of the state, for logging
+    void (*onEnter)();                                   ///< Run when the state is entered (not when resumed)
+    BatchStepResult (*step)(byte subStep, bool isStart); ///< Run on every update(); isStart on a sub-step's first call
+    void (*onExit)();                                    ///< Run when the state is left
+    byte (*onResume)(byte subStep);                      ///< Sub-step to continue from after a power cut
+    byte subStepCount;                                   ///< Number of sub-steps; STEP_NEXT on the last completes it
+    byte doneState;                                      ///< State to go to when the state completes
+    byte failState;                                      ///< State to go to when the state fails
+};
+
+/**
+ * @class BatchStateMachine
+ * @brief Runs a PROGMEM table of BatchState rows and persists the position in EEPROM.
+ *
+ * State 0 is the initial state, used on a blank EEPROM. A state without a step function waits until
+ * transitionTo() is called from outside, e.g. on a button press.
+ */
+class BatchStateMachine {
+public:
+    static const byte MAX_STATES = 16;     ///< States that fit in the persisted byte
+    static const byte MAX_SUB_STEPS = 16;  ///< Sub-steps that fit in the persisted byte
+
+    /**
+     * @brief Construct a new BatchStateMachine object.
+     *
+     * @param states PROGMEM state table, indexed by state id.
+     * @param stateCount Number of rows in the table (at most MAX_STATES).
+     * @param eepromAddress EEPROM address of the persisted state byte.
+     */
+    BatchStateMachine(const BatchState* states, byte stateCount, int eepromAddress);
+
+    /**
+     * @brief Restores the persisted state.
+     *
+     * A valid persisted state is resumed without running its entry action, at the sub-step given by its onResume
+     * function (or the persisted sub-step if it has none). Otherwise the machine enters state 0.
+     *
+     * @return true if a state other than state 0 was resumed.
+     */
+    bool begin();
+
+    /**
+     * @brief Leaves the current state and enters another one.
+     *
+     * @param next The state to enter.
+     */
+    void transitionTo(byte next);
+
+    /**
+     * @brief Runs the current step function once and applies its result. Call this regularly.
+     */
+    void update();
+
+    /**
+     * @brief Returns the current state.
+     *
+     * @return The current state id.
+     */
+    byte getState() const;
+
+    /**
+     * @brief Returns the current sub-step.
+     *
+     * @return The current sub-step of the current state.
+     */
+    byte getSubStep() const;
+
+    /**
+     * @brief Returns the name of the current state.
+     *
+     * @return The PROGMEM name, printable with Serial.print().
+     */
+    const __FlashStringHelper* getStateName() const;
+
+    /**
+     * @brief Returns the name of any state.
+     *
+     * @param id The state id, below getStateCount().
+     * @return The PROGMEM name, printable with Serial.print().
+     */
+    const __FlashStringHelper* getStateName(byte id) const;
+
+    /**
+     * @brief Returns the number of states in the table.
+     *
+     * @return The number of states.
+     */
+    byte getStateCount() const;
+
+private:
+    /**
+     * @brief Copies a row of the state table out of PROGMEM.
+     *
+     * @param id The state id.
+     * @param row Receives the row.
+     */
+    void readState(byte id, BatchState& row) const;
+
+    /**
+     * @brief Writes the current state and sub-step to EEPROM.
+     */
+    void persist() const;
+
+    const BatchState* states;  ///< PROGMEM state table
+    byte stateCount;           ///< Number of states in the table
+    int eepromAddress;         ///< Address of the persisted state byte
+    byte state;                ///< Current state
+    byte subStep;              ///< Current sub-step
+    bool isSubStepStart;       ///< Whether the next step call is the first of its sub-step
+};
+
+#endif  // BATCHSTATEMACHINE_H
@@ -5,7 +5,14 @@
  * 
  * @param pin The GPIO pin where the buzzer is connected.
  */
-Buzzer::Buzzer(uint8_t pin) : _pin(pin) {}
+Buzzer::Buzzer(uint8_t pin) : _pin(pin) {
+    queueHead = 0;
+    queueCount = 0;
+    segment = 0;
+    segmentLength = 0;
+    segmentStart = 0;
+    isSoundStarted = false;
+}
 
 /**
  * @brief Initializes the buzzer pin.
@@ -16,19 +23,115 @@ void Buzzer::begin() {
 }
 
 /**
- * @brief Produces a sequence of beeps.
+ * @brief Queues a sequence of beeps.
  * 
  * @param times Number of beeps.
  * @param duration Length of each beep in milliseconds.
  * @param pause Time to wait between beeps in milliseconds.
+ * @return true if the beeps were queued.
  */
-void Buzzer::beep(uint8_t times, uint16_t duration, uint16_t pause) {
-    for (uint8_t i = 0; i < times; i++) {
-        digitalWrite(_pin, HIGH);
-        delay(duration);
-        digitalWrite(_pin, LOW);
-        if (i < times - 1) delay(pause);
+bool Buzzer::beep(uint8_t times, uint16_t duration, uint16_t pause) {
+    if (times == 0 || duration == 0) {
+        return true;
     }
+    Sound sound = { nullptr, times, duration, pause };
+    return enqueue(sound);
+}
+
+/**
+ * @brief Queues a PROGMEM pattern.
+ * 
+ * @param pattern On/off durations in milliseconds, starting with on and terminated by 0.
+ * @return true if the pattern was queued.
+ */
+bool Buzzer::play(const uint16_t* pattern) {
+    Sound sound = { pattern, 0, 0, 0 };
+    return enqueue(sound);
+}
 
-    delay(1000);
+/**
+ * @brief Advances the sound being played.
+ * 
+ * Moves on to the next segment once the current one has run its length, switching the
+ * pin on for even segments and off for odd ones, and starts the next queued sound when
+ * the current one ends.
+ */
+void Buzzer::update() {
+    unsigned long now = millis();
+
+    while (queueCount > 0) {
+        const Sound& sound = queue[queueHead];
+        if (!isSoundStarted) {
+            isSoundStarted = true;
+            segment = 0;
+            segmentStart = now;
+            segmentLength = segmentDuration(sound, 0);
+        } else if (now - segmentStart >= segmentLength) {
+            segmentStart += segmentLength;
+            segment++;
+            segmentLength = segmentDuration(sound, segment);
+        } else {
+            return;
+        }
+
+        if (segmentLength > 0) {
+            digitalWrite(_pin, (segment % 2 == 0) ? HIGH : LOW);
+            continue;
+        }
+
+        digitalWrite(_pin, LOW);  // Sound finished
+        queueHead = (queueHead + 1) % QUEUE_SIZE;
+        queueCount--;
+        isSoundStarted = false;
+    }
+}
+
+/**
+ * @brief Checks whether a sound is playing or waiting in the queue.
+ * 
+ * @return true while the buzzer is busy.
+ */
+bool Buzzer::isPlaying() const {
+    return queueCount > 0;
+}
+
+/**
+ * @brief Silences the buzzer and drops every queued sound.
+ */
+void Buzzer::stop() {
+    queueCount = 0;
+    isSoundStarted = false;
+    digitalWrite(_pin, LOW);
+}
+
+/**
+ * @brief Duration of one segment of a sound.
+ * 
+ * @param sound The sound.
+ * @param index Segment index; even segments are on, odd segments are off.
+ * @return The segment duration in milliseconds, or 0 past the end.
+ */
+uint16_t Buzzer::segmentDuration(const Sound& sound, uint8_t index) {
+    if (sound.pattern != nullptr) {
+        return pgm_read_word(&sound.pattern[index]);
+    }
+    if (index >= 2 * sound.times) {
+        return 0;
+    }
+    return (index % 2 == 0) ? sound.duration : sound.pause;
+}
+
+/**
+ * @brief Adds a sound to the queue.
+ * 
+ * @param sound The sound to add.
+ * @return true if it was added, false if the queue is full.
+ */
+bool Buzzer::enqueue(const Sound& sound) {
+    if (queueCount >= QUEUE_SIZE) {
+        return false;
+    }
+    queue[(queueHead + queueCount) % QUEUE_SIZE] = sound;
+    queueCount++;
+    return true;
 }
@@ -6,9 +6,20 @@
 /**
  * @class Buzzer
  * @brief A simple class to control a digital buzzer using a GPIO pin.
+ *
+ * Sounds are queued and played in the background by update(), which must be called
+ * regularly (every few milliseconds). A pattern is a PROGMEM list of durations in
+ * milliseconds, alternating on and off and starting with on, terminated by 0:
+ *
+ * @code
+ * const uint16_t twoBeeps[] PROGMEM = { 200, 200, 200, 0 };
+ * buzzer.play(twoBeeps);
+ * @endcode
  */
 class Buzzer {
   public:
+    static const uint8_t QUEUE_SIZE = 4; ///< Number of sounds that can wait to be played
+
     /**
      * @brief Construct a new Buzzer object
      * 
@@ -22,16 +33,79 @@ class Buzzer {
     void begin();
 
     /**
-     * @brief Beep the buzzer multiple times.
+     * @brief Queue a number of beeps. Returns immediately.
+     * 
+     * The beeps are followed by one pause of silence, so consecutive calls stay apart.
      * 
      * @param times Number of beeps (default is 1).
      * @param duration Duration of each beep in milliseconds (default is 200 ms).
      * @param pause Pause between beeps in milliseconds (default is 200 ms).
+     * @return true if the beeps were queued, false if the queue is full.
+     */
+    bool beep(uint8_t times = 1, uint16_t duration = 200, uint16_t pause = 200);
+
+    /**
+     * @brief Queue a PROGMEM pattern. Returns immediately.
+     * 
+     * @param pattern On/off durations in milliseconds, starting with on and terminated by 0.
+     * @return true if the pattern was queued, false if the queue is full.
+     */
+    bool play(const uint16_t* pattern);
+
+    /**
+     * @brief Advance the sound being played. Call this from the main loop or a periodic tick.
+     */
+    void update();
+
+    /**
+     * @brief Check whether a sound is playing or waiting in the queue.
+     * 
+     * @return true while the buzzer is busy.
+     */
+    bool isPlaying() const;
+
+    /**
+     * @brief Silence the buzzer and drop every queued sound.
      */
-    void beep(uint8_t times = 1, uint16_t duration = 200, uint16_t pause = 200);
+    void stop();
 
   private:
+    /**
+     * @brief A queued sound: either a PROGMEM pattern or a run of equal beeps.
+     */
+    struct Sound {
+        const uint16_t* pattern; ///< PROGMEM pattern, or nullptr for a run of beeps
+        uint8_t times;           ///< Number of beeps
+        uint16_t duration;       ///< Beep length (ms)
+        uint16_t pause;          ///< Gap between beeps and after the last one (ms)
+    };
+
+    /**
+     * @brief Duration of one segment of a sound.
+     * 
+     * @param sound The sound.
+     * @param index Segment index; even segments are on, odd segments are off.
+     * @return The segment duration in milliseconds, or 0 past the end.
+     */
+    static uint16_t segmentDuration(const Sound& sound, uint8_t index);
+
+    /**
+     * @brief Add a sound to the queue.
+     * 
+     * @param sound The sound to add.
+     * @return true if it was added, false if the queue is full.
+     */
+    bool enqueue(const Sound& sound);
+
     uint8_t _pin; ///< GPIO pin used for the buzzer
+
+    Sound queue[QUEUE_SIZE];       ///< Sounds waiting to be played; the head is the one playing
+    uint8_t queueHead;             ///< Index of the current sound
+    uint8_t queueCount;            ///< Number of queued sounds, including the current one
+    uint8_t segment;               ///< Current segment of the current sound
+    uint16_t segmentLength;        ///< Length of the current segment (ms)
+    unsigned long segmentStart;    ///< Time the current segment started (ms)
+    bool isSoundStarted;           ///< Whether the head sound has started
 };
 
 #endif // BUZZER_H
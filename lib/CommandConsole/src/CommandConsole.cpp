@@ -0,0 +1,119 @@
+#include "CommandConsole.h"
+#include "Logger.h"
+
+/**
+ * @brief Construct a new CommandConsole object.
+ *
+ * @param in Port the commands are read from.
+ * @param commands PROGMEM command table.
+ * @param commandCount Number of entries in the table.
+ */
+CommandConsole::CommandConsole(Stream& in, const ConsoleCommand* commands, byte commandCount) : in(in) {
+    this->commands = commands;
+    this->commandCount = commandCount;
+    this->length = 0;
+    this->isOverflow = false;
+}
+
+/**
+ * @brief Reads the characters that have arrived and runs the command once a line is complete.
+ *
+ * At most READ_LIMIT characters are taken per call. A line ends with CR or LF; a line longer than the buffer is
+ * skipped up to its end and reported.
+ */
+void CommandConsole::update() {
+    for (byte i = 0; i < READ_LIMIT && in.available() > 0; i++) {
+        char c = in.read();
+        if (c == '\r' || c == '\n') {
+            if (isOverflow) {
+                logger.print(F("[Console] Line too long, at most % characters."), LINE_SIZE - 1);
+            } else if (length > 0) {
+                line[length] = '\0';
+                execute();
+            }
+            length = 0;
+            isOverflow = false;
+        } else if (length < LINE_SIZE - 1) {
+            line[length++] = c;
+        } else {
+            isOverflow = true;
+        }
+    }
+}
+
+/**
+ * @brief Formats the help line of the next command, its name and usage. A Logger reply source.
+ *
+ * @param cursor Index of the command, advanced past it.
+ * @param line Buffer for the line.
+ * @return true if a line was formatted, false after the last command.
+ */
+bool CommandConsole::formatHelp(byte& cursor, TextBuffer& line) const {
+    if (cursor >= commandCount) {
+        return false;
+    }
+    const ConsoleCommand& command = commands[cursor++];
+    line.append(F("  ")).append(reinterpret_cast<const __FlashStringHelper*>(command.name));
+    line.append(' ').append(reinterpret_cast<const __FlashStringHelper*>(command.usage));
+    return true;
+}
+
+/**
+ * @brief Parses a whole number argument.
+ *
+ * @param text The argument.
+ * @param value Set to the number if the argument is valid.
+ * @return true if the whole argument is a decimal number.
+ */
+bool CommandConsole::parseLong(const char* text, long& value) {
+    char* end;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+/**
+ * @brief Splits the buffered line into words and runs the matching command.
+ *
+ * Words are separated by spaces; the separators are replaced by NULs in place, so no copy is made. The command
+ * word is matched without regard to case.
+ */
+void CommandConsole::execute() {
+    char* argv[MAX_ARGS];
+    byte argc = 0;
+    char* p = line;
+    while (*p != '\0') {
+        while (*p == ' ') {
+            *p++ = '\0';
+        }
+        if (*p == '\0') {
+            break;
+        }
+        if (argc == MAX_ARGS) {
+            logger.print(F("[Console] Too many arguments, at most %."), MAX_ARGS - 1);
+            return;
+        }
+        argv[argc++] = p;
+        while (*p != '\0' && *p != ' ') {
+            p++;
+        }
+    }
+    if (argc == 0) {
+        return;
+    }
+
+    for (char* c = argv[0]; *c != '\0'; c++) {
+        *c = tolower(*c);
+    }
+    for (byte i = 0; i < commandCount; i++) {
+        if (strcmp_P(argv[0], commands[i].name) == 0) {
+            CommandHandler handler = (CommandHandler)pgm_read_ptr(&commands[i].handler);
+            handler(argc, argv);
+            return;
+        }
+    }
+    logger.print(F("[Console] Unknown command, type help for the list."));
+}
@@ -0,0 +1,87 @@
+/**
+ * @file CommandConsole.h
+ * @brief Header file for the CommandConsole class.
+ *
+ * This file contains the declaration of the CommandConsole class, a line-oriented command interpreter for the
+ * serial port. Characters are collected into a fixed buffer as they arrive; when a line is complete it is split into
+ * words and the first word is looked up in a command table kept in PROGMEM. Nothing waits for input, so update()
+ * can run as a scheduler task next to the machine.
+ *
+ * Replies and errors go through the Logger, so a long reply never blocks on the serial port either; help and other
+ * replies of many lines are sent with Logger::startReply(), one line per log update.
+ */
+
+#ifndef COMMANDCONSOLE_H
+#define COMMANDCONSOLE_H
+
+#include <Arduino.h>
+#include "TextBuffer.h"
+
+typedef void (*CommandHandler)(byte argc, char* argv[]);  ///< Runs a command; argv[0] is the command name
+
+/**
+ * @brief One entry of a command table. Tables are stored in PROGMEM, names and usage included.
+ */
+struct ConsoleCommand {
+    char name[10];           ///< Command word, lower case
+    char usage[40];          ///< Arguments and description shown by help
+    CommandHandler handler;  ///< Function that runs the command
+};
+
+/**
+ * @class CommandConsole
+ * @brief Reads commands from a serial port without blocking and runs them from a PROGMEM table.
+ */
+class CommandConsole {
+public:
+    static const byte LINE_SIZE = 48;  ///< Longest command line, including the NUL
+    static const byte MAX_ARGS = 4;    ///< Most words per line, including the command
+    static const byte READ_LIMIT = 16; ///< Most characters read per update()
+
+    /**
+     * @brief Construct a new CommandConsole object.
+     *
+     * @param in Port the commands are read from.
+     * @param commands PROGMEM command table.
+     * @param commandCount Number of entries in the table.
+     */
+    CommandConsole(Stream& in, const ConsoleCommand* commands, byte commandCount);
+
+    /**
+     * @brief Reads the characters that have arrived and runs the command once a line is complete.
+     */
+    void update();
+
+    /**
+     * @brief Formats the help line of the next command, its name and usage. A Logger reply source.
+     *
+     * @param cursor Index of the command, advanced past it.
+     * @param line Buffer for the line.
+     * @return true if a line was formatted, false after the last command.
+     */
+    bool formatHelp(byte& cursor, TextBuffer& line) const;
+
+    /**
+     * @brief Parses a whole number argument.
+     *
+     * @param text The argument.
+     * @param value Set to the number if the argument is valid.
+     * @return true if the whole argument is a decimal number.
+     */
+    static bool parseLong(const char* text, long& value);
+
+private:
+    /**
+     * @brief Splits the buffered line into words and runs the matching command.
+     */
+    void execute();
+
+    Stream& in;                        ///< Port the commands are read from
+    const ConsoleCommand* commands;    ///< PROGMEM command table
+    byte commandCount;                 ///< Entries in the table
+    char line[LINE_SIZE];              ///< Line being received
+    byte length;                       ///< Characters in the line
+    bool isOverflow;                   ///< Whether the line is too long and is being skipped
+};
+
+#endif  // COMMANDCONSOLE_H
@@ -0,0 +1,31 @@
+#include "Crc16.h"
+
+/**
+ * @brief Computes the CRC of a block of bytes.
+ *
+ * @param data Bytes to check.
+ * @param size Number of bytes.
+ * @return The CRC-16/CCITT.
+ */
+uint16_t Crc16::compute(const void* data, byte size) {
+    return update(INITIAL, data, size);
+}
+
+/**
+ * @brief Continues a CRC over more bytes, for data that is not in one block.
+ *
+ * @param crc CRC of the bytes so far, INITIAL for none.
+ * @param data Bytes to add.
+ * @param size Number of bytes.
+ * @return The CRC including the added bytes.
+ */
+uint16_t Crc16::update(uint16_t crc, const void* data, byte size) {
+    const byte* bytes = static_cast<const byte*>(data);
+    for (byte i = 0; i < size; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (byte bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
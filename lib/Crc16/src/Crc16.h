@@ -0,0 +1,43 @@
+/**
+ * @file Crc16.h
+ * @brief Header file for the Crc16 class.
+ *
+ * This file contains the declaration of the Crc16 class, which computes the CRC-16/CCITT (polynomial 0x1021, initial
+ * value 0xFFFF) that guards the scale calibration in EEPROM and the telemetry records. Both have to agree with
+ * tools/telemetry_decode.py, so the algorithm lives in one place.
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <Arduino.h>
+
+/**
+ * @class Crc16
+ * @brief CRC-16/CCITT, computed bit by bit so it needs no table in flash.
+ */
+class Crc16 {
+public:
+    static const uint16_t INITIAL = 0xFFFF;  ///< Value the CRC starts from
+
+    /**
+     * @brief Computes the CRC of a block of bytes.
+     *
+     * @param data Bytes to check.
+     * @param size Number of bytes.
+     * @return The CRC-16/CCITT.
+     */
+    static uint16_t compute(const void* data, byte size);
+
+    /**
+     * @brief Continues a CRC over more bytes, for data that is not in one block.
+     *
+     * @param crc CRC of the bytes so far, INITIAL for none.
+     * @param data Bytes to add.
+     * @param size Number of bytes.
+     * @return The CRC including the added bytes.
+     */
+    static uint16_t update(uint16_t crc, const void* data, byte size);
+};
+
+#endif  // CRC16_H
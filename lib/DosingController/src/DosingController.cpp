@@ -0,0 +1,151 @@
+#include "DosingController.h"
+
+/**
+ * @brief Construct a new DosingController object with no stop latency, no trickle band and no correction.
+ */
+DosingController::DosingController() {
+    this->stopLatencyMs = 0;
+    this->trickleBand = 0.0f;
+    this->learningRate = 0.5f;
+    this->historyIntervalMs = DEFAULT_HISTORY_INTERVAL;
+    this->correction = 0.0f;
+    this->target = 0.0f;
+    this->isStopped = false;
+    this->head = 0;
+    this->count = 0;
+}
+
+/**
+ * @brief Sets how the dose is cut off.
+ *
+ * @param stopLatencyMs Time from the stop decision until material stops landing on the scale (ms).
+ * @param trickleBand Remaining grams below which the motor runs at the trickle speed, 0 for no trickle.
+ * @param learningRate Fraction of each batch's error added to the learned correction (0 to 1).
+ */
+void DosingController::configure(unsigned long stopLatencyMs, float trickleBand, float learningRate) {
+    this->stopLatencyMs = stopLatencyMs;
+    this->trickleBand = trickleBand;
+    this->learningRate = constrain(learningRate, 0.0f, 1.0f);
+}
+
+/**
+ * @brief Sets the least time between readings kept for the flow rate.
+ *
+ * @param intervalMs Least time between history readings (ms), 0 to keep every reading.
+ */
+void DosingController::setHistoryInterval(unsigned int intervalMs) {
+    this->historyIntervalMs = intervalMs;
+}
+
+/**
+ * @brief Sets the weight each dose fills to.
+ *
+ * @param target Weight to reach, in grams.
+ */
+void DosingController::setTarget(float target) {
+    this->target = target;
+}
+
+/**
+ * @brief Starts a new dose, clearing the flow-rate history.
+ */
+void DosingController::start() {
+    isStopped = false;
+    head = 0;
+    count = 0;
+}
+
+/**
+ * @brief Adds a weight reading and decides what the motor should do.
+ *
+ * The material in flight is the flow rate times the stop latency plus the learned correction. The dose stops once
+ * the reading plus the material in flight reaches the target, and trickles once the rest is within the trickle
+ * band. A stopped dose stays stopped. Only readings at least the history interval apart enter the flow-rate
+ * history; every reading is checked against the target.
+ *
+ * @param weight Current weight in grams.
+ * @param nowMs Time of the reading (millis).
+ * @return The phase the motor should run in.
+ */
+DosingPhase DosingController::update(float weight, unsigned long nowMs) {
+    if (isStopped) {
+        return DOSING_STOP;
+    }
+
+    if (count == 0 || nowMs - times[head] >= historyIntervalMs) {
+        head = (head + 1) % HISTORY_SIZE;
+        weights[head] = weight;
+        times[head] = nowMs;
+        if (count < HISTORY_SIZE) {
+            count++;
+        }
+    }
+
+    float flow = getFlowRate();
+    float inFlight = (flow > 0.0f ? flow * stopLatencyMs / 1000.0f : 0.0f) + correction;
+    float remaining = target - weight - inFlight;
+    if (remaining <= 0.0f) {
+        isStopped = true;
+        return DOSING_STOP;
+    }
+    return (remaining <= trickleBand) ? DOSING_TRICKLE : DOSING_FAST;
+}
+
+/**
+ * @brief Learns from the settled weight of the finished dose.
+ *
+ * A positive error (overshoot) raises the correction so the next dose stops earlier; an undershoot lowers it.
+ *
+ * @param settledWeight Weight once the material has stopped moving, in grams.
+ */
+void DosingController::finish(float settledWeight) {
+    correction += learningRate * (settledWeight - target);
+}
+
+/**
+ * @brief Returns the estimated flow rate.
+ *
+ * Least-squares slope of weight over time, with times taken relative to the oldest reading so the sums stay small.
+ *
+ * @return Grams per second over the last readings, 0 until there are two.
+ */
+float DosingController::getFlowRate() const {
+    if (count < 2) {
+        return 0.0f;
+    }
+
+    byte oldest = (head + HISTORY_SIZE - count + 1) % HISTORY_SIZE;
+    float sumT = 0.0f, sumW = 0.0f, sumTT = 0.0f, sumTW = 0.0f;
+    for (byte i = 0; i < count; i++) {
+        byte index = (oldest + i) % HISTORY_SIZE;
+        float t = (times[index] - times[oldest]) / 1000.0f;
+        sumT += t;
+        sumW += weights[index];
+        sumTT += t * t;
+        sumTW += t * weights[index];
+    }
+
+    float denominator = count * sumTT - sumT * sumT;
+    if (denominator <= 0.0f) {
+        return 0.0f;
+    }
+    return (count * sumTW - sumT * sumW) / denominator;
+}
+
+/**
+ * @brief Returns the learned correction.
+ *
+ * @return Grams added to the predicted in-flight material.
+ */
+float DosingController::getCorrection() const {
+    return correction;
+}
+
+/**
+ * @brief Sets the learned correction, e.g. from EEPROM.
+ *
+ * @param correction Grams added to the predicted in-flight material.
+ */
+void DosingController::setCorrection(float correction) {
+    this->correction = correction;
+}
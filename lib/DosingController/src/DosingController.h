@@ -0,0 +1,126 @@
+/**
+ * @file DosingController.h
+ * @brief Header file for the DosingController class.
+ *
+ * This file contains the declaration of the DosingController class, which decides when to stop filling a container
+ * to a target weight. It estimates the flow rate from the recent weight readings and stops early by the amount still
+ * in flight when the motor stops: the flow during the stop latency plus a correction learned from the overshoot of
+ * earlier batches. An optional trickle band lets the caller slow the motor down for the last grams.
+ */
+
+#ifndef DOSINGCONTROLLER_H
+#define DOSINGCONTROLLER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief What the motor should do after a weight reading.
+ */
+enum DosingPhase {
+    DOSING_FAST,     ///< Run at full speed
+    DOSING_TRICKLE,  ///< Run at the trickle speed
+    DOSING_STOP      ///< Stop; the target will be reached by what is in flight
+};
+
+/**
+ * @class DosingController
+ * @brief Predictive cutoff for filling to a target weight.
+ *
+ * The flow rate is the least-squares slope of the last HISTORY_SIZE readings. After a dose has settled, finish()
+ * compares the settled weight with the target and moves the learned correction towards the overshoot, so the
+ * cutoff improves from batch to batch.
+ */
+class DosingController {
+public:
+    static const byte HISTORY_SIZE = 8;  ///< Readings used for the flow-rate estimate
+    static const unsigned int DEFAULT_HISTORY_INTERVAL = 100;  ///< Least time between history readings (ms)
+
+    /**
+     * @brief Construct a new DosingController object with no stop latency, no trickle band and no correction.
+     */
+    DosingController();
+
+    /**
+     * @brief Sets how the dose is cut off.
+     *
+     * @param stopLatencyMs Time from the stop decision until material stops landing on the scale (ms).
+     * @param trickleBand Remaining grams below which the motor runs at the trickle speed, 0 for no trickle.
+     * @param learningRate Fraction of each batch's error added to the learned correction (0 to 1).
+     */
+    void configure(unsigned long stopLatencyMs, float trickleBand, float learningRate);
+
+    /**
+     * @brief Sets the least time between readings kept for the flow rate.
+     *
+     * Readings closer together still drive the stop decision but do not enter the history, so the flow rate spans
+     * the same time whatever the scale's sample rate.
+     *
+     * @param intervalMs Least time between history readings (ms), 0 to keep every reading.
+     */
+    void setHistoryInterval(unsigned int intervalMs);
+
+    /**
+     * @brief Sets the weight each dose fills to.
+     *
+     * @param target Weight to reach, in grams.
+     */
+    void setTarget(float target);
+
+    /**
+     * @brief Starts a new dose, clearing the flow-rate history.
+     */
+    void start();
+
+    /**
+     * @brief Adds a weight reading and decides what the motor should do.
+     *
+     * @param weight Current weight in grams.
+     * @param nowMs Time of the reading (millis).
+     * @return The phase the motor should run in.
+     */
+    DosingPhase update(float weight, unsigned long nowMs);
+
+    /**
+     * @brief Learns from the settled weight of the finished dose.
+     *
+     * @param settledWeight Weight once the material has stopped moving, in grams.
+     */
+    void finish(float settledWeight);
+
+    /**
+     * @brief Returns the estimated flow rate.
+     *
+     * @return Grams per second over the last readings, 0 until there are two.
+     */
+    float getFlowRate() const;
+
+    /**
+     * @brief Returns the learned correction.
+     *
+     * @return Grams added to the predicted in-flight material.
+     */
+    float getCorrection() const;
+
+    /**
+     * @brief Sets the learned correction, e.g. from EEPROM.
+     *
+     * @param correction Grams added to the predicted in-flight material.
+     */
+    void setCorrection(float correction);
+
+private:
+    unsigned long stopLatencyMs;         ///< Time until material stops landing after the stop (ms)
+    float trickleBand;                   ///< Remaining grams that are filled at the trickle speed
+    float learningRate;                  ///< Fraction of the error learned per batch
+    unsigned int historyIntervalMs;      ///< Least time between history readings (ms)
+    float correction;                    ///< Learned extra in-flight material (g)
+
+    float target;                        ///< Weight to reach (g)
+    bool isStopped;                      ///< Whether the dose has been cut off
+    float weights[HISTORY_SIZE];         ///< Recent readings (g)
+    unsigned long times[HISTORY_SIZE];   ///< Times of the recent readings (millis)
+    byte head;                           ///< Index of the most recent reading
+    byte count;                          ///< Number of readings in the history
+};
+
+#endif  // DOSINGCONTROLLER_H
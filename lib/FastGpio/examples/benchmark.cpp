@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include "FastGpio.h"
+
+// Measures the cost of one step pulse (pin HIGH then LOW) and of one limit switch read with digitalWrite() and
+// digitalRead() against GpioPin, which is what StepperController and LimitSwitch use on every step.
+// On the Mega the cycles are counted with Timer5 running at the CPU clock; on a host build the
+// time per pulse is measured with micros() instead.
+
+const byte benchmarkPin = 52;  // Slider pulse pin (PB1)
+const unsigned int pulses = 200;
+
+GpioPin gpioPin(benchmarkPin);
+
+#if defined(__AVR__)
+void startCounter() {
+    TCCR5A = 0;
+    TCCR5B = _BV(CS50);  // clk/1: one count per CPU cycle
+    TCNT5 = 0;
+}
+
+unsigned long readCounter() {
+    return TCNT5;
+}
+#else
+unsigned long counterStart = 0;
+
+void startCounter() {
+    counterStart = micros();
+}
+
+unsigned long readCounter() {
+    return micros() - counterStart;
+}
+#endif
+
+void report(const char* label, unsigned long count) {
+    Serial.print(label);
+    Serial.print(count / pulses);
+    Serial.print('.');
+    Serial.print((count % pulses) * 100 / pulses);
+#if defined(__AVR__)
+    Serial.println(" cycles per step");
+#else
+    Serial.println(" us per step");
+#endif
+}
+
+void setup() {
+    Serial.begin(9600);
+    pinMode(benchmarkPin, OUTPUT);
+    Serial.println("FastGpio step pulse benchmark");
+
+    noInterrupts();  // Keep the timer interrupt out of the measurement
+    startCounter();
+    for (unsigned int i = 0; i < pulses; i++) {
+        digitalWrite(benchmarkPin, HIGH);
+        digitalWrite(benchmarkPin, LOW);
+    }
+    unsigned long digitalWriteCount = readCounter();
+
+    startCounter();
+    for (unsigned int i = 0; i < pulses; i++) {
+        gpioPin.high();
+        gpioPin.low();
+    }
+    unsigned long gpioPinCount = readCounter();
+
+    volatile bool level = false;  // Keeps the reads from being optimized away
+    startCounter();
+    for (unsigned int i = 0; i < pulses; i++) {
+        level = digitalRead(benchmarkPin) == HIGH;
+    }
+    unsigned long digitalReadCount = readCounter();
+
+    startCounter();
+    for (unsigned int i = 0; i < pulses; i++) {
+        level = gpioPin.read();
+    }
+    unsigned long gpioReadCount = readCounter();
+    interrupts();
+    (void)level;
+
+    report("digitalWrite: ", digitalWriteCount);
+    report("GpioPin:      ", gpioPinCount);
+    report("digitalRead:  ", digitalReadCount);
+    report("GpioPin read: ", gpioReadCount);
+}
+
+void loop() {
+    // Benchmark runs once in setup()
+}
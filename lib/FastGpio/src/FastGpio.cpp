@@ -0,0 +1,17 @@
+#include "FastGpio.h"
+
+/**
+ * @brief Construct a new GpioPin object.
+ *
+ * Looks the pin up in the core's PROGMEM tables once, so later reads and writes go straight to the port registers.
+ *
+ * @param pin The Arduino pin number.
+ */
+GpioPin::GpioPin(byte pin) : pin(pin) {
+#if defined(__AVR__)
+    uint8_t port = digitalPinToPort(pin);
+    this->outputRegister = portOutputRegister(port);
+    this->inputRegister = portInputRegister(port);
+    this->bitMask = digitalPinToBitMask(pin);
+#endif
+}
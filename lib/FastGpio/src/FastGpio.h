@@ -0,0 +1,105 @@
+/**
+ * @file FastGpio.h
+ * @brief Direct port register access for digital pins.
+ *
+ * Arduino's digitalWrite() and digitalRead() look the pin up in three PROGMEM tables, check for a PWM timer and
+ * save/restore the interrupt flag on every call. GpioPin resolves the port register and bit mask once, when it is
+ * constructed, so the step pulses and limit switch reads of a move are a single port access each. The pins are
+ * passed to the StepperController and LimitSwitch constructors, so they are looked up at run time rather than
+ * fixed by template parameters.
+ *
+ * On any other target (host builds) GpioPin falls back to digitalWrite()/digitalRead().
+ */
+
+#ifndef FASTGPIO_H
+#define FASTGPIO_H
+
+#include <Arduino.h>
+
+/**
+ * @class GpioPin
+ * @brief A digital pin whose port register is resolved once, at construction.
+ *
+ * Writes save and restore the interrupt flag around the read-modify-write of the port, so they are safe both from
+ * the main loop and from interrupts.
+ */
+class GpioPin {
+public:
+    /**
+     * @brief Construct a new GpioPin object.
+     *
+     * @param pin The Arduino pin number.
+     */
+    explicit GpioPin(byte pin);
+
+    /**
+     * @brief Returns the Arduino pin number.
+     *
+     * @return The pin number passed to the constructor.
+     */
+    byte number() const { return pin; }
+
+    /**
+     * @brief Drives the pin HIGH.
+     */
+    void high() {
+#if defined(__AVR__)
+        uint8_t oldSREG = SREG;
+        cli();
+        *outputRegister |= bitMask;
+        SREG = oldSREG;
+#else
+        digitalWrite(pin, HIGH);
+#endif
+    }
+
+    /**
+     * @brief Drives the pin LOW.
+     */
+    void low() {
+#if defined(__AVR__)
+        uint8_t oldSREG = SREG;
+        cli();
+        *outputRegister &= ~bitMask;
+        SREG = oldSREG;
+#else
+        digitalWrite(pin, LOW);
+#endif
+    }
+
+    /**
+     * @brief Drives the pin HIGH or LOW.
+     *
+     * @param isHigh true for HIGH, false for LOW.
+     */
+    void write(bool isHigh) {
+        if (isHigh) {
+            high();
+        } else {
+            low();
+        }
+    }
+
+    /**
+     * @brief Reads the pin.
+     *
+     * @return true if the pin reads HIGH.
+     */
+    bool read() const {
+#if defined(__AVR__)
+        return (*inputRegister & bitMask) != 0;
+#else
+        return digitalRead(pin) == HIGH;
+#endif
+    }
+
+private:
+    byte pin;                          ///< Arduino pin number
+#if defined(__AVR__)
+    volatile uint8_t* outputRegister;  ///< PORTx register of the pin
+    volatile uint8_t* inputRegister;   ///< PINx register of the pin
+    uint8_t bitMask;                   ///< Bit of the pin within its port
+#endif
+};
+
+#endif  // FASTGPIO_H
@@ -0,0 +1,162 @@
+#include "LcdFrameBuffer.h"
+
+/**
+ * @brief Construct a new LcdFrameBuffer object.
+ *
+ * @param lcd The display the buffer is drawn on.
+ */
+LcdFrameBuffer::LcdFrameBuffer(LiquidCrystal_I2C& lcd) : lcd(lcd) {
+    this->cursorRow = 0;
+    this->cursorCol = COLS;
+    this->bytesSent = 0;
+    memset(this->wanted, ' ', sizeof(this->wanted));
+    memset(this->shown, ' ', sizeof(this->shown));
+}
+
+/**
+ * @brief Marks the display as blank and empties the buffer.
+ */
+void LcdFrameBuffer::begin() {
+    memset(shown, ' ', sizeof(shown));
+    clear();
+    cursorRow = 0;
+    cursorCol = 0;
+    bytesSent = 0;
+}
+
+/**
+ * @brief Fills the buffer with spaces.
+ */
+void LcdFrameBuffer::clear() {
+    memset(wanted, ' ', sizeof(wanted));
+}
+
+/**
+ * @brief Writes text into the buffer.
+ *
+ * @param row Line, 0 or 1.
+ * @param col First column, 0 to COLS - 1.
+ * @param text Text to write.
+ */
+void LcdFrameBuffer::print(byte row, byte col, const char* text) {
+    if (row >= ROWS) {
+        return;
+    }
+    while (col < COLS && *text != '\0') {
+        wanted[row][col++] = *text++;
+    }
+}
+
+/**
+ * @brief Writes text from flash into the buffer, e.g. F("READY").
+ *
+ * @param row Line, 0 or 1.
+ * @param col First column, 0 to COLS - 1.
+ * @param text Text to write.
+ */
+void LcdFrameBuffer::print(byte row, byte col, const __FlashStringHelper* text) {
+    if (row >= ROWS) {
+        return;
+    }
+    PGM_P p = reinterpret_cast<PGM_P>(text);
+    char c;
+    while (col < COLS && (c = pgm_read_byte(p++)) != '\0') {
+        wanted[row][col++] = c;
+    }
+}
+
+/**
+ * @brief Replaces a line of the buffer with text centered on it.
+ *
+ * @param row Line, 0 or 1.
+ * @param text Text to center; longer text is cut at COLS characters.
+ */
+void LcdFrameBuffer::printCentered(byte row, const char* text) {
+    if (row >= ROWS) {
+        return;
+    }
+    size_t length = strlen(text);
+    memset(wanted[row], ' ', COLS);
+    print(row, length < COLS ? (COLS - length) / 2 : 0, text);
+}
+
+/**
+ * @brief Replaces a line of the buffer with text from flash centered on it.
+ *
+ * @param row Line, 0 or 1.
+ * @param text Text to center; longer text is cut at COLS characters.
+ */
+void LcdFrameBuffer::printCentered(byte row, const __FlashStringHelper* text) {
+    char line[COLS + 1];
+    strncpy_P(line, reinterpret_cast<PGM_P>(text), COLS);
+    line[COLS] = '\0';
+    printCentered(row, line);
+}
+
+/**
+ * @brief Sends the changed characters to the display.
+ *
+ * Unchanged characters are skipped; the cursor is only moved when the next changed character is not where the
+ * display's cursor already is. A cursor move and its character are always sent together.
+ *
+ * @param maxBytes Most commands and characters to send in this call; the rest waits for the next call.
+ * @return true if anything was sent.
+ */
+bool LcdFrameBuffer::flush(unsigned int maxBytes) {
+    bool isSent = false;
+    unsigned long limit = bytesSent + maxBytes;
+    for (byte row = 0; row < ROWS; row++) {
+        for (byte col = 0; col < COLS; col++) {
+            if (wanted[row][col] == shown[row][col]) {
+                continue;
+            }
+            bool isCursorHere = (cursorRow == row && cursorCol == col);
+            if (bytesSent + (isCursorHere ? 1 : 2) > limit) {
+                return isSent;
+            }
+            moveCursor(row, col);
+            lcd.write(wanted[row][col]);
+            shown[row][col] = wanted[row][col];
+            cursorCol++;
+            bytesSent++;
+            isSent = true;
+        }
+    }
+    return isSent;
+}
+
+/**
+ * @brief Checks whether the buffer differs from the display.
+ *
+ * @return true if flush() has something to send.
+ */
+bool LcdFrameBuffer::isDirty() const {
+    return memcmp(wanted, shown, sizeof(wanted)) != 0;
+}
+
+/**
+ * @brief Returns the number of commands and characters sent to the display.
+ *
+ * @return The number of bytes sent since begin().
+ */
+unsigned long LcdFrameBuffer::getBytesSent() const {
+    return bytesSent;
+}
+
+/**
+ * @brief Moves the display cursor unless it is already at the position.
+ *
+ * After the last column the display cursor runs on into memory that is not shown, so it counts as unknown there.
+ *
+ * @param row Line of the position.
+ * @param col Column of the position.
+ */
+void LcdFrameBuffer::moveCursor(byte row, byte col) {
+    if (cursorRow == row && cursorCol == col) {
+        return;
+    }
+    lcd.setCursor(col, row);
+    cursorRow = row;
+    cursorCol = col;
+    bytesSent++;
+}
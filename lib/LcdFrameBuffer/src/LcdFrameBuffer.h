@@ -0,0 +1,131 @@
+/**
+ * @file LcdFrameBuffer.h
+ * @brief Header file for the LcdFrameBuffer class.
+ *
+ * This file contains the declaration of the LcdFrameBuffer class, a shadow copy of a 16x2 character LCD. Text is
+ * written into the buffer, and flush() sends only the characters that differ from what the display already shows,
+ * so a message that changes one digit costs one cursor move and one character instead of a clear and 32 characters.
+ *
+ * Each byte sent to an I2C backpack blocks on the Wire transfers, so flush() can be limited to a few bytes per call.
+ * Called from a periodic task, the buffer then works as a write queue: writing text never touches the bus, and the
+ * display catches up in slices short enough not to hold up the other tasks.
+ */
+
+#ifndef LCDFRAMEBUFFER_H
+#define LCDFRAMEBUFFER_H
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+/**
+ * @class LcdFrameBuffer
+ * @brief 16x2 framebuffer that updates an HD44780 LCD by sending only the changed characters.
+ *
+ * Two copies of the screen are kept: the text wanted on the display and the text last sent to it. The display's
+ * cursor advances by itself after each character, so a run of changed characters needs a single setCursor().
+ */
+class LcdFrameBuffer {
+public:
+    static const byte COLS = 16;  ///< Characters per line
+    static const byte ROWS = 2;   ///< Number of lines
+
+    /**
+     * @brief Construct a new LcdFrameBuffer object.
+     *
+     * @param lcd The display the buffer is drawn on.
+     */
+    LcdFrameBuffer(LiquidCrystal_I2C& lcd);
+
+    /**
+     * @brief Marks the display as blank and empties the buffer.
+     *
+     * Call it after lcd.init(), which clears the display.
+     */
+    void begin();
+
+    /**
+     * @brief Fills the buffer with spaces.
+     */
+    void clear();
+
+    /**
+     * @brief Writes text into the buffer.
+     *
+     * Text past the end of the line is dropped.
+     *
+     * @param row Line, 0 or 1.
+     * @param col First column, 0 to COLS - 1.
+     * @param text Text to write.
+     */
+    void print(byte row, byte col, const char* text);
+
+    /**
+     * @brief Writes text from flash into the buffer, e.g. F("READY").
+     *
+     * @param row Line, 0 or 1.
+     * @param col First column, 0 to COLS - 1.
+     * @param text Text to write.
+     */
+    void print(byte row, byte col, const __FlashStringHelper* text);
+
+    /**
+     * @brief Replaces a line of the buffer with text centered on it.
+     *
+     * @param row Line, 0 or 1.
+     * @param text Text to center; longer text is cut at COLS characters.
+     */
+    void printCentered(byte row, const char* text);
+
+    /**
+     * @brief Replaces a line of the buffer with text from flash centered on it.
+     *
+     * @param row Line, 0 or 1.
+     * @param text Text to center; longer text is cut at COLS characters.
+     */
+    void printCentered(byte row, const __FlashStringHelper* text);
+
+    /**
+     * @brief Sends the changed characters to the display.
+     *
+     * Later changes to the buffer replace characters that have not been sent yet, so a slow display always catches
+     * up to the latest text rather than replaying every message.
+     *
+     * @param maxBytes Most commands and characters to send in this call; the rest waits for the next call.
+     * @return true if anything was sent.
+     */
+    bool flush(unsigned int maxBytes = 0xFFFF);
+
+    /**
+     * @brief Checks whether the buffer differs from the display.
+     *
+     * @return true if flush() has something to send.
+     */
+    bool isDirty() const;
+
+    /**
+     * @brief Returns the number of commands and characters sent to the display.
+     *
+     * Each one is a byte for the HD44780, sent over I2C as two nibbles.
+     *
+     * @return The number of bytes sent since begin().
+     */
+    unsigned long getBytesSent() const;
+
+private:
+    /**
+     * @brief Moves the display cursor unless it is already at the position.
+     *
+     * @param row Line of the position.
+     * @param col Column of the position.
+     */
+    void moveCursor(byte row, byte col);
+
+    LiquidCrystal_I2C& lcd;       ///< Display the buffer is drawn on
+    char wanted[ROWS][COLS];      ///< Text to show
+    char shown[ROWS][COLS];       ///< Text last sent to the display
+    byte cursorRow;               ///< Line of the display cursor
+    byte cursorCol;               ///< Column of the display cursor, COLS if unknown
+    unsigned long bytesSent;      ///< Commands and characters sent since begin()
+};
+
+#endif  // LCDFRAMEBUFFER_H
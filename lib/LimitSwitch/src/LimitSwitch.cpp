@@ -1,5 +1,8 @@
 #include "LimitSwitch.h"
 
+LimitSwitch* LimitSwitch::switches[LimitSwitch::MAX_SWITCHES] = { nullptr };
+byte LimitSwitch::switchCount = 0;
+
 /**
  * @brief Construct a new LimitSwitch object.
  *
@@ -7,8 +10,22 @@
  *
  * @param pinNumber The pin to which the limit switch is connected.
  */
-LimitSwitch::LimitSwitch(byte pinNumber) : pin(pinNumber) {
+LimitSwitch::LimitSwitch(byte pinNumber) : pin(pinNumber), input(pinNumber) {
     pinMode(pin, INPUT);  // Set the pin as input
+    debounceMs = DEFAULT_DEBOUNCE_MS;
+    longPressMs = DEFAULT_LONG_PRESS_MS;
+    rawState = false;
+    stableState = false;
+    rawChangedAt = 0;
+    pressedAt = 0;
+    pressEvent = false;
+    releaseEvent = false;
+    longPressEvent = false;
+    isLongPressReported = false;
+    isInterruptEnabled = false;
+    isLatchSet = false;
+    triggerHandler = nullptr;
+    triggerContext = nullptr;
 }
 
 /**
@@ -16,21 +33,38 @@ LimitSwitch::LimitSwitch(byte pinNumber) : pin(pinNumber) {
  *
  * This function configures the pin mode for the limit switch.
  * It ensures that the pin is set to input mode to properly read the state of the switch.
+ * The switch is also registered so updateAll() samples it; the current level is taken as the
+ * initial debounced state, so a switch that is already closed does not report a press.
  */
 void LimitSwitch::init() {
     pinMode(pin, INPUT);
+
+    rawState = input.read();
+    stableState = rawState;
+    rawChangedAt = millis();
+    pressedAt = rawChangedAt;
+    isLongPressReported = stableState;
+
+    for (byte i = 0; i < switchCount; i++) {
+        if (switches[i] == this) {
+            return;
+        }
+    }
+    if (switchCount < MAX_SWITCHES) {
+        switches[switchCount++] = this;
+    }
 }
 
 /**
  * @brief Checks if the limit switch is triggered.
  *
- * This function reads the state of the pin. If the pin is HIGH, it indicates that the limit switch
- * has been triggered.
+ * This function reads the state of the pin directly from its port register. If the pin is HIGH, it indicates
+ * that the limit switch has been triggered.
  *
  * @return true if the limit switch is triggered, false otherwise.
  */
 bool LimitSwitch::isTriggered() {
-    return digitalRead(pin) == HIGH;  // Return true if the switch is triggered (HIGH)
+    return input.read();  // Return true if the switch is triggered (HIGH)
 }
 
 /**
@@ -44,3 +78,201 @@ bool LimitSwitch::isTriggered() {
 bool LimitSwitch::isPressed() {
     return digitalRead(pin) == HIGH;  // Return true if the switch is triggered (HIGH)
 }
+
+/**
+ * @brief Sets how long the input must be stable before a press or release is accepted.
+ *
+ * @param ms Debounce time in milliseconds.
+ */
+void LimitSwitch::setDebounceTime(uint16_t ms) {
+    debounceMs = ms;
+}
+
+/**
+ * @brief Sets how long the switch must be held for a long press.
+ *
+ * @param ms Long-press time in milliseconds.
+ */
+void LimitSwitch::setLongPressTime(uint16_t ms) {
+    longPressMs = ms;
+}
+
+/**
+ * @brief Takes one sample of the input and updates the debounced state and events.
+ *
+ * The debounced state only follows the input once it has kept the same level for the debounce time, so
+ * contact bounce never produces extra edges. A long press is reported once per hold.
+ *
+ * @param nowMs The current time in milliseconds.
+ */
+void LimitSwitch::update(unsigned long nowMs) {
+    bool sample = input.read();
+    if (sample != rawState) {
+        rawState = sample;
+        rawChangedAt = nowMs;
+    }
+
+    if (rawState != stableState && nowMs - rawChangedAt >= debounceMs) {
+        stableState = rawState;
+        if (stableState) {
+            pressEvent = true;
+            pressedAt = nowMs;
+            isLongPressReported = false;
+        } else {
+            releaseEvent = true;
+        }
+    }
+
+    if (stableState && !isLongPressReported && nowMs - pressedAt >= longPressMs) {
+        longPressEvent = true;
+        isLongPressReported = true;
+    }
+}
+
+/**
+ * @brief Samples every initialized switch.
+ */
+void LimitSwitch::updateAll() {
+    unsigned long nowMs = millis();
+    for (byte i = 0; i < switchCount; i++) {
+        switches[i]->update(nowMs);
+    }
+}
+
+/**
+ * @brief Checks the debounced state.
+ *
+ * @return true while the switch is held, after debouncing.
+ */
+bool LimitSwitch::isHeld() const {
+    return stableState;
+}
+
+/**
+ * @brief Reports a press once.
+ *
+ * @return true if the switch was pressed since the last call.
+ */
+bool LimitSwitch::wasPressed() {
+    bool event = pressEvent;
+    pressEvent = false;
+    return event;
+}
+
+/**
+ * @brief Reports a release once.
+ *
+ * @return true if the switch was released since the last call.
+ */
+bool LimitSwitch::wasReleased() {
+    bool event = releaseEvent;
+    releaseEvent = false;
+    return event;
+}
+
+/**
+ * @brief Reports a long press once per hold.
+ *
+ * @return true if the switch has been held for the long-press time since the last call.
+ */
+bool LimitSwitch::wasLongPressed() {
+    bool event = longPressEvent;
+    longPressEvent = false;
+    return event;
+}
+
+/**
+ * @brief Backs the switch with a pin interrupt that latches the trigger.
+ *
+ * External interrupts are attached on the rising edge. Pins without one fall back to their pin-change
+ * interrupt group, if this library defines that group's vector; both end up in handlePinChange(), which reads
+ * every interrupt-backed switch. A group without the vector is never enabled, since its interrupt would reset the
+ * board.
+ *
+ * @return true if the pin has an interrupt, false if the switch can only be polled.
+ */
+bool LimitSwitch::enableInterrupt() {
+    int externalInterrupt = digitalPinToInterrupt(pin);
+    if (externalInterrupt != NOT_AN_INTERRUPT) {
+        isInterruptEnabled = true;
+        attachInterrupt(externalInterrupt, handlePinChange, RISING);
+        return true;
+    }
+
+#if defined(__AVR__) && defined(PCICR)
+    const byte enabledGroups = (LIMITSWITCH_USE_PCINT0 ? 0x01 : 0) | (LIMITSWITCH_USE_PCINT1 ? 0x02 : 0)
+        | (LIMITSWITCH_USE_PCINT2 ? 0x04 : 0);
+    volatile uint8_t* pcicr = digitalPinToPCICR(pin);
+    if (pcicr != nullptr && (enabledGroups & _BV(digitalPinToPCICRbit(pin))) != 0) {
+        isInterruptEnabled = true;
+        *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+        *pcicr |= _BV(digitalPinToPCICRbit(pin));
+        return true;
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief Checks whether the pin interrupt has seen the switch close since the latch was last cleared.
+ *
+ * @return true if the trigger is latched.
+ */
+bool LimitSwitch::isLatched() const {
+    return isLatchSet;
+}
+
+/**
+ * @brief Clears the latched trigger.
+ */
+void LimitSwitch::clearLatch() {
+    isLatchSet = false;
+}
+
+/**
+ * @brief Sets the function the pin interrupt calls when the switch closes.
+ *
+ * @param handler Function to call in interrupt context, or nullptr for none.
+ * @param context Argument passed to the handler.
+ */
+void LimitSwitch::setTriggerHandler(void (*handler)(void*), void* context) {
+    noInterrupts();
+    triggerHandler = handler;
+    triggerContext = context;
+    interrupts();
+}
+
+/**
+ * @brief Checks every interrupt-backed switch and latches the ones that closed.
+ */
+void LimitSwitch::handlePinChange() {
+    for (byte i = 0; i < switchCount; i++) {
+        LimitSwitch* limitSwitch = switches[i];
+        if (!limitSwitch->isInterruptEnabled || limitSwitch->isLatchSet || !limitSwitch->input.read()) {
+            continue;
+        }
+        limitSwitch->isLatchSet = true;
+        void (*handler)(void*) = limitSwitch->triggerHandler;
+        if (handler != nullptr) {
+            handler(limitSwitch->triggerContext);
+        }
+    }
+}
+
+#if defined(__AVR__) && defined(PCICR)
+#if LIMITSWITCH_USE_PCINT0 && defined(PCINT0_vect)
+ISR(PCINT0_vect) {
+    LimitSwitch::handlePinChange();
+}
+#endif
+#if LIMITSWITCH_USE_PCINT1 && defined(PCINT1_vect)
+ISR(PCINT1_vect) {
+    LimitSwitch::handlePinChange();
+}
+#endif
+#if LIMITSWITCH_USE_PCINT2 && defined(PCINT2_vect)
+ISR(PCINT2_vect) {
+    LimitSwitch::handlePinChange();
+}
+#endif
+#endif
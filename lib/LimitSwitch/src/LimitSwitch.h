@@ -2,16 +2,62 @@
 #define LIMITSWITCH_H
 
 #include <Arduino.h>
+#include "FastGpio.h"
+
+// Pin-change interrupt groups whose vectors this library defines (PCINT0_vect, PCINT1_vect, PCINT2_vect). A group
+// left at 0 stays free for SoftwareSerial or another pin-change user, and switches on it are polled. Enable the
+// groups that carry switch pins with a build flag, e.g. -DLIMITSWITCH_USE_PCINT0=1.
+#ifndef LIMITSWITCH_USE_PCINT0
+#define LIMITSWITCH_USE_PCINT0 0  ///< Whether switches on pin-change group 0 are latched by its interrupt
+#endif
+#ifndef LIMITSWITCH_USE_PCINT1
+#define LIMITSWITCH_USE_PCINT1 0  ///< Whether switches on pin-change group 1 are latched by its interrupt
+#endif
+#ifndef LIMITSWITCH_USE_PCINT2
+#define LIMITSWITCH_USE_PCINT2 0  ///< Whether switches on pin-change group 2 are latched by its interrupt
+#endif
 
 /**
  * @brief A class to manage the functionality of a limit switch.
  *
  * This class is designed to read the status of a limit switch connected to a specified pin.
  * The switch can be checked to see if it has been triggered (i.e., if the pin is HIGH).
+ *
+ * Switches used as buttons are also debounced: every initialized switch is sampled by updateAll(), called from
+ * a periodic tick, and reports press, release and long-press events once each.
+ *
+ * A limit switch can also be backed by an external or pin-change interrupt (enableInterrupt()). The interrupt
+ * latches the trigger and calls the handler of the stepper moving towards it, which stops the step generation
+ * right away instead of at the next step.
  */
 class LimitSwitch {
+public:
+    static const byte MAX_SWITCHES = 10;                ///< Maximum number of switches sampled by updateAll()
+    static const uint16_t DEFAULT_DEBOUNCE_MS = 30;     ///< Default time the input must be stable
+    static const uint16_t DEFAULT_LONG_PRESS_MS = 2000; ///< Default hold time for a long press
+
 private:
     const byte pin; ///< The pin the limit switch is connected to
+    GpioPin input;  ///< Direct port access to the pin, read on every step of a limit move
+
+    uint16_t debounceMs;        ///< Time the raw input must be stable before the state changes
+    uint16_t longPressMs;       ///< Hold time after which a long press is reported
+    bool rawState;              ///< Last raw sample
+    bool stableState;           ///< Debounced state (true = pressed)
+    unsigned long rawChangedAt; ///< Time of the last raw change (ms)
+    unsigned long pressedAt;    ///< Time the debounced state became pressed (ms)
+    bool pressEvent;            ///< Unread press edge
+    bool releaseEvent;          ///< Unread release edge
+    bool longPressEvent;        ///< Unread long press
+    bool isLongPressReported;   ///< Whether the current hold has already been reported as a long press
+
+    bool isInterruptEnabled;             ///< Whether a pin interrupt latches this switch
+    volatile bool isLatchSet;            ///< Set by the pin interrupt when the switch closes
+    void (* volatile triggerHandler)(void*); ///< Called from the pin interrupt when the switch closes
+    void* volatile triggerContext;       ///< Argument passed to triggerHandler
+
+    static LimitSwitch* switches[MAX_SWITCHES]; ///< Switches sampled by updateAll()
+    static byte switchCount;                    ///< Number of registered switches
 
 public:
     /**
@@ -26,7 +72,8 @@ public:
     /**
      * @brief Initializes the limit switch pin as input.
      *
-     * This function sets up the pin as an input for reading the limit switch state.
+     * This function sets up the pin as an input for reading the limit switch state and registers the switch
+     * with updateAll().
      */
     void init();
 
@@ -50,6 +97,97 @@ public:
      * @return true if the limit switch is triggered, false otherwise.
      */
     bool isPressed();
+
+    /**
+     * @brief Sets how long the input must be stable before a press or release is accepted.
+     *
+     * @param ms Debounce time in milliseconds.
+     */
+    void setDebounceTime(uint16_t ms);
+
+    /**
+     * @brief Sets how long the switch must be held for a long press.
+     *
+     * @param ms Long-press time in milliseconds.
+     */
+    void setLongPressTime(uint16_t ms);
+
+    /**
+     * @brief Takes one sample of the input and updates the debounced state and events.
+     *
+     * @param nowMs The current time in milliseconds.
+     */
+    void update(unsigned long nowMs);
+
+    /**
+     * @brief Samples every initialized switch. Call this from a periodic tick (every few milliseconds).
+     */
+    static void updateAll();
+
+    /**
+     * @brief Checks the debounced state.
+     *
+     * @return true while the switch is held, after debouncing.
+     */
+    bool isHeld() const;
+
+    /**
+     * @brief Reports a press once.
+     *
+     * @return true if the switch was pressed since the last call.
+     */
+    bool wasPressed();
+
+    /**
+     * @brief Reports a release once.
+     *
+     * @return true if the switch was released since the last call.
+     */
+    bool wasReleased();
+
+    /**
+     * @brief Reports a long press once per hold.
+     *
+     * @return true if the switch has been held for the long-press time since the last call.
+     */
+    bool wasLongPressed();
+
+    /**
+     * @brief Backs the switch with a pin interrupt that latches the trigger.
+     *
+     * Uses the external interrupt of the pin if it has one, otherwise its pin-change interrupt if the group is
+     * enabled with LIMITSWITCH_USE_PCINTn. Call it after init().
+     *
+     * @return true if the pin has an interrupt, false if the switch can only be polled.
+     */
+    bool enableInterrupt();
+
+    /**
+     * @brief Checks whether the pin interrupt has seen the switch close since the latch was last cleared.
+     *
+     * @return true if the trigger is latched.
+     */
+    bool isLatched() const;
+
+    /**
+     * @brief Clears the latched trigger, e.g. before a new move towards the switch.
+     */
+    void clearLatch();
+
+    /**
+     * @brief Sets the function the pin interrupt calls when the switch closes.
+     *
+     * @param handler Function to call in interrupt context, or nullptr for none.
+     * @param context Argument passed to the handler.
+     */
+    void setTriggerHandler(void (*handler)(void*), void* context);
+
+    /**
+     * @brief Checks every interrupt-backed switch and latches the ones that closed.
+     *
+     * Called from the external interrupts and the pin-change vectors enabled with LIMITSWITCH_USE_PCINTn.
+     */
+    static void handlePinChange();
 };
 
 #endif // LIMITSWITCH_H
@@ -0,0 +1,286 @@
+#include "Logger.h"
+#include "TextBuffer.h"
+
+Logger logger(Serial);
+
+LogArg::LogArg() {
+    this->type = NONE;
+    this->decimals = 0;
+    this->number = 0;
+}
+
+LogArg::LogArg(int value) {
+    this->type = NUMBER;
+    this->decimals = 0;
+    this->number = value;
+}
+
+LogArg::LogArg(unsigned int value) {
+    this->type = NUMBER;
+    this->decimals = 0;
+    this->number = value;
+}
+
+LogArg::LogArg(long value) {
+    this->type = NUMBER;
+    this->decimals = 0;
+    this->number = value;
+}
+
+LogArg::LogArg(unsigned long value) {
+    this->type = NUMBER;
+    this->decimals = 0;
+    this->number = (long)value;
+}
+
+/**
+ * @brief Construct a LogArg for a number with decimals.
+ *
+ * @param value Number to log.
+ * @param decimals Digits after the decimal point.
+ */
+LogArg::LogArg(float value, byte decimals) {
+    this->type = REAL;
+    this->decimals = decimals;
+    this->real = value;
+}
+
+LogArg::LogArg(double value, byte decimals) {
+    this->type = REAL;
+    this->decimals = decimals;
+    this->real = (float)value;
+}
+
+LogArg::LogArg(const __FlashStringHelper* text) {
+    this->type = TEXT;
+    this->decimals = 0;
+    this->text = text;
+}
+
+/**
+ * @brief Construct a new Logger object.
+ *
+ * @param out Port the log is written to; its availableForWrite() decides how much is written per update().
+ */
+Logger::Logger(Print& out) : out(out) {
+    this->head = 0;
+    this->count = 0;
+    this->lineLength = 0;
+    this->linePosition = 0;
+    this->level = LOG_LEVEL;
+    this->isBlocking = false;
+    this->dropCount = 0;
+    this->unreportedDrops = 0;
+    this->entriesBeforeNote = 0;
+    this->reply = nullptr;
+    this->replyCursor = 0;
+}
+
+/**
+ * @brief Queues a message.
+ *
+ * @param level Level of the message; messages above the runtime level are ignored.
+ * @param message PROGMEM message; each '%' is replaced by the next value.
+ * @param first Value for the first '%'.
+ * @param second Value for the second '%'.
+ */
+void Logger::log(byte level, const __FlashStringHelper* message, const LogArg& first, const LogArg& second) {
+    if (level > this->level) {
+        return;
+    }
+    enqueue(message, first, second);
+}
+
+/**
+ * @brief Queues a message whatever the level, e.g. the reply to a console command.
+ *
+ * @param message PROGMEM message; each '%' is replaced by the next value.
+ * @param first Value for the first '%'.
+ * @param second Value for the second '%'.
+ */
+void Logger::print(const __FlashStringHelper* message, const LogArg& first, const LogArg& second) {
+    enqueue(message, first, second);
+}
+
+/**
+ * @brief Adds a message to the ring, or drops it if the ring is full and the logger is not blocking.
+ *
+ * Only the message address and the values are stored; formatting waits until the entry is written.
+ *
+ * @param message PROGMEM message.
+ * @param first Value for the first '%'.
+ * @param second Value for the second '%'.
+ */
+void Logger::enqueue(const __FlashStringHelper* message, const LogArg& first, const LogArg& second) {
+    if (count >= QUEUE_SIZE && isBlocking) {
+        while (count >= QUEUE_SIZE) {
+            update();
+        }
+    }
+    if (count >= QUEUE_SIZE) {
+        if (unreportedDrops == 0) {
+            entriesBeforeNote = count;
+        }
+        dropCount++;
+        unreportedDrops++;
+        return;
+    }
+
+    Entry& entry = entries[(head + count) % QUEUE_SIZE];
+    entry.message = message;
+    entry.args[0] = first;
+    entry.args[1] = second;
+    count++;
+}
+
+/**
+ * @brief Starts sending a reply of many lines, one line per update() while nothing else is queued.
+ *
+ * @param source Formats the reply line by line.
+ * @return true if the reply was started, false if another reply is still being sent.
+ */
+bool Logger::startReply(ReplySource source) {
+    if (reply != nullptr) {
+        return false;
+    }
+    reply = source;
+    replyCursor = 0;
+    return true;
+}
+
+/**
+ * @brief Checks whether a reply started with startReply() is still being sent.
+ *
+ * @return true until the reply source has no more lines.
+ */
+bool Logger::isReplying() const {
+    return reply != nullptr;
+}
+
+/**
+ * @brief Writes queued text as far as the port has room, without waiting.
+ *
+ * A line is formatted once and written over as many calls as the TX buffer needs. At most one reply line is
+ * formatted per call, so a long reply costs each run no more than one line of formatting.
+ */
+void Logger::update() {
+    bool isReplyAllowed = true;
+    while (true) {
+        if (linePosition >= lineLength) {
+            if (!formatNext(isReplyAllowed)) {
+                return;
+            }
+            isReplyAllowed = false;
+        }
+
+        int room = out.availableForWrite();
+        if (room <= 0) {
+            return;
+        }
+        byte length = min((int)(lineLength - linePosition), room);
+        out.write((const uint8_t*)line + linePosition, length);
+        linePosition += length;
+    }
+}
+
+/**
+ * @brief Writes everything queued, and the rest of any reply, waiting for the port as needed.
+ */
+void Logger::flush() {
+    while (count > 0 || unreportedDrops > 0 || linePosition < lineLength || reply != nullptr) {
+        update();
+    }
+}
+
+/**
+ * @brief Sets the most detailed level that is logged.
+ *
+ * @param level One of the LOG_LEVEL_ values.
+ */
+void Logger::setLevel(byte level) {
+    this->level = level;
+}
+
+/**
+ * @brief Returns the most detailed level that is logged.
+ *
+ * @return One of the LOG_LEVEL_ values.
+ */
+byte Logger::getLevel() const {
+    return level;
+}
+
+/**
+ * @brief Sets what happens to a message when the queue is full.
+ *
+ * @param isBlocking If true, the oldest entries are written out to make room; if false, the message is dropped.
+ */
+void Logger::setBlocking(bool isBlocking) {
+    this->isBlocking = isBlocking;
+}
+
+/**
+ * @brief Returns the number of messages dropped because the queue was full.
+ *
+ * @return Messages dropped since start-up.
+ */
+unsigned long Logger::getDropCount() const {
+    return dropCount;
+}
+
+/**
+ * @brief Formats the oldest entry, a note about dropped messages, or the next reply line into the line buffer.
+ *
+ * The note follows the entries that were queued when the first message was dropped, so it marks the place in the
+ * log where messages are missing. Reply lines only fill the gaps between queued entries.
+ *
+ * @param isReplyAllowed Whether a reply line may be formatted when nothing is queued.
+ * @return true if there was something to format.
+ */
+bool Logger::formatNext(bool isReplyAllowed) {
+    TextBuffer text(line, LINE_SIZE - 1);  // Leaves room for the line end
+    if (unreportedDrops > 0 && entriesBeforeNote == 0) {
+        text.append(F("[WARN] ")).appendInt(unreportedDrops).append(F(" log messages dropped"));
+        unreportedDrops = 0;
+    } else if (count > 0) {
+        const Entry& entry = entries[head];
+        PGM_P p = reinterpret_cast<PGM_P>(entry.message);
+        byte argIndex = 0;
+        char c;
+        while ((c = pgm_read_byte(p++)) != '\0') {
+            if (c != '%' || argIndex >= MAX_ARGS) {
+                text.append(c);
+                continue;
+            }
+            const LogArg& arg = entry.args[argIndex++];
+            if (arg.type == LogArg::NUMBER) {
+                text.appendInt(arg.number);
+            } else if (arg.type == LogArg::REAL) {
+                text.appendFloat(arg.real, arg.decimals);
+            } else if (arg.type == LogArg::TEXT) {
+                text.append(arg.text);
+            }
+        }
+        head = (head + 1) % QUEUE_SIZE;
+        count--;
+        if (entriesBeforeNote > 0) {
+            entriesBeforeNote--;
+        }
+    } else if (reply != nullptr && isReplyAllowed) {
+        if (!reply(replyCursor, text)) {
+            reply = nullptr;
+            return false;
+        }
+        if (text.length() == 0) {
+            return false;  // Nothing to show yet; the source is asked again on the next update()
+        }
+    } else {
+        return false;
+    }
+
+    lineLength = text.length();
+    line[lineLength++] = '\r';
+    line[lineLength++] = '\n';
+    linePosition = 0;
+    return true;
+}
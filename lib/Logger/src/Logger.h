@@ -0,0 +1,257 @@
+/**
+ * @file Logger.h
+ * @brief Header file for the Logger class.
+ *
+ * This file contains the declaration of the Logger class, a non-blocking log for the serial port. A log call stores
+ * the address of its PROGMEM message and up to MAX_ARGS values in a RAM ring buffer and returns at once; update()
+ * formats the oldest entry and writes only as many characters as the serial TX buffer has room for. When the ring
+ * is full the new message is dropped and counted instead of waiting, so logging never stalls the machine.
+ *
+ * Log through the LOG_ERROR(), LOG_WARN(), LOG_INFO() and LOG_DEBUG() macros. They wrap the message in F() and
+ * compile to nothing for levels above LOG_LEVEL, which can be set with a build flag, e.g. -DLOG_LEVEL=LOG_LEVEL_WARN.
+ * A '%' in the message is replaced by the next value:
+ *
+ *     LOG_INFO("[DATA] Weight: % g, flow: % g/s", LogArg(weight, 2), LogArg(flow, 1));
+ *
+ * A console reply longer than a line or two is not queued at all: startReply() hands the logger a function that
+ * formats the reply one line at a time, and update() asks it for the next line whenever the queue is empty. The
+ * reply so takes the logger's line buffer instead of the ring, and the machine's own messages keep going first.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0   ///< Nothing is logged
+#define LOG_LEVEL_ERROR 1  ///< Faults that stop a step
+#define LOG_LEVEL_WARN 2   ///< Problems the machine works around
+#define LOG_LEVEL_INFO 3   ///< Actions, setup and process data
+#define LOG_LEVEL_DEBUG 4  ///< Detail for troubleshooting
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO  ///< Most detailed level compiled in
+#endif
+
+/**
+ * @class LogArg
+ * @brief A value substituted for a '%' in a log message.
+ *
+ * Numbers are stored as they are and formatted when the entry is written, so a log call costs no formatting.
+ * Text must be in PROGMEM (F() or a PROGMEM table), since the entry outlives the call.
+ */
+class LogArg {
+public:
+    enum Type : byte {
+        NONE,    ///< No value
+        NUMBER,  ///< Whole number
+        REAL,    ///< Number with decimals
+        TEXT     ///< PROGMEM string
+    };
+
+    LogArg();
+    LogArg(int value);
+    LogArg(unsigned int value);
+    LogArg(long value);
+    LogArg(unsigned long value);
+
+    /**
+     * @brief Construct a LogArg for a number with decimals.
+     *
+     * @param value Number to log.
+     * @param decimals Digits after the decimal point.
+     */
+    LogArg(float value, byte decimals = 2);
+    LogArg(double value, byte decimals = 2);
+    LogArg(const __FlashStringHelper* text);
+
+    Type type;        ///< Kind of value
+    byte decimals;    ///< Digits after the decimal point of a REAL
+    union {
+        long number;                      ///< NUMBER value
+        float real;                       ///< REAL value
+        const __FlashStringHelper* text;  ///< TEXT value
+    };
+};
+
+class TextBuffer;
+
+/**
+ * @brief Formats the next line of a console reply.
+ *
+ * A source that works through a slow job a piece at a time, e.g. a bus scan, may return true with the line left
+ * empty; nothing is written and it is asked again on the next update().
+ *
+ * @param cursor Progress through the reply, 0 before the first line; the source advances it as it needs.
+ * @param line Buffer for the line, without the line end.
+ * @return true if a line was formatted, false once the reply is complete.
+ */
+typedef bool (*ReplySource)(byte& cursor, TextBuffer& line);
+
+/**
+ * @class Logger
+ * @brief Ring-buffered log with levels, PROGMEM messages and drop counting.
+ *
+ * Log calls must come from the main loop, not from interrupts.
+ */
+class Logger {
+public:
+    static const byte QUEUE_SIZE = 16;  ///< Entries waiting to be written
+    static const byte MAX_ARGS = 2;     ///< Values per message
+    static const byte LINE_SIZE = 80;   ///< Longest formatted line, including the line end
+
+    /**
+     * @brief Construct a new Logger object.
+     *
+     * @param out Port the log is written to; its availableForWrite() decides how much is written per update().
+     */
+    Logger(Print& out);
+
+    /**
+     * @brief Queues a message.
+     *
+     * @param level Level of the message; messages above the runtime level are ignored.
+     * @param message PROGMEM message; each '%' is replaced by the next value.
+     * @param first Value for the first '%'.
+     * @param second Value for the second '%'.
+     */
+    void log(byte level, const __FlashStringHelper* message, const LogArg& first = LogArg(),
+             const LogArg& second = LogArg());
+
+    /**
+     * @brief Queues a message whatever the level, e.g. the reply to a console command.
+     *
+     * @param message PROGMEM message; each '%' is replaced by the next value.
+     * @param first Value for the first '%'.
+     * @param second Value for the second '%'.
+     */
+    void print(const __FlashStringHelper* message, const LogArg& first = LogArg(), const LogArg& second = LogArg());
+
+    /**
+     * @brief Starts sending a reply of many lines, one line per update() while nothing else is queued.
+     *
+     * @param source Formats the reply line by line.
+     * @return true if the reply was started, false if another reply is still being sent.
+     */
+    bool startReply(ReplySource source);
+
+    /**
+     * @brief Checks whether a reply started with startReply() is still being sent.
+     *
+     * @return true until the reply source has no more lines.
+     */
+    bool isReplying() const;
+
+    /**
+     * @brief Writes queued text as far as the port has room, without waiting.
+     *
+     * Call it often, e.g. from a scheduler task.
+     */
+    void update();
+
+    /**
+     * @brief Writes everything queued, and the rest of any reply, waiting for the port as needed.
+     */
+    void flush();
+
+    /**
+     * @brief Sets the most detailed level that is logged.
+     *
+     * Levels above LOG_LEVEL are compiled out and cannot be enabled here.
+     *
+     * @param level One of the LOG_LEVEL_ values.
+     */
+    void setLevel(byte level);
+
+    /**
+     * @brief Returns the most detailed level that is logged.
+     *
+     * @return One of the LOG_LEVEL_ values.
+     */
+    byte getLevel() const;
+
+    /**
+     * @brief Sets what happens to a message when the queue is full.
+     *
+     * Blocking is meant for setup(), where nothing else is running yet and every message is wanted.
+     *
+     * @param isBlocking If true, the oldest entries are written out to make room; if false, the message is dropped.
+     */
+    void setBlocking(bool isBlocking);
+
+    /**
+     * @brief Returns the number of messages dropped because the queue was full.
+     *
+     * @return Messages dropped since start-up.
+     */
+    unsigned long getDropCount() const;
+
+private:
+    /**
+     * @brief A queued message.
+     */
+    struct Entry {
+        const __FlashStringHelper* message;  ///< PROGMEM message
+        LogArg args[MAX_ARGS];               ///< Values for the '%' placeholders
+    };
+
+    /**
+     * @brief Adds a message to the ring, or drops it if the ring is full and the logger is not blocking.
+     *
+     * @param message PROGMEM message.
+     * @param first Value for the first '%'.
+     * @param second Value for the second '%'.
+     */
+    void enqueue(const __FlashStringHelper* message, const LogArg& first, const LogArg& second);
+
+    /**
+     * @brief Formats the oldest entry, a note about dropped messages, or the next reply line into the line buffer.
+     *
+     * @param isReplyAllowed Whether a reply line may be formatted when nothing is queued.
+     * @return true if there was something to format.
+     */
+    bool formatNext(bool isReplyAllowed);
+
+    Print& out;                     ///< Port the log is written to
+    Entry entries[QUEUE_SIZE];      ///< Ring of queued messages
+    byte head;                      ///< Index of the oldest entry
+    byte count;                     ///< Number of queued entries
+    char line[LINE_SIZE];           ///< Line being written
+    byte lineLength;                ///< Characters in the line
+    byte linePosition;              ///< Characters of the line already written
+    byte level;                     ///< Most detailed level logged
+    bool isBlocking;                ///< Whether a full queue waits instead of dropping
+    unsigned long dropCount;        ///< Messages dropped since start-up
+    unsigned long unreportedDrops;  ///< Drops not yet noted in the log
+    byte entriesBeforeNote;         ///< Entries queued before the first unreported drop
+    ReplySource reply;              ///< Source of the reply being sent, nullptr for none
+    byte replyCursor;               ///< Progress of the reply source
+};
+
+extern Logger logger;  ///< Log written to Serial
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(message, ...) logger.log(LOG_LEVEL_ERROR, F(message), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(message, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(message, ...) logger.log(LOG_LEVEL_WARN, F(message), ##__VA_ARGS__)
+#else
+#define LOG_WARN(message, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(message, ...) logger.log(LOG_LEVEL_INFO, F(message), ##__VA_ARGS__)
+#else
+#define LOG_INFO(message, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(message, ...) logger.log(LOG_LEVEL_DEBUG, F(message), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(message, ...) do {} while (0)
+#endif
+
+#endif  // LOGGER_H
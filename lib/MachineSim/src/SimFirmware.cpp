@@ -0,0 +1,96 @@
+#include "SimFirmware.h"
+#include "BatchStateMachine.h"
+
+extern BatchStateMachine batch;  ///< The firmware's batch process (src/main.cpp)
+
+namespace {
+
+const SimAxisConfig sliderAxis = {
+    "slider", 52, 53, false, 21000, -150, 58500, 9, 0, SimMachine::NO_PIN, 0
+};
+const SimAxisConfig sealerAxis = {
+    "sealer", 46, 47, true, -4000, -9150, 150, 10, -9000, 11, 0
+};
+const SimAxisConfig mixingToolAxis = {
+    "mixing tool", 49, 48, true, 0, -2000000000L, 2000000000L, SimMachine::NO_PIN, 0, SimMachine::NO_PIN, 0
+};
+const SimAxisConfig mixerAxis = {
+    "mixer", 50, 51, true, 3000, -150, 38500, 13, 0, 4, 38000
+};
+const SimScaleConfig scaleConfig = { 2, 12, 13.40f, 84000, 0.3f };
+
+}  // namespace
+
+namespace SimFirmware {
+
+/**
+ * @brief Adds the machine's axes, feeders, scale and I2C devices to a SimMachine.
+ *
+ * @param sim The machine to set up; it should be empty.
+ * @param bananaFlow Banana feed while the chopper runs, in g/s.
+ * @param molassesFlow Molasses flow at full pump speed, in g/s.
+ */
+void wire(SimMachine& sim, float bananaFlow, float molassesFlow) {
+    sim.addAxis(sliderAxis);
+    sim.addAxis(sealerAxis);
+    sim.addAxis(mixingToolAxis);
+    sim.addAxis(mixerAxis);
+    const SimFeederConfig banana = { "banana", 7, 8, bananaFlow, false, 350 };
+    const SimFeederConfig molasses = { "molasses", 5, 6, molassesFlow, true, 600 };
+    sim.addFeeder(banana);
+    sim.addFeeder(molasses);
+    sim.setScale(scaleConfig);
+    sim.addI2cDevice(LCD_ADDRESS);
+    sim.addI2cDevice(RTC_ADDRESS);
+    sim.setLcdAddress(LCD_ADDRESS);
+}
+
+/**
+ * @brief Checks whether the batch is in the named state.
+ *
+ * @param name State name as shown by the firmware.
+ * @return true if the batch is in that state.
+ */
+bool isInState(const char* name) {
+    return strcmp_P(name, reinterpret_cast<const char*>(batch.getStateName())) == 0;
+}
+
+/**
+ * @brief Runs the firmware until the batch enters one of two states or the deadline passes.
+ *
+ * @param state State to wait for.
+ * @param otherState Second state that also ends the wait, or nullptr.
+ * @param deadlineUs Virtual time to give up at.
+ * @param onLoop Called after every loop(), or nullptr.
+ * @return true if one of the states was reached.
+ */
+bool runUntil(const char* state, const char* otherState, uint64_t deadlineUs, void (*onLoop)()) {
+    while (!isInState(state) && (otherState == nullptr || !isInState(otherState))) {
+        if (NativeHal::nowUs() >= deadlineUs) {
+            return false;
+        }
+        loop();
+        if (onLoop != nullptr) {
+            onLoop();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Runs the firmware for a while.
+ *
+ * @param ms Virtual time to run for, in milliseconds.
+ * @param onLoop Called after every loop(), or nullptr.
+ */
+void runFor(unsigned long ms, void (*onLoop)()) {
+    uint64_t end = NativeHal::nowUs() + ms * 1000ULL;
+    while (NativeHal::nowUs() < end) {
+        loop();
+        if (onLoop != nullptr) {
+            onLoop();
+        }
+    }
+}
+
+}  // namespace SimFirmware
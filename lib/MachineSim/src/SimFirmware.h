@@ -0,0 +1,91 @@
+/**
+ * @file SimFirmware.h
+ * @brief Wiring of src/main.cpp onto a SimMachine, and helpers that run the firmware on virtual time.
+ *
+ * Shared by the simulator program (SimMain.cpp) and the host tests under test/, which boot the firmware with setup()
+ * and drive it through a batch with the same machine:
+ *
+ *     SimMachine sim(SimFirmware::MOTOR_RELAY_PIN);
+ *     SimFirmware::wire(sim, 20.0f, 25.0f);
+ *     NativeHal::attach(&sim);
+ *     setup();
+ *     sim.press(SimFirmware::START_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+ *     SimFirmware::runUntil("FERMENTING", "FAULT", NativeHal::nowUs() + 900000000ULL);
+ */
+
+#ifndef SIMFIRMWARE_H
+#define SIMFIRMWARE_H
+
+#include <Arduino.h>
+#include "SimMachine.h"
+
+void setup();  ///< The firmware's start-up (src/main.cpp)
+void loop();   ///< The firmware's main loop (src/main.cpp)
+
+namespace SimFirmware {
+
+// Wiring; the pins must match src/main.cpp.
+const byte MOTOR_RELAY_PIN = 45;         ///< Active-low relay that powers the drivers and motors
+const byte START_BUTTON_PIN = A0;        ///< Start button
+const byte RESET_BUTTON_PIN = A1;        ///< Reset button
+const byte LCD_ADDRESS = 0x20;           ///< I2C address of the LCD backpack
+const byte RTC_ADDRESS = 0x68;           ///< I2C address of the DS3231
+const unsigned long BUTTON_PRESS_MS = 200;  ///< How long a button is held
+
+/**
+ * @brief Axis numbers of the SimMachine, in the order wire() adds them.
+ */
+enum Axis {
+    AXIS_SLIDER,
+    AXIS_SEALER,
+    AXIS_MIXING_TOOL,
+    AXIS_MIXER
+};
+
+/**
+ * @brief Feeder numbers of the SimMachine, in the order wire() adds them.
+ */
+enum Feeder {
+    FEEDER_BANANA,
+    FEEDER_MOLASSES
+};
+
+/**
+ * @brief Adds the machine's axes, feeders, scale and I2C devices to a SimMachine.
+ *
+ * @param sim The machine to set up; it should be empty.
+ * @param bananaFlow Banana feed while the chopper runs, in g/s.
+ * @param molassesFlow Molasses flow at full pump speed, in g/s.
+ */
+void wire(SimMachine& sim, float bananaFlow, float molassesFlow);
+
+/**
+ * @brief Checks whether the batch is in the named state.
+ *
+ * @param name State name as shown by the firmware, e.g. "FERMENTING".
+ * @return true if the batch is in that state.
+ */
+bool isInState(const char* name);
+
+/**
+ * @brief Runs the firmware until the batch enters one of two states or the deadline passes.
+ *
+ * @param state State to wait for.
+ * @param otherState Second state that also ends the wait, or nullptr.
+ * @param deadlineUs Virtual time to give up at (see NativeHal::nowUs()).
+ * @param onLoop Called after every loop(), or nullptr.
+ * @return true if one of the states was reached.
+ */
+bool runUntil(const char* state, const char* otherState, uint64_t deadlineUs, void (*onLoop)() = nullptr);
+
+/**
+ * @brief Runs the firmware for a while, e.g. to let a button press be seen.
+ *
+ * @param ms Virtual time to run for, in milliseconds.
+ * @param onLoop Called after every loop(), or nullptr.
+ */
+void runFor(unsigned long ms, void (*onLoop)() = nullptr);
+
+}  // namespace SimFirmware
+
+#endif  // SIMFIRMWARE_H
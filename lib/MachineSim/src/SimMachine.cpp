@@ -0,0 +1,322 @@
+#include "SimMachine.h"
+#include "StepTimer.h"
+
+/**
+ * @brief Construct a new SimMachine object.
+ *
+ * @param powerRelayPin Active-low relay that powers the stepper drivers and DC motors, or NO_PIN if always on.
+ * @param seed Seed of the scale noise, so runs repeat exactly.
+ */
+SimMachine::SimMachine(byte powerRelayPin, unsigned long seed) {
+    this->powerRelayPin = powerRelayPin;
+    this->axisCount = 0;
+    this->feederCount = 0;
+    this->hasScale = false;
+    this->nextSampleUs = 0;
+    this->i2cDeviceCount = 0;
+    this->lcdAddress = 0;
+    this->lcdChangedAtUs = 0;
+    this->randomState = seed;
+    for (byte i = 0; i < MAX_PRESSES; i++) {
+        presses[i].pin = NO_PIN;
+    }
+    for (byte row = 0; row < LCD_ROWS; row++) {
+        memset(lcd[row], ' ', LCD_COLS);
+        lcd[row][LCD_COLS] = '\0';
+    }
+}
+
+/**
+ * @brief Adds a stepper axis and sets its switches.
+ *
+ * @param config The axis.
+ * @return The axis index, or -1 if the table is full.
+ */
+int8_t SimMachine::addAxis(const SimAxisConfig& config) {
+    if (axisCount >= MAX_AXES) {
+        return -1;
+    }
+    Axis& axis = axes[axisCount];
+    axis.config = config;
+    axis.position = config.startPosition;
+    axis.stepCount = 0;
+    updateSwitches(axis);
+    return axisCount++;
+}
+
+/**
+ * @brief Adds a material feeder.
+ *
+ * @param config The feeder.
+ * @return The feeder index, or -1 if the table is full.
+ */
+int8_t SimMachine::addFeeder(const SimFeederConfig& config) {
+    if (feederCount >= MAX_FEEDERS) {
+        return -1;
+    }
+    Feeder& feeder = feeders[feederCount];
+    feeder.config = config;
+    feeder.fallingGrams = 0.0f;
+    feeder.landedGrams = 0.0f;
+    return feederCount++;
+}
+
+/**
+ * @brief Sets up the load cell.
+ *
+ * @param config The scale.
+ */
+void SimMachine::setScale(const SimScaleConfig& config) {
+    this->scale = config;
+    this->hasScale = true;
+    this->nextSampleUs = NativeHal::nowUs() + samplePeriodUs();
+}
+
+/**
+ * @brief Connects a device to the I2C bus so it acknowledges its address.
+ *
+ * @param address The 7-bit address.
+ */
+void SimMachine::addI2cDevice(byte address) {
+    if (i2cDeviceCount < MAX_I2C_DEVICES) {
+        i2cDevices[i2cDeviceCount++] = address;
+    }
+}
+
+/**
+ * @brief Sets the I2C address whose character writes are shown on the simulated LCD.
+ *
+ * @param address The 7-bit address.
+ */
+void SimMachine::setLcdAddress(byte address) {
+    this->lcdAddress = address;
+}
+
+/**
+ * @brief Closes a button and opens it again after a while.
+ *
+ * @param pin The button's pin, which reads HIGH while pressed.
+ * @param ms How long the button is held.
+ */
+void SimMachine::press(byte pin, unsigned long ms) {
+    for (byte i = 0; i < MAX_PRESSES; i++) {
+        if (presses[i].pin == NO_PIN || presses[i].pin == pin) {
+            presses[i].pin = pin;
+            presses[i].releaseAtUs = NativeHal::nowUs() + ms * 1000ULL;
+            NativeHal::setInput(pin, true);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Takes everything out of the container; material still falling lands later.
+ */
+void SimMachine::emptyContainer() {
+    for (byte i = 0; i < feederCount; i++) {
+        feeders[i].landedGrams = 0.0f;
+    }
+}
+
+/**
+ * @brief Returns the position of an axis.
+ *
+ * @param axis The axis index.
+ * @return Position in steps.
+ */
+long SimMachine::getAxisPosition(byte axis) const {
+    return (axis < axisCount) ? axes[axis].position : 0;
+}
+
+/**
+ * @brief Returns the material a feeder has put into the container since it was last emptied.
+ *
+ * @param feeder The feeder index.
+ * @return Weight in grams.
+ */
+float SimMachine::getFedGrams(byte feeder) const {
+    return (feeder < feederCount) ? feeders[feeder].landedGrams : 0.0f;
+}
+
+/**
+ * @brief Returns the number of step pulses an axis has taken while powered.
+ *
+ * @param axis The axis index.
+ * @return Steps since start, in either direction.
+ */
+unsigned long SimMachine::getStepCount(byte axis) const {
+    return (axis < axisCount) ? axes[axis].stepCount : 0;
+}
+
+/**
+ * @brief Returns a row of the LCD.
+ *
+ * @param row The row.
+ * @return The characters of the row.
+ */
+const char* SimMachine::getLcdLine(byte row) const {
+    return lcd[(row < LCD_ROWS) ? row : 0];
+}
+
+/**
+ * @brief Returns the virtual time of the last change to the LCD.
+ *
+ * @return Microseconds since start.
+ */
+uint64_t SimMachine::getLcdChangedAt() const {
+    return lcdChangedAtUs;
+}
+
+/**
+ * @brief Runs the step timer, lets the fed material fall and releases buttons whose time is up.
+ *
+ * Material leaves a running feeder at its flow and lands with a first-order lag, so some is still falling when
+ * the motor stops, as with the real chopper and hose.
+ *
+ * @param us Time that has passed, in microseconds.
+ */
+void SimMachine::advance(unsigned long us) {
+    StepTimer::advance(us);
+
+    double seconds = us / 1000000.0;
+    for (byte i = 0; i < feederCount; i++) {
+        Feeder& feeder = feeders[i];
+        const SimFeederConfig& config = feeder.config;
+        double speed = 0.0;
+        if (isPowered() && NativeHal::getOutput(config.enablePin)) {
+            speed = (255 - NativeHal::getAnalogOutput(config.pwmPin)) / 255.0;
+            if (!config.isFlowBySpeed && speed > 0.0) {
+                speed = 1.0;
+            }
+        }
+        feeder.fallingGrams += config.fullFlow * speed * seconds;
+        double share = (config.lagMs > 0) ? min(1.0, us / (config.lagMs * 1000.0)) : 1.0;
+        double landing = feeder.fallingGrams * share;
+        feeder.fallingGrams -= landing;
+        feeder.landedGrams += landing;
+    }
+
+    uint64_t now = NativeHal::nowUs();
+    for (byte i = 0; i < MAX_PRESSES; i++) {
+        if (presses[i].pin != NO_PIN && now >= presses[i].releaseAtUs) {
+            NativeHal::setInput(presses[i].pin, false);
+            presses[i].pin = NO_PIN;
+        }
+    }
+}
+
+/**
+ * @brief Moves an axis one step on the rising edge of its PUL pin, if the drivers are powered.
+ *
+ * A step past a hard stop is lost, as on a stalled motor.
+ *
+ * @param pin The pin that changed.
+ * @param isHigh Its new level.
+ */
+void SimMachine::onDigitalWrite(uint8_t pin, bool isHigh) {
+    if (!isHigh) {
+        return;
+    }
+    for (byte i = 0; i < axisCount; i++) {
+        Axis& axis = axes[i];
+        if (axis.config.pulsePin != pin) {
+            continue;
+        }
+        if (!isPowered()) {
+            return;
+        }
+        long delta = (NativeHal::getOutput(axis.config.dirPin) == axis.config.positiveLevel) ? 1 : -1;
+        long position = axis.position + delta;
+        if (position >= axis.config.minPosition && position <= axis.config.maxPosition) {
+            axis.position = position;
+            axis.stepCount++;
+            updateSwitches(axis);
+        }
+        return;
+    }
+}
+
+bool SimMachine::isI2cDevicePresent(uint8_t address) {
+    for (byte i = 0; i < i2cDeviceCount; i++) {
+        if (i2cDevices[i] == address) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SimMachine::onLcdWrite(uint8_t address, uint8_t col, uint8_t row, char c) {
+    if (address != lcdAddress || col >= LCD_COLS || row >= LCD_ROWS || lcd[row][col] == c) {
+        return;
+    }
+    lcd[row][col] = c;
+    lcdChangedAtUs = NativeHal::nowUs();
+}
+
+bool SimMachine::isLoadCellReady(uint8_t dataPin) {
+    return hasScale && dataPin == scale.dataPin && NativeHal::nowUs() >= nextSampleUs;
+}
+
+/**
+ * @brief Takes the latest conversion: the landed material plus noise, in counts.
+ *
+ * A conversion that was not read before the next one finished is lost, as on the HX711.
+ *
+ * @param dataPin The HX711 DOUT pin.
+ * @return The signed 24-bit reading.
+ */
+long SimMachine::readLoadCell(uint8_t dataPin) {
+    if (!isLoadCellReady(dataPin)) {
+        return 0;
+    }
+    unsigned long period = samplePeriodUs();
+    uint64_t now = NativeHal::nowUs();
+    while (nextSampleUs + period <= now) {
+        nextSampleUs += period;
+    }
+    nextSampleUs += period;
+
+    double grams = noise() * scale.noiseGrams;
+    for (byte i = 0; i < feederCount; i++) {
+        grams += feeders[i].landedGrams;
+    }
+    long counts = scale.zeroCounts + lround(grams * scale.countsPerGram);
+    return constrain(counts, -0x800000L, 0x7FFFFFL);
+}
+
+/**
+ * @brief Checks whether the relay powers the drivers and motors.
+ */
+bool SimMachine::isPowered() const {
+    return powerRelayPin == NO_PIN || !NativeHal::getOutput(powerRelayPin);
+}
+
+/**
+ * @brief Drives an axis' switch pins from its position.
+ */
+void SimMachine::updateSwitches(const Axis& axis) {
+    if (axis.config.lowSwitchPin != NO_PIN) {
+        NativeHal::setInput(axis.config.lowSwitchPin, axis.position <= axis.config.lowSwitchAt);
+    }
+    if (axis.config.highSwitchPin != NO_PIN) {
+        NativeHal::setInput(axis.config.highSwitchPin, axis.position >= axis.config.highSwitchAt);
+    }
+}
+
+/**
+ * @brief Returns the sample period of the HX711 for the level of its RATE pin.
+ */
+unsigned long SimMachine::samplePeriodUs() const {
+    if (scale.ratePin != NO_PIN && NativeHal::getOutput(scale.ratePin)) {
+        return 12500;  // 80 SPS
+    }
+    return 100000;     // 10 SPS
+}
+
+/**
+ * @brief Returns a pseudo-random number from -1 to 1.
+ */
+float SimMachine::noise() {
+    randomState = randomState * 1103515245UL + 12345UL;
+    return ((randomState >> 16) & 0x7FFF) / 16383.5f - 1.0f;
+}
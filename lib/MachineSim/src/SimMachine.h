@@ -0,0 +1,241 @@
+/**
+ * @file SimMachine.h
+ * @brief Header file for the SimMachine class.
+ *
+ * This file contains the declaration of the SimMachine class, a model of the FFJ machine for the native build. It
+ * is the HalDevice behind the pins: step pulses move the axes, the axes open and close their limit switches, the
+ * chopper and pump fill the container on the load cell, and the LCD and RTC answer on the I2C bus. Everything runs
+ * on the virtual time of the NativeHal layer, so a full batch takes seconds on the host.
+ *
+ * The model only knows pin numbers; the wiring is set up by SimFirmware.cpp to match src/main.cpp.
+ */
+
+#ifndef SIMMACHINE_H
+#define SIMMACHINE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief A stepper axis: its driver pins, where it starts and where its switches close.
+ */
+struct SimAxisConfig {
+    const char* name;        ///< Name for the report
+    byte pulsePin;           ///< Driver PUL input
+    byte dirPin;             ///< Driver DIR input
+    bool positiveLevel;      ///< DIR level of a positive step (the StepperController's positive direction)
+    long startPosition;      ///< Position at power-on, in steps
+    long minPosition;        ///< Hard stop in the negative direction
+    long maxPosition;        ///< Hard stop in the positive direction
+    byte lowSwitchPin;       ///< Switch that closes at or below lowSwitchAt, or SimMachine::NO_PIN
+    long lowSwitchAt;        ///< Position where the low switch closes
+    byte highSwitchPin;      ///< Switch that closes at or above highSwitchAt, or SimMachine::NO_PIN
+    long highSwitchAt;       ///< Position where the high switch closes
+};
+
+/**
+ * @brief A DC motor that feeds material into the container.
+ */
+struct SimFeederConfig {
+    const char* name;        ///< Name of the material for the report
+    byte enablePin;          ///< Motor driver enable, HIGH runs
+    byte pwmPin;             ///< Motor driver PWM, inverted (255 is stopped)
+    float fullFlow;          ///< Flow at full speed, in g/s
+    bool isFlowBySpeed;      ///< Whether the flow follows the PWM speed; otherwise any speed gives full flow
+    unsigned long lagMs;     ///< Time constant of the material still falling after the motor stops
+};
+
+/**
+ * @brief The load cell and its HX711.
+ */
+struct SimScaleConfig {
+    byte dataPin;            ///< HX711 DOUT
+    byte ratePin;            ///< HX711 RATE (HIGH is 80 SPS), or SimMachine::NO_PIN for a fixed 10 SPS
+    float countsPerGram;     ///< Sensitivity
+    long zeroCounts;         ///< Reading with the empty container
+    float noiseGrams;        ///< Peak noise of a reading
+};
+
+/**
+ * @class SimMachine
+ * @brief The machine's mechanics and peripherals, driven by the program's pins on virtual time.
+ */
+class SimMachine : public HalDevice {
+public:
+    static const byte NO_PIN = 0xFF;        ///< Marks an unused pin
+    static const byte MAX_AXES = 4;         ///< Size of the axis table
+    static const byte MAX_FEEDERS = 2;      ///< Size of the feeder table
+    static const byte MAX_PRESSES = 4;      ///< Buttons that can be held at once
+    static const byte MAX_I2C_DEVICES = 4;  ///< Devices on the I2C bus
+    static const byte LCD_COLS = 16;        ///< LCD size
+    static const byte LCD_ROWS = 2;
+
+    /**
+     * @brief Construct a new SimMachine object.
+     *
+     * @param powerRelayPin Active-low relay that powers the stepper drivers and DC motors, or NO_PIN if always on.
+     * @param seed Seed of the scale noise, so runs repeat exactly.
+     */
+    SimMachine(byte powerRelayPin, unsigned long seed = 1);
+
+    /**
+     * @brief Adds a stepper axis and sets its switches.
+     *
+     * @param config The axis.
+     * @return The axis index, or -1 if the table is full.
+     */
+    int8_t addAxis(const SimAxisConfig& config);
+
+    /**
+     * @brief Adds a material feeder.
+     *
+     * @param config The feeder.
+     * @return The feeder index, or -1 if the table is full.
+     */
+    int8_t addFeeder(const SimFeederConfig& config);
+
+    /**
+     * @brief Sets up the load cell.
+     *
+     * @param config The scale.
+     */
+    void setScale(const SimScaleConfig& config);
+
+    /**
+     * @brief Connects a device to the I2C bus so it acknowledges its address.
+     *
+     * @param address The 7-bit address.
+     */
+    void addI2cDevice(byte address);
+
+    /**
+     * @brief Sets the I2C address whose character writes are shown on the simulated LCD.
+     *
+     * @param address The 7-bit address.
+     */
+    void setLcdAddress(byte address);
+
+    /**
+     * @brief Closes a button and opens it again after a while.
+     *
+     * @param pin The button's pin, which reads HIGH while pressed.
+     * @param ms How long the button is held.
+     */
+    void press(byte pin, unsigned long ms);
+
+    /**
+     * @brief Takes everything out of the container; material still falling lands later.
+     */
+    void emptyContainer();
+
+    /**
+     * @brief Returns the position of an axis.
+     *
+     * @param axis The axis index.
+     * @return Position in steps.
+     */
+    long getAxisPosition(byte axis) const;
+
+    /**
+     * @brief Returns the material a feeder has put into the container since it was last emptied.
+     *
+     * @param feeder The feeder index.
+     * @return Weight in grams.
+     */
+    float getFedGrams(byte feeder) const;
+
+    /**
+     * @brief Returns the number of step pulses an axis has taken while powered.
+     *
+     * @param axis The axis index.
+     * @return Steps since start, in either direction.
+     */
+    unsigned long getStepCount(byte axis) const;
+
+    /**
+     * @brief Returns a row of the LCD.
+     *
+     * @param row The row.
+     * @return The characters of the row.
+     */
+    const char* getLcdLine(byte row) const;
+
+    /**
+     * @brief Returns the virtual time of the last change to the LCD.
+     *
+     * @return Microseconds since start.
+     */
+    uint64_t getLcdChangedAt() const;
+
+    // HalDevice
+    void advance(unsigned long us) override;
+    void onDigitalWrite(uint8_t pin, bool isHigh) override;
+    bool isI2cDevicePresent(uint8_t address) override;
+    void onLcdWrite(uint8_t address, uint8_t col, uint8_t row, char c) override;
+    bool isLoadCellReady(uint8_t dataPin) override;
+    long readLoadCell(uint8_t dataPin) override;
+
+private:
+    /**
+     * @brief An axis and its state.
+     */
+    struct Axis {
+        SimAxisConfig config;        ///< Wiring and geometry
+        long position;               ///< Position in steps
+        unsigned long stepCount;     ///< Steps taken since start
+    };
+
+    /**
+     * @brief A feeder and the material it has moved.
+     */
+    struct Feeder {
+        SimFeederConfig config;      ///< Wiring and flow
+        double fallingGrams;         ///< Material on its way to the container (double: a 1 us slice adds ~1e-5 g)
+        double landedGrams;          ///< Material in the container
+    };
+
+    /**
+     * @brief A button being held.
+     */
+    struct Press {
+        byte pin;                    ///< Button pin, NO_PIN if the slot is free
+        uint64_t releaseAtUs;        ///< Virtual time of the release
+    };
+
+    /**
+     * @brief Checks whether the relay powers the drivers and motors.
+     */
+    bool isPowered() const;
+
+    /**
+     * @brief Drives an axis' switch pins from its position.
+     */
+    void updateSwitches(const Axis& axis);
+
+    /**
+     * @brief Returns the sample period of the HX711 for the level of its RATE pin.
+     */
+    unsigned long samplePeriodUs() const;
+
+    /**
+     * @brief Returns a pseudo-random number from -1 to 1.
+     */
+    float noise();
+
+    byte powerRelayPin;                      ///< Relay powering the drivers and motors
+    Axis axes[MAX_AXES];                     ///< Axis table
+    byte axisCount;                          ///< Axes in the table
+    Feeder feeders[MAX_FEEDERS];             ///< Feeder table
+    byte feederCount;                        ///< Feeders in the table
+    SimScaleConfig scale;                    ///< Load cell
+    bool hasScale;                           ///< Whether setScale() was called
+    uint64_t nextSampleUs;                   ///< Virtual time the next HX711 conversion is ready
+    Press presses[MAX_PRESSES];              ///< Buttons being held
+    byte i2cDevices[MAX_I2C_DEVICES];        ///< Addresses on the I2C bus
+    byte i2cDeviceCount;                     ///< Devices on the bus
+    byte lcdAddress;                         ///< Address of the LCD
+    char lcd[LCD_ROWS][LCD_COLS + 1];        ///< Characters on the LCD
+    uint64_t lcdChangedAtUs;                 ///< Virtual time of the last LCD change
+    unsigned long randomState;               ///< State of the noise generator
+};
+
+#endif  // SIMMACHINE_H
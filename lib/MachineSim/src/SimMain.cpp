@@ -0,0 +1,210 @@
+/**
+ * @file SimMain.cpp
+ * @brief The simulator program of the native build: runs src/main.cpp against SimMachine on virtual time.
+ *
+ * The program boots the firmware, presses start, waits for the batch to reach FERMENTING (or FAULT), and repeats
+ * for the requested number of batches, emptying the container and pressing reset in between. It then prints the
+ * cycle time and the weight actually dosed per batch, followed by the firmware's profile report.
+ *
+ *     pio run -e native && .pio/build/native/program --batches 3 --quiet
+ *
+ * Options:
+ *     --batches N          batches to run (default 1)
+ *     --banana-flow G      banana feed while the chopper runs, g/s (default 20)
+ *     --molasses-flow G    molasses flow at full pump speed, g/s (default 25)
+ *     --time-limit S       virtual seconds allowed per batch (default 900)
+ *     --eeprom FILE        load the EEPROM from FILE if it exists and save it at the end
+ *     --telemetry FILE     write the Serial1 telemetry stream to FILE (decode with tools/telemetry_decode.py)
+ *     --clock-cost US      virtual time per millis()/micros() call (default 1)
+ *     --seed N             seed of the scale noise (default 1)
+ *     --lcd                print the LCD whenever it changes
+ *     --quiet              hide the firmware's serial log
+ *
+ * The program is left out of `pio test -e native`, where each test under test/ brings its own main().
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <chrono>
+#include "BatchStateMachine.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "SimFirmware.h"
+#include "SimMachine.h"
+
+#ifndef PIO_UNIT_TESTING
+
+extern BatchStateMachine batch;  ///< The firmware's batch process (src/main.cpp)
+
+namespace {
+
+const unsigned long lcdSettleUs = 50000;     // LCD unchanged for this long before --lcd prints it
+
+struct Options {
+    int batches = 1;
+    float bananaFlow = 20.0f;
+    float molassesFlow = 25.0f;
+    unsigned long timeLimitS = 900;
+    const char* eepromPath = nullptr;
+    const char* telemetryPath = nullptr;
+    unsigned int clockCostUs = 1;
+    unsigned long seed = 1;
+    bool isLcdShown = false;
+    bool isQuiet = false;
+};
+
+SimMachine* machine = nullptr;
+bool isLcdShown = false;
+uint64_t lcdShownAtUs = 0;
+
+double seconds(uint64_t us) {
+    return us / 1000000.0;
+}
+
+/**
+ * @brief Prints the LCD once it has settled after a change.
+ */
+void showLcd() {
+    uint64_t changedAt = machine->getLcdChangedAt();
+    if (!isLcdShown || changedAt == lcdShownAtUs || NativeHal::nowUs() - changedAt < lcdSettleUs) {
+        return;
+    }
+    lcdShownAtUs = changedAt;
+    printf("[SIM %9.3f s] LCD |%s|%s|\n", seconds(NativeHal::nowUs()), machine->getLcdLine(0),
+           machine->getLcdLine(1));
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--lcd") == 0) {
+            options.isLcdShown = true;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            options.isQuiet = true;
+        } else if (value == nullptr) {
+            fprintf(stderr, "Unknown option or missing value: %s\n", arg);
+            return false;
+        } else if (strcmp(arg, "--batches") == 0) {
+            options.batches = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--banana-flow") == 0) {
+            options.bananaFlow = atof(value);
+            i++;
+        } else if (strcmp(arg, "--molasses-flow") == 0) {
+            options.molassesFlow = atof(value);
+            i++;
+        } else if (strcmp(arg, "--time-limit") == 0) {
+            options.timeLimitS = strtoul(value, nullptr, 10);
+            i++;
+        } else if (strcmp(arg, "--eeprom") == 0) {
+            options.eepromPath = value;
+            i++;
+        } else if (strcmp(arg, "--telemetry") == 0) {
+            options.telemetryPath = value;
+            i++;
+        } else if (strcmp(arg, "--clock-cost") == 0) {
+            options.clockCostUs = atoi(value);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0) {
+            options.seed = strtoul(value, nullptr, 10);
+            i++;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg);
+            return false;
+        }
+    }
+    return options.batches > 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+    auto hostStart = std::chrono::steady_clock::now();
+
+    SimMachine sim(SimFirmware::MOTOR_RELAY_PIN, options.seed);
+    SimFirmware::wire(sim, options.bananaFlow, options.molassesFlow);
+    machine = &sim;
+    isLcdShown = options.isLcdShown;
+
+    NativeHal::attach(&sim);
+    NativeHal::setClockReadCost(options.clockCostUs);
+    if (options.isQuiet) {
+        NativeHal::setSerialOutput(nullptr);
+    }
+    FILE* telemetryFile = nullptr;
+    if (options.telemetryPath != nullptr) {
+        telemetryFile = fopen(options.telemetryPath, "wb");
+        NativeHal::setSerial1Output(telemetryFile);
+    }
+    if (options.eepromPath != nullptr && EEPROM.loadFile(options.eepromPath)) {
+        printf("[SIM] EEPROM loaded from %s\n", options.eepromPath);
+    }
+
+    setup();
+    printf("[SIM %9.3f s] Setup done, batch state %s\n", seconds(NativeHal::nowUs()),
+           reinterpret_cast<const char*>(batch.getStateName()));
+
+    int completed = 0;
+    uint64_t busyUs = 0;
+    for (int i = 1; i <= options.batches; i++) {
+        uint64_t deadline = NativeHal::nowUs() + options.timeLimitS * 1000000ULL;
+        if (!SimFirmware::isInState("IDLE")) {
+            if (!SimFirmware::isInState("FERMENTING") && !SimFirmware::isInState("FAULT")) {
+                printf("[SIM] Resuming the interrupted batch\n");
+                SimFirmware::runUntil("FERMENTING", "FAULT", deadline, showLcd);
+            }
+            sim.press(SimFirmware::RESET_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+            if (!SimFirmware::runUntil("IDLE", nullptr, deadline, showLcd)) {
+                printf("[SIM] Machine did not return to IDLE\n");
+                break;
+            }
+        }
+        sim.emptyContainer();
+        SimFirmware::runFor(SimFirmware::BUTTON_PRESS_MS, showLcd);
+
+        uint64_t start = NativeHal::nowUs();
+        sim.press(SimFirmware::START_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+        bool isDone = SimFirmware::runUntil("FERMENTING", "FAULT", deadline, showLcd);
+        uint64_t cycleUs = NativeHal::nowUs() - start;
+        if (!isDone || SimFirmware::isInState("FAULT")) {
+            printf("[SIM %9.3f s] Batch %d stopped in %s after %.1f s\n", seconds(NativeHal::nowUs()), i,
+                   reinterpret_cast<const char*>(batch.getStateName()), seconds(cycleUs));
+            break;
+        }
+        SimFirmware::runFor(2000, showLcd);  // Let material still falling land before it is weighed
+        completed++;
+        busyUs += cycleUs;
+        printf("[SIM %9.3f s] Batch %d: cycle %.1f s, banana %.1f g, molasses %.1f g\n",
+               seconds(NativeHal::nowUs()), i, seconds(cycleUs), sim.getFedGrams(SimFirmware::FEEDER_BANANA),
+               sim.getFedGrams(SimFirmware::FEEDER_MOLASSES));
+    }
+    logger.flush();
+    fflush(stdout);
+
+    double hostSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - hostStart).count();
+    printf("[SIM] %d of %d batches done, mean cycle %.1f s; %.1f s of machine time in %.2f s on the host (%.0fx)\n",
+           completed, options.batches, completed > 0 ? seconds(busyUs) / completed : 0.0,
+           seconds(NativeHal::nowUs()), hostSeconds, seconds(NativeHal::nowUs()) / hostSeconds);
+    printf("[SIM] Axis steps: slider %lu, sealer %lu, mixing tool %lu, mixer %lu; EEPROM writes %lu\n",
+           sim.getStepCount(0), sim.getStepCount(1), sim.getStepCount(2), sim.getStepCount(3),
+           EEPROM.getWriteCount());
+#if PROFILER_ENABLED
+    NativeHal::setSerialOutput(stdout);
+    profiler.printReport(Serial);
+#endif
+
+    if (telemetryFile != nullptr) {
+        fclose(telemetryFile);
+    }
+    if (options.eepromPath != nullptr && !EEPROM.saveFile(options.eepromPath)) {
+        fprintf(stderr, "Could not save the EEPROM to %s\n", options.eepromPath);
+    }
+    return (completed == options.batches) ? 0 : 1;
+}
+
+#endif  // PIO_UNIT_TESTING
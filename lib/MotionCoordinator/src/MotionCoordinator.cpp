@@ -0,0 +1,138 @@
+#include "MotionCoordinator.h"
+
+/**
+ * @brief Construct a new MotionCoordinator object with no axes.
+ */
+MotionCoordinator::MotionCoordinator() {
+    this->axisCount = 0;
+    for (byte i = 0; i < MAX_AXES; i++) {
+        this->axes[i] = nullptr;
+    }
+}
+
+/**
+ * @brief Registers a stepper as one of the coordinated axes.
+ *
+ * @param stepper The stepper to add.
+ * @return true if the axis was added (or already was), false if all slots are taken.
+ */
+bool MotionCoordinator::addAxis(StepperController& stepper) {
+    for (byte i = 0; i < axisCount; i++) {
+        if (axes[i] == &stepper) {
+            return true;
+        }
+    }
+    if (axisCount >= MAX_AXES) {
+        return false;
+    }
+    axes[axisCount++] = &stepper;
+    return true;
+}
+
+/**
+ * @brief Initializes every registered axis.
+ *
+ * Configures the pins of each axis and attaches it to the step timer.
+ */
+void MotionCoordinator::init() {
+    for (byte i = 0; i < axisCount; i++) {
+        axes[i]->init();
+    }
+}
+
+/**
+ * @brief Starts a move of a given number of steps on one axis.
+ *
+ * @param stepper The axis to move.
+ * @param steps The number of steps to move; the sign gives the direction.
+ */
+void MotionCoordinator::moveTo(StepperController& stepper, long steps) {
+    stepper.moveTo(steps);
+}
+
+/**
+ * @brief Starts a move on one axis that ends when its limit switch is triggered.
+ *
+ * @param stepper The axis to move.
+ * @param steps The direction and nominal travel of the move.
+ * @param limitSwitch The limit switch that ends this axis' move.
+ * @param isCounted Whether the move ends normally after its steps, with the switch only guarding it.
+ */
+void MotionCoordinator::moveToLimit(StepperController& stepper, long steps, LimitSwitch& limitSwitch, bool isCounted) {
+    stepper.moveToLimit(steps, limitSwitch, isCounted);
+}
+
+/**
+ * @brief Starts a homing move on one axis; its position becomes 0 at the home switch.
+ *
+ * @param stepper The axis to home.
+ * @param steps The direction and nominal travel towards the home switch.
+ * @param homeSwitch The limit switch that marks the axis' home position.
+ */
+void MotionCoordinator::home(StepperController& stepper, long steps, LimitSwitch& homeSwitch) {
+    stepper.home(steps, homeSwitch);
+}
+
+/**
+ * @brief Starts a move on one axis to an absolute position relative to its home.
+ *
+ * @param stepper The axis to move.
+ * @param position The target position in steps.
+ */
+void MotionCoordinator::moveToPosition(StepperController& stepper, long position) {
+    stepper.moveToPosition(position);
+}
+
+/**
+ * @brief Checks whether any axis is still moving.
+ *
+ * @return true while at least one axis is moving.
+ */
+bool MotionCoordinator::isBusy() const {
+    for (byte i = 0; i < axisCount; i++) {
+        if (axes[i]->isBusy()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Services all running moves from the main loop.
+ *
+ * Every axis is polled on each call, not just the first busy one, so all of them are serviced together.
+ *
+ * @return true while at least one axis is still moving.
+ */
+bool MotionCoordinator::poll() {
+    bool isAnyBusy = false;
+    for (byte i = 0; i < axisCount; i++) {
+        if (axes[i]->poll()) {
+            isAnyBusy = true;
+        }
+    }
+    return isAnyBusy;
+}
+
+/**
+ * @brief Stops every axis after its current step.
+ */
+void MotionCoordinator::stop() {
+    for (byte i = 0; i < axisCount; i++) {
+        axes[i]->stop();
+    }
+}
+
+/**
+ * @brief Checks whether any axis' last limit or homing move ran out of travel.
+ *
+ * @return true if at least one axis reports a travel fault.
+ */
+bool MotionCoordinator::hasFault() const {
+    for (byte i = 0; i < axisCount; i++) {
+        if (axes[i]->hasFault()) {
+            return true;
+        }
+    }
+    return false;
+}
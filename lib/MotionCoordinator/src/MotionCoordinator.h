@@ -0,0 +1,112 @@
+/**
+ * @file MotionCoordinator.h
+ * @brief Header file for the MotionCoordinator class.
+ *
+ * This file contains the declaration of the MotionCoordinator class, which groups the machine's StepperController
+ * axes so several moves can run at the same time. Each axis keeps its own stop condition (a step count or a limit
+ * switch); the coordinator starts the moves, services them together and reports when all of them are done.
+ */
+
+#ifndef MOTIONCOORDINATOR_H
+#define MOTIONCOORDINATOR_H
+
+#include <Arduino.h>
+#include "StepperController.h"
+#include "LimitSwitch.h"
+
+/**
+ * @class MotionCoordinator
+ * @brief Runs moves on several stepper axes concurrently.
+ *
+ * Axes are registered once with addAxis(). Moves started through the coordinator return immediately, so a caller
+ * can start a move on every axis that has to travel and then wait for all of them with poll().
+ */
+class MotionCoordinator {
+public:
+    static const byte MAX_AXES = StepTimer::MAX_STEPPERS;  ///< One axis per step timer slot
+
+    /**
+     * @brief Construct a new MotionCoordinator object with no axes.
+     */
+    MotionCoordinator();
+
+    /**
+     * @brief Registers a stepper as one of the coordinated axes.
+     *
+     * @param stepper The stepper to add.
+     * @return true if the axis was added (or already was), false if all slots are taken.
+     */
+    bool addAxis(StepperController& stepper);
+
+    /**
+     * @brief Initializes every registered axis.
+     */
+    void init();
+
+    /**
+     * @brief Starts a move of a given number of steps on one axis.
+     *
+     * @param stepper The axis to move. It must have been registered with addAxis().
+     * @param steps The number of steps to move; the sign gives the direction.
+     */
+    void moveTo(StepperController& stepper, long steps);
+
+    /**
+     * @brief Starts a move on one axis that ends when its limit switch is triggered.
+     *
+     * @param stepper The axis to move. It must have been registered with addAxis().
+     * @param steps The direction and nominal travel of the move.
+     * @param limitSwitch The limit switch that ends this axis' move.
+     * @param isCounted Whether the move ends normally after its steps, with the switch only guarding it.
+     */
+    void moveToLimit(StepperController& stepper, long steps, LimitSwitch& limitSwitch, bool isCounted = false);
+
+    /**
+     * @brief Starts a homing move on one axis; its position becomes 0 at the home switch.
+     *
+     * @param stepper The axis to home. It must have been registered with addAxis().
+     * @param steps The direction and nominal travel towards the home switch.
+     * @param homeSwitch The limit switch that marks the axis' home position.
+     */
+    void home(StepperController& stepper, long steps, LimitSwitch& homeSwitch);
+
+    /**
+     * @brief Starts a move on one axis to an absolute position relative to its home.
+     *
+     * @param stepper The axis to move. Its position must be known.
+     * @param position The target position in steps.
+     */
+    void moveToPosition(StepperController& stepper, long position);
+
+    /**
+     * @brief Checks whether any axis is still moving.
+     *
+     * @return true while at least one axis is moving.
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief Services all running moves from the main loop.
+     *
+     * @return true while at least one axis is still moving, false once every move has finished.
+     */
+    bool poll();
+
+    /**
+     * @brief Stops every axis after its current step.
+     */
+    void stop();
+
+    /**
+     * @brief Checks whether any axis' last limit or homing move ran out of travel.
+     *
+     * @return true if at least one axis reports a travel fault.
+     */
+    bool hasFault() const;
+
+private:
+    StepperController* axes[MAX_AXES]; ///< Registered axes
+    byte axisCount;                     ///< Number of registered axes
+};
+
+#endif  // MOTIONCOORDINATOR_H
@@ -37,6 +37,15 @@ public:
      */
     void turnOn(int speed);
 
+    /**
+     * @brief Changes the speed of a running motor.
+     * 
+     * Does nothing while the motor is off; use turnOn() to start it.
+     * 
+     * @param speed The speed of the motor in percentage (0 to 100).
+     */
+    void setSpeed(int speed);
+
     /**
      * @brief Turns off the motor if it's currently on.
      */
@@ -22,6 +22,12 @@ void MotorController::turnOn(int speed) {
     }
 }
 
+void MotorController::setSpeed(int speed) {
+    if (isMotorOn) {  ///< Only a running motor has a speed to change
+        analogWrite(motorPwmPin, map(speed, 0, 100, 255 , 0));  ///< Same mapping as turnOn()
+    }
+}
+
 void MotorController::turnOff() {
     if (isMotorOn) {  ///< Check if the motor is on before turning it off
         digitalWrite(motorEnaPin, LOW);  ///< Disable the motor
@@ -0,0 +1,220 @@
+/**
+ * @file Arduino.h
+ * @brief The part of the Arduino API used by this project, implemented on the host for the native build.
+ *
+ * Flash and RAM share one address space on the host, so PROGMEM, F() and the _P functions map to plain memory.
+ * Pin, clock and serial calls go to the NativeHal layer (NativeHal.h), which runs them against virtual time and the
+ * attached hardware model. Only the native environment sees this file; the board build uses the real core.
+ */
+
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <type_traits>
+#include "NativeHal.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define NOT_AN_INTERRUPT -1
+
+/// Analog pins of the Arduino Mega
+enum : uint8_t {
+    A0 = 54, A1, A2, A3, A4, A5, A6, A7, A8, A9, A10, A11, A12, A13, A14, A15
+};
+
+// ======================= Program Memory =======================
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_float(address) (*(const float*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcasecmp_P strcasecmp
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(PSTR(text)))
+
+// ======================= Math =======================
+template <class T, class U>
+inline typename std::common_type<T, U>::type min(T a, U b) { return (a < b) ? a : b; }
+
+template <class T, class U>
+inline typename std::common_type<T, U>::type max(T a, U b) { return (a > b) ? a : b; }
+
+#define constrain(amount, low, high) ((amount) < (low) ? (low) : ((amount) > (high) ? (high) : (amount)))
+#define _BV(bit) (1U << (bit))
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ======================= Pins, Time and Interrupts =======================
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+int analogRead(uint8_t pin);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void noInterrupts();
+void interrupts();
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void detachInterrupt(uint8_t interrupt);
+
+// ======================= Print and Stream =======================
+/**
+ * @class Print
+ * @brief Text and number formatting on top of write(), as in the Arduino core.
+ */
+class Print {
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* text) { return (text == nullptr) ? 0 : write((const uint8_t*)text, strlen(text)); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    /**
+     * @brief Returns how many bytes can be written without blocking.
+     *
+     * @return 0 unless the output has a buffer, as in the Arduino core.
+     */
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const __FlashStringHelper* text);
+    size_t print(const char* text);
+    size_t print(char c);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const __FlashStringHelper* text);
+    size_t println(const char* text);
+    size_t println(char c);
+    size_t println(unsigned char value, int base = DEC);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+
+private:
+    /**
+     * @brief Prints an unsigned number in a base from 2 to 36.
+     */
+    size_t printNumber(unsigned long value, int base);
+};
+
+/**
+ * @class Stream
+ * @brief A Print that can also be read from.
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+/**
+ * @class HardwareSerial
+ * @brief A serial port whose output goes to a host file and whose input is queued with NativeHal::typeOnSerial().
+ *
+ * Output is taken at once, so availableForWrite() always reports the AVR's 63 free bytes of TX buffer.
+ */
+class HardwareSerial : public Stream {
+public:
+    static const int TX_BUFFER_FREE = 63;   ///< Free TX buffer of the AVR core when it is empty
+    static const int RX_BUFFER_SIZE = 64;   ///< RX buffer of the AVR core
+
+    /**
+     * @brief Construct a new HardwareSerial object.
+     *
+     * @param output Where written bytes go, or nullptr to discard them.
+     */
+    explicit HardwareSerial(FILE* output);
+
+    void begin(unsigned long baud);
+    void end() {}
+    void flush();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return TX_BUFFER_FREE; }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    operator bool() const { return true; }
+
+    /**
+     * @brief Sets where written bytes go.
+     *
+     * @param output Output file, or nullptr to discard them.
+     */
+    void setOutput(FILE* output);
+
+    /**
+     * @brief Adds received characters, dropping what does not fit in the RX buffer.
+     *
+     * @param text The characters.
+     */
+    void receive(const char* text);
+
+private:
+    FILE* output;                       ///< Destination of written bytes
+    char rxBuffer[RX_BUFFER_SIZE];      ///< Received characters not yet read
+    int rxHead;                         ///< Index of the next character to read
+    int rxCount;                        ///< Characters in the buffer
+};
+
+extern HardwareSerial Serial;   ///< USB serial port, the log and console
+extern HardwareSerial Serial1;  ///< TX1/RX1, the telemetry port
+
+#endif  // ARDUINO_H
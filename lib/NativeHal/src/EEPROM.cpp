@@ -0,0 +1,70 @@
+#include "EEPROM.h"
+
+EEPROMClass EEPROM;
+
+EEPROMClass::EEPROMClass() {
+    erase();
+    this->writeCount = 0;
+}
+
+uint8_t EEPROMClass::read(int address) const {
+    return (address >= 0 && address < SIZE) ? memory[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+    if (address >= 0 && address < SIZE) {
+        memory[address] = value;
+        writeCount++;
+    }
+}
+
+/**
+ * @brief Writes a byte only if it differs, like the AVR library, which spares the cell's write cycles.
+ */
+void EEPROMClass::update(int address, uint8_t value) {
+    if (read(address) != value) {
+        write(address, value);
+    }
+}
+
+/**
+ * @brief Erases every byte to 0xFF.
+ */
+void EEPROMClass::erase() {
+    memset(memory, 0xFF, sizeof(memory));
+}
+
+/**
+ * @brief Replaces the contents with a file saved by saveFile().
+ *
+ * @param path The file.
+ * @return true if the file was read; otherwise the contents are unchanged.
+ */
+bool EEPROMClass::loadFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t contents[SIZE];
+    bool isRead = fread(contents, 1, SIZE, file) == SIZE;
+    fclose(file);
+    if (isRead) {
+        memcpy(memory, contents, SIZE);
+    }
+    return isRead;
+}
+
+/**
+ * @brief Writes the contents to a file.
+ *
+ * @param path The file.
+ * @return true if the file was written.
+ */
+bool EEPROMClass::saveFile(const char* path) const {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool isWritten = fwrite(memory, 1, SIZE, file) == SIZE;
+    return fclose(file) == 0 && isWritten;
+}
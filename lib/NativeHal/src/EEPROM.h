@@ -0,0 +1,81 @@
+/**
+ * @file EEPROM.h
+ * @brief The Arduino EEPROM library on the host: 4 KB of RAM that starts erased (0xFF), like a new ATmega2560.
+ *
+ * The simulator can load and save the contents to keep them across runs, as the chip keeps them across power cuts.
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <Arduino.h>
+
+/**
+ * @class EEPROMClass
+ * @brief Byte-addressed persistent memory. Addresses outside the memory read as 0xFF and ignore writes.
+ */
+class EEPROMClass {
+public:
+    static const int SIZE = 4096;  ///< EEPROM size of the ATmega2560
+
+    EEPROMClass();
+
+    uint8_t read(int address) const;
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() const { return SIZE; }
+
+    template <typename T>
+    T& get(int address, T& value) const {
+        uint8_t* bytes = reinterpret_cast<uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bytes[i] = read(address + i);
+        }
+        return value;
+    }
+
+    template <typename T>
+    const T& put(int address, const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            update(address + i, bytes[i]);
+        }
+        return value;
+    }
+
+    /**
+     * @brief Erases every byte to 0xFF.
+     */
+    void erase();
+
+    /**
+     * @brief Replaces the contents with a file saved by saveFile().
+     *
+     * @param path The file.
+     * @return true if the file was read; otherwise the contents are unchanged.
+     */
+    bool loadFile(const char* path);
+
+    /**
+     * @brief Writes the contents to a file.
+     *
+     * @param path The file.
+     * @return true if the file was written.
+     */
+    bool saveFile(const char* path) const;
+
+    /**
+     * @brief Counts the bytes that have been written since start, to compare EEPROM wear between changes.
+     *
+     * @return Writes that changed or rewrote a byte (update() of an equal value does not count).
+     */
+    unsigned long getWriteCount() const { return writeCount; }
+
+private:
+    uint8_t memory[SIZE];        ///< Contents
+    unsigned long writeCount;    ///< Byte writes since start
+};
+
+extern EEPROMClass EEPROM;
+
+#endif  // EEPROM_H
@@ -0,0 +1,38 @@
+#include "HX711.h"
+
+HX711::HX711() {
+    this->dataPin = 0xFF;
+}
+
+void HX711::begin(byte dataPin, byte clockPin, byte gain) {
+    (void)gain;
+    this->dataPin = dataPin;
+    pinMode(dataPin, INPUT);
+    pinMode(clockPin, OUTPUT);
+}
+
+/**
+ * @brief Checks the data-ready line.
+ *
+ * @return true if a conversion is waiting.
+ */
+bool HX711::is_ready() {
+    HalDevice* device = NativeHal::device();
+    return device != nullptr && device->isLoadCellReady(dataPin);
+}
+
+/**
+ * @brief Waits for a conversion and clocks it out.
+ *
+ * @return The signed 24-bit reading.
+ */
+long HX711::read() {
+    while (!is_ready()) {
+        NativeHal::advance(100);
+        if (NativeHal::device() == nullptr) {
+            return 0;
+        }
+    }
+    NativeHal::advance(NativeHal::HX711_READ_US);
+    return NativeHal::device()->readLoadCell(dataPin);
+}
@@ -0,0 +1,33 @@
+/**
+ * @file HX711.h
+ * @brief The HX711 library on the host. Conversions come from the hardware model; each read takes the time of
+ * clocking the bits out (NativeHal::HX711_READ_US).
+ *
+ * Only the calls WeighingScale makes are provided; scaling and taring are done by WeighingScale itself.
+ */
+
+#ifndef HX711_H
+#define HX711_H
+
+#include <Arduino.h>
+
+/**
+ * @class HX711
+ * @brief 24-bit load cell ADC.
+ */
+class HX711 {
+public:
+    HX711();
+
+    void begin(byte dataPin, byte clockPin, byte gain = 128);
+    bool is_ready();
+    long read();
+    void set_gain(byte gain = 128) { (void)gain; }
+    void power_down() {}
+    void power_up() {}
+
+private:
+    byte dataPin;   ///< DOUT pin, which identifies the load cell to the hardware model
+};
+
+#endif  // HX711_H
@@ -0,0 +1,49 @@
+#include "LiquidCrystal_I2C.h"
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows) {
+    this->address = address;
+    this->cols = cols;
+    this->rows = rows;
+    this->col = 0;
+    this->row = 0;
+}
+
+void LiquidCrystal_I2C::init() {
+    clear();
+}
+
+/**
+ * @brief Fills the display with spaces. Takes about 2 ms on the HD44780.
+ */
+void LiquidCrystal_I2C::clear() {
+    HalDevice* device = NativeHal::device();
+    for (uint8_t r = 0; r < rows; r++) {
+        for (uint8_t c = 0; c < cols; c++) {
+            if (device != nullptr) {
+                device->onLcdWrite(address, c, r, ' ');
+            }
+        }
+    }
+    col = 0;
+    row = 0;
+    NativeHal::advance(2000);
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row) {
+    this->col = col;
+    this->row = (row < rows) ? row : rows - 1;
+    NativeHal::advance(NativeHal::LCD_BYTE_US);
+}
+
+/**
+ * @brief Writes a character at the cursor and moves the cursor right, as the HD44780 does.
+ */
+size_t LiquidCrystal_I2C::write(uint8_t c) {
+    HalDevice* device = NativeHal::device();
+    if (device != nullptr && col < cols) {
+        device->onLcdWrite(address, col, row, (char)c);
+    }
+    col++;
+    NativeHal::advance(NativeHal::LCD_BYTE_US);
+    return 1;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file LiquidCrystal_I2C.h
+ * @brief The LiquidCrystal_I2C library on the host. Characters are handed to the hardware model, and each one takes
+ * the I2C time of the real backpack (NativeHal::LCD_BYTE_US), so display costs show up in the profile.
+ */
+
+#ifndef LIQUIDCRYSTAL_I2C_H
+#define LIQUIDCRYSTAL_I2C_H
+
+#include <Arduino.h>
+
+/**
+ * @class LiquidCrystal_I2C
+ * @brief HD44780 character LCD behind a PCF8574 I2C backpack.
+ */
+class LiquidCrystal_I2C : public Print {
+public:
+    LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows);
+
+    void init();
+    void begin() { init(); }
+    void clear();
+    void home() { setCursor(0, 0); }
+    void setCursor(uint8_t col, uint8_t row);
+    void backlight() {}
+    void noBacklight() {}
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+private:
+    uint8_t address;  ///< I2C address of the backpack
+    uint8_t cols;     ///< Characters per row
+    uint8_t rows;     ///< Rows
+    uint8_t col;      ///< Cursor column
+    uint8_t row;      ///< Cursor row
+};
+
+#endif  // LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,261 @@
+#include "Arduino.h"
+
+namespace {
+
+HalDevice* attachedDevice = nullptr;       ///< Hardware model behind the pins
+uint64_t clockUs = 0;                      ///< Virtual time since start
+unsigned int clockReadCostUs = 1;          ///< Virtual time taken by each clock read
+bool isAdvancing = false;                  ///< Whether the device is being advanced
+
+uint8_t pinModes[NativeHal::PIN_COUNT];    ///< INPUT, OUTPUT or INPUT_PULLUP of each pin
+bool outputLevels[NativeHal::PIN_COUNT];   ///< Output latch of each pin
+bool inputLevels[NativeHal::PIN_COUNT];    ///< Level driven onto each pin from outside
+int analogOutputs[NativeHal::PIN_COUNT];   ///< Last PWM duty of each pin
+
+const uint8_t INTERRUPT_COUNT = 6;              ///< External interrupts of the Arduino Mega
+void (*interruptHandlers[INTERRUPT_COUNT])();   ///< Attached handler of each interrupt
+int interruptModes[INTERRUPT_COUNT];            ///< RISING, FALLING or CHANGE of each interrupt
+
+/**
+ * @brief Takes the virtual time of one clock read.
+ */
+void chargeClockRead() {
+    NativeHal::advance(clockReadCostUs);
+}
+
+}  // namespace
+
+namespace NativeHal {
+
+/**
+ * @brief Connects the hardware model. Pass nullptr to run with nothing attached.
+ *
+ * @param device The device, which must outlive the run.
+ */
+void attach(HalDevice* device) {
+    attachedDevice = device;
+}
+
+/**
+ * @brief Returns the attached hardware model.
+ *
+ * @return The device, or nullptr.
+ */
+HalDevice* device() {
+    return attachedDevice;
+}
+
+/**
+ * @brief Moves virtual time forward, handing it to the device in slices of at most MAX_ADVANCE_US.
+ *
+ * @param us Time to pass, in microseconds.
+ */
+void advance(unsigned long us) {
+    if (isAdvancing) {
+        return;  // Called from the device, e.g. a step interrupt reading the clock
+    }
+    isAdvancing = true;
+    while (us > 0) {
+        unsigned long slice = (us > MAX_ADVANCE_US) ? MAX_ADVANCE_US : us;
+        clockUs += slice;
+        us -= slice;
+        if (attachedDevice != nullptr) {
+            attachedDevice->advance(slice);
+        }
+    }
+    isAdvancing = false;
+}
+
+/**
+ * @brief Returns the virtual time without advancing it.
+ *
+ * @return Microseconds since start.
+ */
+uint64_t nowUs() {
+    return clockUs;
+}
+
+/**
+ * @brief Sets how much virtual time each millis() or micros() call takes.
+ *
+ * @param us Time per clock read, in microseconds (at least 1).
+ */
+void setClockReadCost(unsigned int us) {
+    clockReadCostUs = (us > 0) ? us : 1;
+}
+
+/**
+ * @brief Sets the level the outside world drives onto a pin, firing its external interrupt on a matching edge.
+ *
+ * @param pin The Arduino pin number.
+ * @param isHigh The level.
+ */
+void setInput(uint8_t pin, bool isHigh) {
+    if (pin >= PIN_COUNT || inputLevels[pin] == isHigh) {
+        return;
+    }
+    inputLevels[pin] = isHigh;
+
+    int interrupt = digitalPinToInterrupt(pin);
+    if (interrupt == NOT_AN_INTERRUPT || interruptHandlers[interrupt] == nullptr) {
+        return;
+    }
+    int mode = interruptModes[interrupt];
+    if (mode == CHANGE || (mode == RISING && isHigh) || (mode == FALLING && !isHigh)) {
+        interruptHandlers[interrupt]();
+    }
+}
+
+/**
+ * @brief Returns the level the program drives on an output pin.
+ *
+ * @param pin The Arduino pin number.
+ * @return true if the output latch is HIGH.
+ */
+bool getOutput(uint8_t pin) {
+    return pin < PIN_COUNT && outputLevels[pin];
+}
+
+/**
+ * @brief Returns the last PWM duty written to a pin.
+ *
+ * @param pin The Arduino pin number.
+ * @return Duty from 0 to 255.
+ */
+int getAnalogOutput(uint8_t pin) {
+    return (pin < PIN_COUNT) ? analogOutputs[pin] : 0;
+}
+
+/**
+ * @brief Sets where the text written to Serial goes.
+ *
+ * @param file Output file, or nullptr to discard it.
+ */
+void setSerialOutput(FILE* file) {
+    Serial.setOutput(file);
+}
+
+/**
+ * @brief Sets where the bytes written to Serial1 go.
+ *
+ * @param file Output file, or nullptr to discard them.
+ */
+void setSerial1Output(FILE* file) {
+    Serial1.setOutput(file);
+}
+
+/**
+ * @brief Queues text as if it had been typed into the serial monitor.
+ *
+ * @param text Characters to make available on Serial, including any line ending.
+ */
+void typeOnSerial(const char* text) {
+    Serial.receive(text);
+}
+
+}  // namespace NativeHal
+
+// ======================= Arduino API =======================
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < NativeHal::PIN_COUNT) {
+        pinModes[pin] = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin >= NativeHal::PIN_COUNT) {
+        return;
+    }
+    bool isHigh = (value != LOW);
+    if (outputLevels[pin] == isHigh) {
+        return;
+    }
+    outputLevels[pin] = isHigh;
+    if (attachedDevice != nullptr) {
+        attachedDevice->onDigitalWrite(pin, isHigh);
+    }
+}
+
+/**
+ * @brief Reads a pin: the outside level of an input, the latch of an output.
+ */
+int digitalRead(uint8_t pin) {
+    if (pin >= NativeHal::PIN_COUNT) {
+        return LOW;
+    }
+    if (pinModes[pin] == OUTPUT) {
+        return outputLevels[pin] ? HIGH : LOW;
+    }
+    return inputLevels[pin] ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+    if (pin >= NativeHal::PIN_COUNT) {
+        return;
+    }
+    analogOutputs[pin] = value;
+    if (attachedDevice != nullptr) {
+        attachedDevice->onAnalogWrite(pin, value);
+    }
+}
+
+int analogRead(uint8_t pin) {
+    (void)pin;
+    return 0;
+}
+
+unsigned long millis() {
+    chargeClockRead();
+    return (unsigned long)(clockUs / 1000);
+}
+
+unsigned long micros() {
+    chargeClockRead();
+    return (unsigned long)clockUs;
+}
+
+void delay(unsigned long ms) {
+    NativeHal::advance(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    NativeHal::advance(us);
+}
+
+void yield() {
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+/**
+ * @brief Maps a pin to its external interrupt, as on the Arduino Mega (INT0-INT5).
+ */
+int digitalPinToInterrupt(uint8_t pin) {
+    switch (pin) {
+        case 2: return 0;
+        case 3: return 1;
+        case 21: return 2;
+        case 20: return 3;
+        case 19: return 4;
+        case 18: return 5;
+        default: return NOT_AN_INTERRUPT;
+    }
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {
+    if (interrupt < INTERRUPT_COUNT) {
+        interruptHandlers[interrupt] = handler;
+        interruptModes[interrupt] = mode;
+    }
+}
+
+void detachInterrupt(uint8_t interrupt) {
+    if (interrupt < INTERRUPT_COUNT) {
+        interruptHandlers[interrupt] = nullptr;
+    }
+}
@@ -0,0 +1,187 @@
+/**
+ * @file NativeHal.h
+ * @brief Header file for the host hardware abstraction layer.
+ *
+ * This file contains the declaration of the HalDevice interface and the NativeHal functions, which back the Arduino
+ * API of the native build. The libraries and src/main.cpp keep calling digitalWrite(), millis(), EEPROM, Wire and
+ * the device drivers as they do on the board; in the native environment those calls land here instead of in the
+ * AVR core. Time is virtual: it only moves when the program reads the clock, waits or talks to a slow device, so a
+ * run is repeatable and not tied to the host's speed.
+ *
+ * Everything behind the pins is a HalDevice attached with NativeHal::attach(). It is told when outputs change and
+ * time passes, sets the levels of the input pins, and answers for the HX711, the I2C bus and the LCD. The machine
+ * model in lib/MachineSim is the device of the simulator.
+ */
+
+#ifndef NATIVEHAL_H
+#define NATIVEHAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @class HalDevice
+ * @brief The hardware connected to the pins and buses of the native build.
+ */
+class HalDevice {
+public:
+    virtual ~HalDevice() {}
+
+    /**
+     * @brief Moves the hardware forward in time.
+     *
+     * @param us Time that has passed, in microseconds.
+     */
+    virtual void advance(unsigned long us) = 0;
+
+    /**
+     * @brief Called when the program changes the level of an output pin.
+     *
+     * @param pin The Arduino pin number.
+     * @param isHigh The new level.
+     */
+    virtual void onDigitalWrite(uint8_t pin, bool isHigh) { (void)pin; (void)isHigh; }
+
+    /**
+     * @brief Called when the program sets the PWM duty of a pin.
+     *
+     * @param pin The Arduino pin number.
+     * @param value Duty from 0 to 255.
+     */
+    virtual void onAnalogWrite(uint8_t pin, int value) { (void)pin; (void)value; }
+
+    /**
+     * @brief Checks whether an I2C device answers at an address.
+     *
+     * @param address The 7-bit address.
+     * @return true if the device acknowledges.
+     */
+    virtual bool isI2cDevicePresent(uint8_t address) { (void)address; return false; }
+
+    /**
+     * @brief Called when a character is written to an I2C character LCD.
+     *
+     * @param address I2C address of the LCD.
+     * @param col Column of the character.
+     * @param row Row of the character.
+     * @param c The character.
+     */
+    virtual void onLcdWrite(uint8_t address, uint8_t col, uint8_t row, char c) {
+        (void)address; (void)col; (void)row; (void)c;
+    }
+
+    /**
+     * @brief Checks whether the HX711 on a data pin has a conversion ready.
+     *
+     * @param dataPin The HX711 DOUT pin.
+     * @return true if read() would return a new conversion.
+     */
+    virtual bool isLoadCellReady(uint8_t dataPin) { (void)dataPin; return false; }
+
+    /**
+     * @brief Takes the ready conversion of the HX711 on a data pin.
+     *
+     * @param dataPin The HX711 DOUT pin.
+     * @return The signed 24-bit reading.
+     */
+    virtual long readLoadCell(uint8_t dataPin) { (void)dataPin; return 0; }
+};
+
+/**
+ * @brief Control of the native build's virtual clock and pins, for the simulator.
+ */
+namespace NativeHal {
+
+const uint8_t PIN_COUNT = 70;             ///< Pins of the Arduino Mega
+const unsigned int MAX_ADVANCE_US = 1000; ///< Longest slice of time handed to the device at once
+const unsigned int LCD_BYTE_US = 500;     ///< I2C time of one LCD character through the PCF8574 backpack
+const unsigned int HX711_READ_US = 80;    ///< Time to clock 25 bits out of the HX711
+
+/**
+ * @brief Connects the hardware model. Pass nullptr to run with nothing attached.
+ *
+ * @param device The device, which must outlive the run.
+ */
+void attach(HalDevice* device);
+
+/**
+ * @brief Returns the attached hardware model.
+ *
+ * @return The device, or nullptr.
+ */
+HalDevice* device();
+
+/**
+ * @brief Moves virtual time forward, handing it to the device in slices of at most MAX_ADVANCE_US.
+ *
+ * Calls made while the device is advancing (e.g. a step interrupt reading the clock) do not move time again.
+ *
+ * @param us Time to pass, in microseconds.
+ */
+void advance(unsigned long us);
+
+/**
+ * @brief Returns the virtual time without advancing it.
+ *
+ * @return Microseconds since start, in 64 bits so long runs do not wrap.
+ */
+uint64_t nowUs();
+
+/**
+ * @brief Sets how much virtual time each millis() or micros() call takes.
+ *
+ * Polling loops only make progress because reading the clock costs time. The default of 1 us is close to the
+ * cost of micros() on a 16 MHz AVR.
+ *
+ * @param us Time per clock read, in microseconds (at least 1).
+ */
+void setClockReadCost(unsigned int us);
+
+/**
+ * @brief Sets the level the outside world drives onto a pin, firing its external interrupt on a matching edge.
+ *
+ * @param pin The Arduino pin number.
+ * @param isHigh The level.
+ */
+void setInput(uint8_t pin, bool isHigh);
+
+/**
+ * @brief Returns the level the program drives on an output pin.
+ *
+ * @param pin The Arduino pin number.
+ * @return true if the output latch is HIGH.
+ */
+bool getOutput(uint8_t pin);
+
+/**
+ * @brief Returns the last PWM duty written to a pin.
+ *
+ * @param pin The Arduino pin number.
+ * @return Duty from 0 to 255.
+ */
+int getAnalogOutput(uint8_t pin);
+
+/**
+ * @brief Sets where the text written to Serial goes.
+ *
+ * @param file Output file, or nullptr to discard it. Defaults to stdout.
+ */
+void setSerialOutput(FILE* file);
+
+/**
+ * @brief Sets where the bytes written to Serial1 go.
+ *
+ * @param file Output file, or nullptr to discard them (the default).
+ */
+void setSerial1Output(FILE* file);
+
+/**
+ * @brief Queues text as if it had been typed into the serial monitor.
+ *
+ * @param text Characters to make available on Serial, including any line ending.
+ */
+void typeOnSerial(const char* text);
+
+}  // namespace NativeHal
+
+#endif  // NATIVEHAL_H
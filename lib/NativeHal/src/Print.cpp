@@ -0,0 +1,198 @@
+#include "Arduino.h"
+
+HardwareSerial Serial(stdout);
+HardwareSerial Serial1(nullptr);
+
+// ======================= Print =======================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (size-- > 0) {
+        count += write(*buffer++);
+    }
+    return count;
+}
+
+size_t Print::print(const __FlashStringHelper* text) {
+    return write(reinterpret_cast<const char*>(text));
+}
+
+size_t Print::print(const char* text) {
+    return write(text);
+}
+
+size_t Print::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char value, int base) {
+    return print((unsigned long)value, base);
+}
+
+size_t Print::print(int value, int base) {
+    return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+    return print((unsigned long)value, base);
+}
+
+/**
+ * @brief Prints a signed number; like the Arduino core, only base 10 shows a minus sign.
+ */
+size_t Print::print(long value, int base) {
+    if (base == DEC && value < 0) {
+        return print('-') + printNumber(0UL - (unsigned long)value, DEC);
+    }
+    return printNumber((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+    return printNumber(value, base);
+}
+
+size_t Print::print(double value, int digits) {
+    if (isnan(value)) {
+        return print("nan");
+    }
+    if (isinf(value)) {
+        return print("inf");
+    }
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return print(text);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper* text) {
+    return print(text) + println();
+}
+
+size_t Print::println(const char* text) {
+    return print(text) + println();
+}
+
+size_t Print::println(char c) {
+    return print(c) + println();
+}
+
+size_t Print::println(unsigned char value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(int value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+    return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits) {
+    return print(value, digits) + println();
+}
+
+/**
+ * @brief Prints an unsigned number in a base from 2 to 36.
+ */
+size_t Print::printNumber(unsigned long value, int base) {
+    if (base < 2 || base > 36) {
+        base = DEC;
+    }
+    char text[8 * sizeof(unsigned long) + 1];
+    char* p = &text[sizeof(text) - 1];
+    *p = '\0';
+    do {
+        char digit = value % base;
+        value /= base;
+        *--p = (digit < 10) ? digit + '0' : digit + 'A' - 10;
+    } while (value > 0);
+    return write(p);
+}
+
+// ======================= HardwareSerial =======================
+
+/**
+ * @brief Construct a new HardwareSerial object.
+ *
+ * @param output Where written bytes go, or nullptr to discard them.
+ */
+HardwareSerial::HardwareSerial(FILE* output) {
+    this->output = output;
+    this->rxHead = 0;
+    this->rxCount = 0;
+}
+
+void HardwareSerial::begin(unsigned long baud) {
+    (void)baud;
+}
+
+void HardwareSerial::flush() {
+    if (output != nullptr) {
+        fflush(output);
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    if (output != nullptr) {
+        fputc(c, output);
+    }
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    if (output != nullptr) {
+        fwrite(buffer, 1, size, output);
+    }
+    return size;
+}
+
+int HardwareSerial::available() {
+    return rxCount;
+}
+
+int HardwareSerial::read() {
+    if (rxCount == 0) {
+        return -1;
+    }
+    char c = rxBuffer[rxHead];
+    rxHead = (rxHead + 1) % RX_BUFFER_SIZE;
+    rxCount--;
+    return (uint8_t)c;
+}
+
+int HardwareSerial::peek() {
+    return (rxCount == 0) ? -1 : (uint8_t)rxBuffer[rxHead];
+}
+
+/**
+ * @brief Sets where written bytes go.
+ *
+ * @param output Output file, or nullptr to discard them.
+ */
+void HardwareSerial::setOutput(FILE* output) {
+    this->output = output;
+}
+
+/**
+ * @brief Adds received characters, dropping what does not fit in the RX buffer.
+ *
+ * @param text The characters.
+ */
+void HardwareSerial::receive(const char* text) {
+    for (; *text != '\0' && rxCount < RX_BUFFER_SIZE; text++) {
+        rxBuffer[(rxHead + rxCount) % RX_BUFFER_SIZE] = *text;
+        rxCount++;
+    }
+}
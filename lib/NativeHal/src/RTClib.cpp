@@ -0,0 +1,99 @@
+#include "RTClib.h"
+
+namespace {
+
+bool isClockSet = false;        ///< Whether adjust() has been called
+uint32_t setUnixTime = 0;       ///< Time given to adjust()
+uint64_t setAtUs = 0;           ///< Virtual time of the adjust() call
+
+/**
+ * @brief Counts the days from 1970-01-01 to a date (proleptic Gregorian calendar).
+ */
+long daysFromCivil(int year, unsigned month, unsigned day) {
+    year -= (month <= 2) ? 1 : 0;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = (unsigned)(year - era * 400);
+    unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (long)dayOfEra - 719468;
+}
+
+}  // namespace
+
+DateTime::DateTime(uint32_t unixTime) {
+    long days = unixTime / 86400;
+    uint32_t seconds = unixTime % 86400;
+    this->hourValue = seconds / 3600;
+    this->minuteValue = (seconds / 60) % 60;
+    this->secondValue = seconds % 60;
+
+    // Civil date from days since 1970 (inverse of daysFromCivil)
+    days += 719468;
+    long era = days / 146097;
+    unsigned dayOfEra = (unsigned)(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    this->dayValue = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    this->monthValue = (monthIndex < 10) ? monthIndex + 3 : monthIndex - 9;
+    this->yearValue = yearOfEra + era * 400 + (this->monthValue <= 2 ? 1 : 0);
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute, uint8_t second) {
+    this->yearValue = year;
+    this->monthValue = month;
+    this->dayValue = day;
+    this->hourValue = hour;
+    this->minuteValue = minute;
+    this->secondValue = second;
+}
+
+/**
+ * @brief Construct a DateTime from the compiler's __DATE__ ("May  4 2025") and __TIME__ ("12:34:56").
+ */
+DateTime::DateTime(const __FlashStringHelper* date, const __FlashStringHelper* time) {
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    const char* dateText = reinterpret_cast<const char*>(date);
+    const char* timeText = reinterpret_cast<const char*>(time);
+
+    this->monthValue = 1;
+    for (uint8_t i = 0; i < 12; i++) {
+        if (strncmp(dateText, months + 3 * i, 3) == 0) {
+            this->monthValue = i + 1;
+        }
+    }
+    this->dayValue = atoi(dateText + 4);
+    this->yearValue = atoi(dateText + 7);
+    this->hourValue = atoi(timeText);
+    this->minuteValue = atoi(timeText + 3);
+    this->secondValue = atoi(timeText + 6);
+}
+
+uint32_t DateTime::unixtime() const {
+    return daysFromCivil(yearValue, monthValue, dayValue) * 86400UL + hourValue * 3600UL + minuteValue * 60UL
+        + secondValue;
+}
+
+bool RTC_DS3231::begin() {
+    HalDevice* device = NativeHal::device();
+    return device != nullptr && device->isI2cDevicePresent(ADDRESS);
+}
+
+/**
+ * @brief Checks whether the clock stopped, which is the case until it is first set.
+ *
+ * @return true if the time has never been set.
+ */
+bool RTC_DS3231::lostPower() {
+    return !isClockSet;
+}
+
+void RTC_DS3231::adjust(const DateTime& time) {
+    isClockSet = true;
+    setUnixTime = time.unixtime();
+    setAtUs = NativeHal::nowUs();
+}
+
+DateTime RTC_DS3231::now() {
+    return DateTime(setUnixTime + (uint32_t)((NativeHal::nowUs() - setAtUs) / 1000000ULL));
+}
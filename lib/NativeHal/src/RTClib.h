@@ -0,0 +1,69 @@
+/**
+ * @file RTClib.h
+ * @brief The RTClib DS3231 driver on the host. The clock counts virtual time from the moment it was set and is
+ * found on the I2C bus only if the hardware model has a device at 0x68.
+ */
+
+#ifndef RTCLIB_H
+#define RTCLIB_H
+
+#include <Arduino.h>
+
+/**
+ * @class DateTime
+ * @brief A calendar date and time, stored as seconds since 1970-01-01 00:00:00.
+ */
+class DateTime {
+public:
+    /**
+     * @brief Construct a DateTime from seconds since 1970.
+     *
+     * @param unixTime Seconds since 1970-01-01 00:00:00.
+     */
+    DateTime(uint32_t unixTime = 0);
+
+    DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t minute = 0, uint8_t second = 0);
+
+    /**
+     * @brief Construct a DateTime from the compiler's __DATE__ ("May  4 2025") and __TIME__ ("12:34:56").
+     */
+    DateTime(const __FlashStringHelper* date, const __FlashStringHelper* time);
+
+    uint16_t year() const { return yearValue; }
+    uint8_t month() const { return monthValue; }
+    uint8_t day() const { return dayValue; }
+    uint8_t hour() const { return hourValue; }
+    uint8_t minute() const { return minuteValue; }
+    uint8_t second() const { return secondValue; }
+    uint32_t unixtime() const;
+
+private:
+    uint16_t yearValue;    ///< Year, e.g. 2025
+    uint8_t monthValue;    ///< Month, 1-12
+    uint8_t dayValue;      ///< Day of the month, 1-31
+    uint8_t hourValue;     ///< Hour, 0-23
+    uint8_t minuteValue;   ///< Minute, 0-59
+    uint8_t secondValue;   ///< Second, 0-59
+};
+
+/**
+ * @class RTC_DS3231
+ * @brief Battery-backed real-time clock.
+ */
+class RTC_DS3231 {
+public:
+    static const uint8_t ADDRESS = 0x68;   ///< I2C address of the DS3231
+
+    bool begin();
+
+    /**
+     * @brief Checks whether the clock stopped, which is the case until it is first set.
+     *
+     * @return true if the time has never been set.
+     */
+    bool lostPower();
+    void adjust(const DateTime& time);
+    DateTime now();
+};
+
+#endif  // RTCLIB_H
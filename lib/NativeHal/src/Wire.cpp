@@ -0,0 +1,33 @@
+#include "Wire.h"
+
+TwoWire Wire;
+
+TwoWire::TwoWire() {
+    this->address = 0;
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+    this->address = address;
+}
+
+/**
+ * @brief Ends a transmission.
+ *
+ * @return 0 if the device acknowledged, 2 if nothing answered at the address.
+ */
+uint8_t TwoWire::endTransmission(bool sendStop) {
+    (void)sendStop;
+    HalDevice* device = NativeHal::device();
+    return (device != nullptr && device->isI2cDevicePresent(address)) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+    (void)address;
+    (void)quantity;
+    return 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+    (void)c;
+    return 1;
+}
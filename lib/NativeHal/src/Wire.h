@@ -0,0 +1,44 @@
+/**
+ * @file Wire.h
+ * @brief The Arduino Wire (I2C master) library on the host. A transmission is acknowledged when the hardware model
+ * has a device at the address.
+ */
+
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <Arduino.h>
+
+/**
+ * @class TwoWire
+ * @brief I2C master. Written bytes are accepted and dropped; reads return nothing.
+ */
+class TwoWire : public Stream {
+public:
+    TwoWire();
+
+    void begin() {}
+    void setClock(uint32_t frequency) { (void)frequency; }
+    void beginTransmission(uint8_t address);
+
+    /**
+     * @brief Ends a transmission.
+     *
+     * @return 0 if the device acknowledged, 2 if nothing answered at the address (as the AVR library).
+     */
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+
+private:
+    uint8_t address;  ///< Address of the current transmission
+};
+
+extern TwoWire Wire;
+
+#endif  // WIRE_H
@@ -0,0 +1,203 @@
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+Profiler profiler;
+#endif
+
+/**
+ * @brief Construct a new Profiler object with an empty zone table.
+ */
+Profiler::Profiler() {
+    for (byte i = 0; i < MAX_ZONES; i++) {
+        zones[i].name = nullptr;
+        zones[i].startUs = 0;
+    }
+    reset();
+}
+
+/**
+ * @brief Names a zone; only named zones are reported.
+ *
+ * @param zone The zone id, below MAX_ZONES.
+ * @param name Name shown in the report.
+ */
+void Profiler::setName(byte zone, const __FlashStringHelper* name) {
+    if (zone < MAX_ZONES) {
+        zones[zone].name = name;
+    }
+}
+
+/**
+ * @brief Marks the start of a zone that is stopped by stop(), possibly from another function.
+ *
+ * Calling start() again before stop() restarts the zone, so an abandoned run is simply not recorded.
+ *
+ * @param zone The zone id.
+ */
+void Profiler::start(byte zone) {
+    if (zone < MAX_ZONES) {
+        zones[zone].startUs = micros();
+    }
+}
+
+/**
+ * @brief Records the time since the zone's start().
+ *
+ * @param zone The zone id.
+ */
+void Profiler::stop(byte zone) {
+    if (zone < MAX_ZONES) {
+        record(zone, micros() - zones[zone].startUs);
+    }
+}
+
+/**
+ * @brief Records one run of a zone.
+ *
+ * @param zone The zone id.
+ * @param durationUs How long the run took, in microseconds.
+ */
+void Profiler::record(byte zone, unsigned long durationUs) {
+    if (zone >= MAX_ZONES) {
+        return;
+    }
+    Zone& z = zones[zone];
+    z.count++;
+    z.totalUs += durationUs;
+    if (durationUs < z.minUs) {
+        z.minUs = durationUs;
+    }
+    if (durationUs > z.maxUs) {
+        z.maxUs = durationUs;
+    }
+    uint16_t& bucket = z.buckets[bucketOf(durationUs)];
+    if (bucket < 0xFFFF) {
+        bucket++;
+    }
+}
+
+/**
+ * @brief Clears the measurements of every zone, keeping the names.
+ */
+void Profiler::reset() {
+    for (byte i = 0; i < MAX_ZONES; i++) {
+        Zone& z = zones[i];
+        z.count = 0;
+        z.minUs = 0xFFFFFFFFUL;
+        z.maxUs = 0;
+        z.totalUs = 0;
+        memset(z.buckets, 0, sizeof(z.buckets));
+    }
+}
+
+/**
+ * @brief Formats the next line of the report: the count, minimum, mean and maximum of a named zone, or part of its
+ * histogram.
+ *
+ * Each zone starts with its summary line, followed by its histogram BUCKETS_PER_LINE buckets at a time. Empty
+ * buckets are left out, and each bucket is labelled with its upper bound:
+ *
+ *     [PROFILE] scale n=1200 min=180us mean=212us max=1460us
+ *     [PROFILE]  <256us:1187 <1024us:11 <4096us:2
+ *
+ * The cursor is the zone index times REPORT_STEPS, plus 0 for the summary or 1 + the first bucket of the next
+ * histogram line.
+ *
+ * @param cursor Position in the report, advanced past the line.
+ * @param line Buffer for the line, at least 79 characters.
+ * @return true if a line was formatted, false at the end of the report.
+ */
+bool Profiler::formatReport(byte& cursor, TextBuffer& line) const {
+    while (cursor < MAX_ZONES * REPORT_STEPS) {
+        byte zone = cursor / REPORT_STEPS;
+        byte step = cursor % REPORT_STEPS;
+        const Zone& z = zones[zone];
+        if (z.name == nullptr || (step > 0 && z.count == 0)) {
+            cursor = (zone + 1) * REPORT_STEPS;
+            continue;
+        }
+
+        line.append(F("[PROFILE] "));
+        if (step == 0) {
+            line.append(z.name).append(F(" n=")).appendInt(z.count);
+            if (z.count > 0) {
+                line.append(F(" min=")).appendInt(z.minUs);
+                line.append(F("us mean=")).appendInt((unsigned long)(z.totalUs / z.count));
+                line.append(F("us max=")).appendInt(z.maxUs).append(F("us"));
+            }
+            cursor++;
+            return true;
+        }
+
+        byte b = step - 1;
+        byte shown = 0;
+        for (; b < BUCKET_COUNT && shown < BUCKETS_PER_LINE; b++) {
+            if (z.buckets[b] == 0) {
+                continue;
+            }
+            if (b < BUCKET_COUNT - 1) {
+                line.append(F(" <")).appendInt(4UL << (2 * b));
+            } else {
+                line.append(F(" >=")).appendInt(4UL << (2 * (b - 1)));
+            }
+            line.append(F("us:")).appendInt(z.buckets[b]);
+            shown++;
+        }
+        while (b < BUCKET_COUNT && z.buckets[b] == 0) {
+            b++;
+        }
+        cursor = (b < BUCKET_COUNT) ? zone * REPORT_STEPS + 1 + b : (zone + 1) * REPORT_STEPS;
+        return true;
+    }
+    return false;
+}
+
+#if !defined(__AVR__)
+/**
+ * @brief Prints the whole report at once, e.g. at the end of a simulation.
+ *
+ * @param out Where to print, e.g. Serial.
+ */
+void Profiler::printReport(Print& out) const {
+    char buffer[80];
+    TextBuffer line(buffer, sizeof(buffer));
+    byte cursor = 0;
+    while (formatReport(cursor, line.clear())) {
+        out.println(line.c_str());
+    }
+}
+#endif
+
+/**
+ * @brief Finds the histogram bucket of a duration.
+ *
+ * @param durationUs The duration in microseconds.
+ * @return The bucket index: the number of times the duration can be divided by 4 before it drops below 4.
+ */
+byte Profiler::bucketOf(unsigned long durationUs) {
+    byte bucket = 0;
+    while (durationUs >= 4 && bucket < BUCKET_COUNT - 1) {
+        durationUs >>= 2;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Starts timing a zone.
+ *
+ * @param zone The zone id.
+ */
+ProfileScope::ProfileScope(byte zone) {
+    this->zone = zone;
+    this->startUs = micros();
+}
+
+/**
+ * @brief Records the time since construction.
+ */
+ProfileScope::~ProfileScope() {
+#if PROFILER_ENABLED
+    profiler.record(zone, micros() - startUs);
+#endif
+}
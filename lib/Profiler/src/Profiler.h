@@ -0,0 +1,169 @@
+/**
+ * @file Profiler.h
+ * @brief Header file for the Profiler class.
+ *
+ * This file contains the declaration of the Profiler class, which measures how long named parts of the program take.
+ * Each timing zone keeps its count, minimum, maximum and mean in a fixed table, plus a histogram of the durations, so
+ * rare slow runs show up next to the typical ones. formatReport() formats the table one line per call, so the
+ * firmware can send it through the Logger without holding up the loop.
+ *
+ * Time zones through the PROFILE_ macros. They compile to nothing unless PROFILER_ENABLED is 1, which is the default;
+ * build with -DPROFILER_ENABLED=0 to remove the profiler and its RAM entirely:
+ *
+ *     void serviceScale() {
+ *         PROFILE_SCOPE(ZONE_SCALE);  // Times the rest of the block
+ *         weighingScale.update();
+ *     }
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "TextBuffer.h"
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1  ///< Whether the PROFILE_ macros are compiled in
+#endif
+
+/**
+ * @class Profiler
+ * @brief Table of timing zones measured with micros().
+ *
+ * Durations go into BUCKET_COUNT histogram buckets that are four times wider each: bucket 0 holds runs under 4 us,
+ * bucket 1 runs under 16 us, and so on; the last bucket holds everything longer, from about 4 s. The mean is kept
+ * as a 64-bit total so long zones do not overflow it. Durations longer than about 71 minutes wrap around micros()
+ * and are not meaningful.
+ */
+class Profiler {
+public:
+    static const byte MAX_ZONES = 10;        ///< Size of the zone table
+    static const byte BUCKET_COUNT = 12;     ///< Histogram buckets per zone
+    static const byte BUCKETS_PER_LINE = 4;  ///< Histogram buckets per report line, so a line fits a log line
+
+    /**
+     * @brief Construct a new Profiler object with an empty zone table.
+     */
+    Profiler();
+
+    /**
+     * @brief Names a zone; only named zones are reported.
+     *
+     * @param zone The zone id, below MAX_ZONES.
+     * @param name Name shown in the report.
+     */
+    void setName(byte zone, const __FlashStringHelper* name);
+
+    /**
+     * @brief Marks the start of a zone that is stopped by stop(), possibly from another function.
+     *
+     * @param zone The zone id.
+     */
+    void start(byte zone);
+
+    /**
+     * @brief Records the time since the zone's start().
+     *
+     * @param zone The zone id.
+     */
+    void stop(byte zone);
+
+    /**
+     * @brief Records one run of a zone.
+     *
+     * @param zone The zone id.
+     * @param durationUs How long the run took, in microseconds.
+     */
+    void record(byte zone, unsigned long durationUs);
+
+    /**
+     * @brief Clears the measurements of every zone, keeping the names.
+     */
+    void reset();
+
+    /**
+     * @brief Formats the next line of the report: the count, minimum, mean and maximum of a named zone, or part of
+     * its histogram.
+     *
+     * A Logger reply source. Start with the cursor at 0 and call again until it returns false.
+     *
+     * @param cursor Position in the report, advanced past the line.
+     * @param line Buffer for the line, at least 79 characters.
+     * @return true if a line was formatted, false at the end of the report.
+     */
+    bool formatReport(byte& cursor, TextBuffer& line) const;
+
+#if !defined(__AVR__)
+    /**
+     * @brief Prints the whole report at once. Host builds only; the firmware sends it with formatReport().
+     *
+     * @param out Where to print, e.g. Serial.
+     */
+    void printReport(Print& out) const;
+#endif
+
+private:
+    /**
+     * @brief An entry of the zone table.
+     */
+    struct Zone {
+        const __FlashStringHelper* name;   ///< Name for the report, nullptr if unused
+        unsigned long startUs;             ///< Time of the last start() (micros)
+        unsigned long count;               ///< Number of recorded runs
+        unsigned long minUs;               ///< Shortest run (us)
+        unsigned long maxUs;               ///< Longest run (us)
+        unsigned long long totalUs;        ///< Sum of all runs (us)
+        uint16_t buckets[BUCKET_COUNT];    ///< Histogram of runs, saturating at 0xFFFF
+    };
+
+    /**
+     * @brief Finds the histogram bucket of a duration.
+     *
+     * @param durationUs The duration in microseconds.
+     * @return The bucket index.
+     */
+    static byte bucketOf(unsigned long durationUs);
+
+    static const byte REPORT_STEPS = 1 + BUCKET_COUNT;  ///< Cursor positions per zone: summary, then each bucket
+
+    Zone zones[MAX_ZONES];   ///< Zone table
+};
+
+/**
+ * @class ProfileScope
+ * @brief Records the time from its construction to the end of its block. Used by PROFILE_SCOPE().
+ */
+class ProfileScope {
+public:
+    /**
+     * @brief Starts timing a zone.
+     *
+     * @param zone The zone id.
+     */
+    ProfileScope(byte zone);
+
+    /**
+     * @brief Records the time since construction.
+     */
+    ~ProfileScope();
+
+private:
+    byte zone;               ///< Zone being timed
+    unsigned long startUs;   ///< Time of construction (micros)
+};
+
+#if PROFILER_ENABLED
+extern Profiler profiler;  ///< Timing zones of the program
+
+#define PROFILE_NAME(zone, name) profiler.setName(zone, F(name))
+#define PROFILE_SCOPE(zone) ProfileScope profileScope(zone)
+#define PROFILE_START(zone) profiler.start(zone)
+#define PROFILE_STOP(zone) profiler.stop(zone)
+#else
+#define PROFILE_NAME(zone, name) ((void)0)
+#define PROFILE_SCOPE(zone) ((void)0)
+#define PROFILE_START(zone) ((void)0)
+#define PROFILE_STOP(zone) ((void)0)
+#endif
+
+#endif  // PROFILER_H
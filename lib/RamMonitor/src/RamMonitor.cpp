@@ -0,0 +1,82 @@
+#include "RamMonitor.h"
+
+#if defined(__AVR__)
+extern char __heap_start;  ///< First byte after the static variables, where the heap starts (linker symbol)
+extern char* __brkval;     ///< Top of the heap, or 0 before the first allocation (avr-libc malloc)
+
+/**
+ * @brief Returns the first byte above the heap.
+ *
+ * @return The top of the heap, or its start if nothing was ever allocated.
+ */
+static char* heapTop() {
+    return (__brkval != 0) ? __brkval : &__heap_start;
+}
+#endif
+
+/**
+ * @brief Fills the free RAM with PAINT.
+ *
+ * The stack pointer addresses the next free byte, so everything from the heap top up to it is unused. Locals of
+ * this function sit above the stack pointer and are not touched.
+ */
+void RamMonitor::paint() {
+#if defined(__AVR__)
+    uint8_t oldSREG = SREG;
+    cli();
+    for (char* p = heapTop(); p < (char*)SP; p++) {
+        *p = PAINT;
+    }
+    SREG = oldSREG;
+#endif
+}
+
+/**
+ * @brief Returns the free RAM between the heap and the stack now.
+ *
+ * @return Free bytes, or 0 on the host.
+ */
+unsigned int RamMonitor::getFree() {
+#if defined(__AVR__)
+    char top;  ///< Lives at the current top of the stack
+    return (unsigned int)(&top - heapTop());
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Returns the least free RAM since paint().
+ *
+ * Counts the painted bytes from the heap top upwards; the first byte that lost its paint is the deepest the stack
+ * has reached. A stack byte that happens to hold PAINT can only make the count a few bytes too high.
+ *
+ * @return Free bytes at the low-water mark, or 0 on the host.
+ */
+unsigned int RamMonitor::getLowWater() {
+#if defined(__AVR__)
+    const char* p = heapTop();
+    const char* top = (const char*)SP;
+    unsigned int count = 0;
+    while (p < top && *(const volatile byte*)p == PAINT) {
+        p++;
+        count++;
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Returns the size of the heap.
+ *
+ * @return Bytes between the start and the top of the heap, or 0 on the host.
+ */
+unsigned int RamMonitor::getHeapSize() {
+#if defined(__AVR__)
+    return (unsigned int)(heapTop() - &__heap_start);
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,61 @@
+/**
+ * @file RamMonitor.h
+ * @brief Header file for the RamMonitor class.
+ *
+ * This file contains the declaration of the RamMonitor class, which measures how close the ATmega2560's 8 KB of
+ * RAM came to running out. The free RAM is the gap between the top of the heap and the stack; the stack grows down
+ * into it in deep calls and interrupts, and the heap grows up into it on every allocation. The firmware makes no
+ * heap allocations, so the gap should only shrink to the deepest stack ever used.
+ *
+ * paint() fills the gap with a known byte at start-up. Whatever the stack or heap later overwrites no longer holds
+ * it, so the untouched bytes left above the heap are the lowest the free RAM has been (the low-water mark).
+ */
+
+#ifndef RAMMONITOR_H
+#define RAMMONITOR_H
+
+#include <Arduino.h>
+
+/**
+ * @class RamMonitor
+ * @brief Free RAM and its low-water mark, measured by painting the unused RAM.
+ *
+ * Only the board has a stack and heap to measure; on the host every function returns 0.
+ */
+class RamMonitor {
+public:
+    static const byte PAINT = 0xA5;  ///< Byte written into the free RAM by paint()
+
+    /**
+     * @brief Fills the free RAM with PAINT, starting the low-water measurement.
+     *
+     * Call it first thing in setup(). Interrupts are held off while painting, so no interrupt can push onto the
+     * stack while the bytes under it are being written.
+     */
+    static void paint();
+
+    /**
+     * @brief Returns the free RAM between the heap and the stack now.
+     *
+     * @return Free bytes, or 0 on the host.
+     */
+    static unsigned int getFree();
+
+    /**
+     * @brief Returns the least free RAM since paint(), from the painted bytes the stack and heap never reached.
+     *
+     * Scans the painted RAM, so it takes a few milliseconds; call it from the console, not from a periodic task.
+     *
+     * @return Free bytes at the low-water mark, or 0 on the host.
+     */
+    static unsigned int getLowWater();
+
+    /**
+     * @brief Returns the size of the heap.
+     *
+     * @return Bytes allocated on the heap since start-up, which stays 0 while nothing calls malloc() or new.
+     */
+    static unsigned int getHeapSize();
+};
+
+#endif  // RAMMONITOR_H
@@ -1,4 +1,5 @@
 #include "RelayModule.h"
+#include "Logger.h"
 
 /**
  * @brief Constructor for the RelayModule class.
@@ -19,9 +20,7 @@ void RelayModule::init() {
     pinMode(relayPin, OUTPUT);
     digitalWrite(relayPin, HIGH);  // Active-low: HIGH = OFF
     _isOn = false;
-    Serial.print("Relay on pin ");
-    Serial.print(relayPin);
-    Serial.println(" initialized to OFF (HIGH)");
+    LOG_INFO("Relay on pin % initialized to OFF (HIGH)", relayPin);
 }
 
 /**
@@ -31,9 +30,7 @@ void RelayModule::turnOn() {
     if (!_isOn) {
         digitalWrite(relayPin, LOW);  // Active-low: LOW = ON
         _isOn = true;
-        Serial.print("Relay on pin ");
-        Serial.print(relayPin);
-        Serial.println(" turned ON (LOW)");
+        LOG_INFO("Relay on pin % turned ON (LOW)", relayPin);
     }
 }
 
@@ -44,9 +41,7 @@ void RelayModule::turnOff() {
     if (_isOn) {
         digitalWrite(relayPin, HIGH); // Active-low: HIGH = OFF
         _isOn = false;
-        Serial.print("Relay on pin ");
-        Serial.print(relayPin);
-        Serial.println(" turned OFF (HIGH)");
+        LOG_INFO("Relay on pin % turned OFF (HIGH)", relayPin);
     }
 }
 
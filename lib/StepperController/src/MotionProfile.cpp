@@ -0,0 +1,238 @@
+#include "MotionProfile.h"
+
+enum {
+    PHASE_IDLE,    ///< No move
+    PHASE_ACCEL,   ///< Speeding up from the start speed
+    PHASE_CRUISE,  ///< Running at the reached speed
+    PHASE_DECEL,   ///< Replaying the acceleration backwards
+    PHASE_CREEP    ///< Back at the start speed with steps left over
+};
+
+static const unsigned long NOT_REACHED = 0xFFFFFFFFUL;  ///< Update index of a phase that has not happened yet
+static const unsigned long STEP_THRESHOLD = MotionProfile::TICKS_PER_SECOND << 8;  ///< DDA overflow for one step
+
+/**
+ * @brief Construct a new MotionProfile object.
+ */
+MotionProfile::MotionProfile() {
+    this->maxSpeedQ8 = 0;
+    this->startSpeedQ8 = 0;
+    this->peakAccelQ8 = 0;
+    this->jerkQ8 = 0;
+    this->phase = PHASE_IDLE;
+    this->speedQ8 = 0;
+    this->accelQ8 = 0;
+    this->jerkSpeedQ8 = 0;
+    this->accumulator = 0;
+    this->updateTicks = 0;
+    this->update = 0;
+    this->jerkUpEnd = NOT_REACHED;
+    this->jerkDownStart = NOT_REACHED;
+    this->stepsLeft = 0;
+    this->accelSteps = 0;
+    this->isOpenEnded = false;
+}
+
+/**
+ * @brief Sets the profile limits.
+ *
+ * The acceleration and jerk are converted to per-update speed changes. For an S-curve the peak acceleration is
+ * rounded down to a whole number of jerk updates, so ramping the acceleration down returns it exactly to zero.
+ *
+ * @param maxSpeed Cruise speed (steps per second), clamped to MAX_SPEED.
+ * @param acceleration Maximum acceleration (steps per second squared). 0 disables the profile.
+ * @param jerk Maximum jerk (steps per second cubed). 0 gives a trapezoidal profile.
+ */
+void MotionProfile::configure(unsigned long maxSpeed, unsigned long acceleration, unsigned long jerk) {
+    if (maxSpeed > MAX_SPEED) {
+        maxSpeed = MAX_SPEED;
+    }
+    maxSpeedQ8 = maxSpeed << 8;
+
+    peakAccelQ8 = (unsigned long)(((unsigned long long)acceleration << 8) / UPDATES_PER_SECOND);
+    if (acceleration > 0 && peakAccelQ8 == 0) {
+        peakAccelQ8 = 1;
+    }
+
+    jerkQ8 = (unsigned long)(((unsigned long long)jerk << 8) / (UPDATES_PER_SECOND * UPDATES_PER_SECOND));
+    if (jerk > 0 && jerkQ8 == 0) {
+        jerkQ8 = 1;
+    }
+    if (jerkQ8 == 0 || jerkQ8 >= peakAccelQ8) {
+        jerkQ8 = peakAccelQ8;  ///< Trapezoid: full acceleration after the first update
+    } else {
+        peakAccelQ8 -= peakAccelQ8 % jerkQ8;
+    }
+}
+
+/**
+ * @brief Checks whether the profile has been configured.
+ *
+ * @return true if moves should follow the profile.
+ */
+bool MotionProfile::isEnabled() const {
+    return peakAccelQ8 > 0;
+}
+
+/**
+ * @brief Starts a new move at the given start speed.
+ *
+ * @param steps Number of steps in the move, or 0 for an open-ended move.
+ * @param startSpeed Speed at which the motor can start and stop without losing steps (steps per second).
+ */
+void MotionProfile::start(unsigned long steps, unsigned long startSpeed) {
+    startSpeedQ8 = startSpeed << 8;
+    if (startSpeedQ8 == 0) {
+        startSpeedQ8 = 1UL << 8;
+    }
+    if (startSpeedQ8 > maxSpeedQ8) {
+        startSpeedQ8 = maxSpeedQ8;
+    }
+
+    speedQ8 = startSpeedQ8;
+    accelQ8 = 0;
+    jerkSpeedQ8 = 0;
+    accumulator = 0;
+    updateTicks = 0;
+    update = 0;
+    jerkUpEnd = NOT_REACHED;
+    jerkDownStart = NOT_REACHED;
+    stepsLeft = steps;
+    accelSteps = 0;
+    isOpenEnded = (steps == 0);
+    phase = (speedQ8 < maxSpeedQ8) ? PHASE_ACCEL : PHASE_CRUISE;
+}
+
+/**
+ * @brief Advances the profile by one timer tick.
+ *
+ * Updates the speed every UPDATE_TICKS ticks, then adds the speed to the DDA accumulator. A step is due each time
+ * the accumulator passes one second's worth of ticks. Deceleration starts once the steps left are no more than the
+ * steps it took to accelerate, which also covers short moves that never reach the cruise speed.
+ *
+ * @return true if a step is due on this tick.
+ */
+bool MotionProfile::tick() {
+    if (phase == PHASE_IDLE) {
+        return false;
+    }
+
+    if (++updateTicks >= UPDATE_TICKS) {
+        updateTicks = 0;
+        if (phase == PHASE_ACCEL) {
+            accelerate();
+        } else if (phase == PHASE_DECEL) {
+            decelerate();
+        }
+    }
+
+    accumulator += speedQ8;
+    if (accumulator < STEP_THRESHOLD) {
+        return false;
+    }
+    accumulator -= STEP_THRESHOLD;
+
+    if (phase == PHASE_ACCEL) {
+        accelSteps++;
+    }
+    if (!isOpenEnded) {
+        if (--stepsLeft == 0) {
+            phase = PHASE_IDLE;
+        } else if ((phase == PHASE_ACCEL || phase == PHASE_CRUISE) && stepsLeft <= accelSteps) {
+            phase = PHASE_DECEL;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Applies one speed update of the acceleration phase and decides when to cruise or decelerate.
+ *
+ * The acceleration ramps up by the jerk each update until the peak, holds, then ramps down so the speed levels off
+ * at the cruise speed. The ramp-down starts once the speed is within the speed gained during the ramp-up of the
+ * cruise speed, or halfway to it if the peak acceleration was never reached.
+ */
+void MotionProfile::accelerate() {
+    if (update < jerkUpEnd) {
+        accelQ8 += jerkQ8;
+        if (accelQ8 >= peakAccelQ8) {
+            jerkUpEnd = update + 1;
+        }
+    } else if (update >= jerkDownStart) {
+        accelQ8 -= jerkQ8;
+    }
+    speedQ8 += accelQ8;
+    update++;
+
+    if (update == jerkUpEnd) {
+        jerkSpeedQ8 = speedQ8 - startSpeedQ8;
+    }
+
+    if (update > jerkDownStart) {
+        if (accelQ8 == 0) {
+            phase = PHASE_CRUISE;
+        }
+    } else if (update < jerkUpEnd) {
+        if (speedQ8 - startSpeedQ8 >= (maxSpeedQ8 - startSpeedQ8) / 2) {
+            jerkUpEnd = update;
+            jerkDownStart = update;
+        }
+    } else if (speedQ8 + jerkSpeedQ8 >= maxSpeedQ8) {
+        jerkDownStart = update;
+    }
+}
+
+/**
+ * @brief Undoes one speed update of the acceleration phase.
+ *
+ * Each step is the exact integer inverse of the matching accelerate() update, so the speed returns to the start
+ * speed when the replay reaches the first update.
+ */
+void MotionProfile::decelerate() {
+    if (update == 0) {
+        phase = PHASE_CREEP;
+        return;
+    }
+
+    update--;
+    speedQ8 -= accelQ8;
+    if (update < jerkUpEnd) {
+        accelQ8 -= jerkQ8;
+    } else if (update >= jerkDownStart) {
+        accelQ8 += jerkQ8;
+    }
+}
+
+/**
+ * @brief Starts decelerating now, to end the move early without losing steps.
+ *
+ * The deceleration replays the acceleration from wherever it got to, so it takes about as many steps as were taken
+ * while accelerating. A move that is already decelerating keeps its remaining steps.
+ *
+ * @return The steps left until the move ends back at the start speed, or 0 if it is already there and can stop
+ * at once.
+ */
+unsigned long MotionProfile::beginStop() {
+    if (phase == PHASE_IDLE || speedQ8 <= startSpeedQ8) {
+        phase = PHASE_IDLE;
+        return 0;
+    }
+    if (phase == PHASE_ACCEL || phase == PHASE_CRUISE) {
+        phase = PHASE_DECEL;
+        unsigned long decelSteps = (accelSteps > 0) ? accelSteps : 1;
+        if (isOpenEnded || stepsLeft > decelSteps) {
+            stepsLeft = decelSteps;
+        }
+        isOpenEnded = false;
+    }
+    return stepsLeft;
+}
+
+/**
+ * @brief Returns the current speed.
+ *
+ * @return The current speed in steps per second.
+ */
+unsigned long MotionProfile::getSpeed() const {
+    return speedQ8 >> 8;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file MotionProfile.h
+ * @brief Header file for the MotionProfile class.
+ *
+ * This file contains the declaration of the MotionProfile class, which turns a move of a given number of steps into
+ * an accelerate / cruise / decelerate speed profile. The profile is evaluated on every StepTimer tick using only
+ * integer additions and comparisons, so it is cheap enough to run inside the timer interrupt on an AVR.
+ *
+ * Speeds are kept in steps per second as Q24.8 fixed point. The speed is updated once every UPDATE_TICKS timer ticks
+ * and a digital differential analyzer (DDA) turns it into step pulses on every tick.
+ */
+
+#ifndef MOTIONPROFILE_H
+#define MOTIONPROFILE_H
+
+#include <Arduino.h>
+#include "StepTimer.h"
+
+/**
+ * @class MotionProfile
+ * @brief Trapezoidal or jerk-limited (S-curve) speed profile generator.
+ *
+ * The acceleration phase is recorded as it runs (the update index at which each jerk phase ended), and the
+ * deceleration replays it backwards with the exact inverse of each fixed-point update. The move therefore ends at
+ * the same start speed it began with, and the deceleration takes as many steps as the acceleration did.
+ */
+class MotionProfile {
+public:
+    static const unsigned int UPDATE_TICKS = 20;  ///< Timer ticks per speed update (1 ms at a 50 us tick)
+    static const unsigned long UPDATES_PER_SECOND = 1000000UL / (UPDATE_TICKS * StepTimer::TICK_US);
+    static const unsigned long TICKS_PER_SECOND = 1000000UL / StepTimer::TICK_US;
+    static const unsigned long MAX_SPEED = TICKS_PER_SECOND / 2;  ///< Fastest rate the timer can pulse (steps/s)
+
+    /**
+     * @brief Construct a new MotionProfile object.
+     *
+     * The profile is disabled until configure() is called with a non-zero acceleration.
+     */
+    MotionProfile();
+
+    /**
+     * @brief Sets the profile limits.
+     *
+     * @param maxSpeed Cruise speed (steps per second), clamped to MAX_SPEED.
+     * @param acceleration Maximum acceleration (steps per second squared). 0 disables the profile.
+     * @param jerk Maximum jerk (steps per second cubed) for an S-curve. 0 gives a trapezoidal profile.
+     */
+    void configure(unsigned long maxSpeed, unsigned long acceleration, unsigned long jerk = 0);
+
+    /**
+     * @brief Checks whether the profile has been configured.
+     *
+     * @return true if moves should follow the profile, false for a constant step interval.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Starts a new move at the given start speed.
+     *
+     * @param steps Number of steps in the move. 0 means an open-ended move (e.g. towards a limit switch), which
+     * accelerates to the cruise speed and never decelerates.
+     * @param startSpeed Speed at which the motor can start and stop without losing steps (steps per second).
+     */
+    void start(unsigned long steps, unsigned long startSpeed);
+
+    /**
+     * @brief Advances the profile by one timer tick.
+     *
+     * @return true if a step is due on this tick.
+     */
+    bool tick();
+
+    /**
+     * @brief Starts decelerating now, to end the move early without losing steps.
+     *
+     * @return The steps left until the move ends back at the start speed, or 0 if it is already there and can stop
+     * at once.
+     */
+    unsigned long beginStop();
+
+    /**
+     * @brief Returns the current speed.
+     *
+     * @return The current speed in steps per second.
+     */
+    unsigned long getSpeed() const;
+
+private:
+    /**
+     * @brief Applies one speed update of the acceleration phase and decides when to cruise or decelerate.
+     */
+    void accelerate();
+
+    /**
+     * @brief Undoes one speed update of the acceleration phase.
+     */
+    void decelerate();
+
+    unsigned long maxSpeedQ8;    ///< Cruise speed (Q24.8 steps/s)
+    unsigned long startSpeedQ8;  ///< Start and stop speed (Q24.8 steps/s)
+    unsigned long peakAccelQ8;   ///< Peak speed change per update (Q24.8 steps/s)
+    unsigned long jerkQ8;        ///< Change of the speed change per update (Q24.8 steps/s)
+
+    byte phase;                  ///< Current phase of the move
+    unsigned long speedQ8;       ///< Current speed (Q24.8 steps/s)
+    unsigned long accelQ8;       ///< Current speed change per update (Q24.8 steps/s)
+    unsigned long jerkSpeedQ8;   ///< Speed gained while the acceleration ramped up
+    unsigned long accumulator;   ///< DDA accumulator; a step is due when it reaches TICKS_PER_SECOND << 8
+    unsigned int updateTicks;    ///< Ticks since the last speed update
+
+    unsigned long update;        ///< Index of the current acceleration update
+    unsigned long jerkUpEnd;     ///< Update index where the acceleration stopped increasing
+    unsigned long jerkDownStart; ///< Update index where the acceleration started decreasing
+
+    unsigned long stepsLeft;     ///< Steps still to go, or 0 for an open-ended move
+    unsigned long accelSteps;    ///< Steps taken while accelerating
+    bool isOpenEnded;            ///< Whether the move has no step count
+};
+
+#endif  // MOTIONPROFILE_H
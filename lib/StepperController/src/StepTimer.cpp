@@ -0,0 +1,148 @@
+#include "StepTimer.h"
+#include "StepperController.h"
+
+StepperController* StepTimer::steppers[StepTimer::MAX_STEPPERS] = { nullptr };
+volatile byte StepTimer::stepperCount = 0;
+bool StepTimer::isStarted = false;
+volatile uint16_t StepTimer::maxTickCounts = 0;
+
+#if !defined(__AVR__)
+static unsigned long mockMicros = 0;  ///< Virtual time of the mock timer
+static unsigned long mockCarry = 0;   ///< Time advanced since the last mock tick
+#endif
+
+/**
+ * @brief Starts the periodic tick.
+ *
+ * On the ATmega2560, Timer1 runs in CTC mode with a prescaler of 8 (0.5 us per count) and raises the
+ * compare-match A interrupt every TICK_US microseconds. On the host the mock timer is driven by advance().
+ */
+void StepTimer::begin() {
+    if (isStarted) {
+        return;
+    }
+    isStarted = true;
+
+#if defined(__AVR__)
+    noInterrupts();
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS11);           ///< CTC mode, clk/8
+    TCNT1 = 0;
+    OCR1A = (F_CPU / 8 / 1000000UL) * TICK_US - 1;
+    TIMSK1 |= _BV(OCIE1A);                     ///< Enable compare-match A interrupt
+    interrupts();
+#endif
+}
+
+/**
+ * @brief Registers a stepper so it is serviced on every tick.
+ *
+ * @param stepper The stepper to attach.
+ * @return true if the stepper is attached (or already was), false if the table is full.
+ */
+bool StepTimer::attach(StepperController* stepper) {
+    for (byte i = 0; i < stepperCount; i++) {
+        if (steppers[i] == stepper) {
+            return true;
+        }
+    }
+    if (stepperCount >= MAX_STEPPERS) {
+        return false;
+    }
+
+    steppers[stepperCount] = stepper;
+    stepperCount = stepperCount + 1;  ///< Publish only after the slot is filled
+    return true;
+}
+
+/**
+ * @brief Restarts the tick after it stopped because every axis was idle.
+ *
+ * Timer1 keeps counting while its interrupt is off, so the first tick comes within TICK_US. A compare match flagged
+ * while the interrupt was off is cleared first, so it does not cut that tick short.
+ */
+void StepTimer::wake() {
+#if defined(__AVR__)
+    if ((TIMSK1 & _BV(OCIE1A)) == 0) {
+        TIFR1 = _BV(OCF1A);
+        TIMSK1 |= _BV(OCIE1A);
+    }
+#endif
+}
+
+/**
+ * @brief Returns the longest tick interrupt so far, from the compare match to the end of the handler.
+ *
+ * @return Time in microseconds; a tick that overran into the next one reports TICK_US. Always 0 on the host.
+ */
+unsigned int StepTimer::getMaxTickUs() {
+    noInterrupts();
+    uint16_t counts = maxTickCounts;
+    interrupts();
+#if defined(__AVR__)
+    return counts / (F_CPU / 8 / 1000000UL);
+#else
+    return counts;
+#endif
+}
+
+/**
+ * @brief Services the attached steppers that are moving or ending a pulse.
+ *
+ * Idle steppers are skipped before any call into them. When none is busy, the interrupt switches itself off until
+ * the next move calls wake(). On the board the time since the compare match is then read from Timer1, which CTC mode
+ * restarted at the match, to track the longest tick.
+ */
+void StepTimer::tick() {
+    byte count = stepperCount;
+    bool isAnyBusy = false;
+    for (byte i = 0; i < count; i++) {
+        StepperController* stepper = steppers[i];
+        if (!stepper->isMoving && !stepper->isPulseHigh) {
+            continue;
+        }
+        stepper->onTick(TICK_US);
+        isAnyBusy = true;
+    }
+
+#if defined(__AVR__)
+    if (!isAnyBusy) {
+        TIMSK1 &= ~_BV(OCIE1A);  ///< Nothing to step; wake() restarts the tick
+    }
+    uint16_t counts = (TIFR1 & _BV(OCF1A)) ? OCR1A + 1 : TCNT1;  ///< A pending match means this tick overran
+    if (counts > maxTickCounts) {
+        maxTickCounts = counts;
+    }
+#else
+    (void)isAnyBusy;  // The mock timer keeps ticking; advance() drives it
+#endif
+}
+
+#if defined(__AVR__)
+ISR(TIMER1_COMPA_vect) {
+    StepTimer::tick();
+}
+#else
+/**
+ * @brief Advances the mock timer by the given time, running every tick that falls inside it.
+ *
+ * @param us Time to advance, in microseconds.
+ */
+void StepTimer::advance(unsigned long us) {
+    mockCarry += us;
+    while (mockCarry >= TICK_US) {
+        mockCarry -= TICK_US;
+        mockMicros += TICK_US;
+        tick();
+    }
+}
+
+/**
+ * @brief Returns the virtual time of the mock timer.
+ *
+ * @return Microseconds elapsed since the mock timer started.
+ */
+unsigned long StepTimer::now() {
+    return mockMicros;
+}
+#endif
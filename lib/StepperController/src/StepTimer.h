@@ -0,0 +1,102 @@
+/**
+ * @file StepTimer.h
+ * @brief Header file for the StepTimer class.
+ *
+ * This file contains the declaration of the StepTimer class, which drives the step generation of every
+ * StepperController from a periodic hardware timer interrupt. On the ATmega2560 the timer is Timer1 in CTC mode;
+ * on any other target (host builds) a mock timer is compiled instead, which advances a virtual microsecond clock
+ * and runs the same tick handler so step timing can be checked without the board.
+ *
+ * Steps are timed on a fixed TICK_US grid, not scheduled to the microsecond: each step lands on the first tick at
+ * or after its due time, and the remainder carries over to the next step. The mean step rate is exact, but each
+ * interval is off by up to one tick (50 us), i.e. up to 10% at the machine's fastest 2000 steps/s.
+ *
+ * This 50 us resolution is an accepted deviation from scheduling every step edge to the microsecond. That would
+ * take an OCR1A compare per edge, and with four axes on one timer the interrupt would have to find the earliest
+ * next edge of all of them and reprogram the compare on every edge. The jitter it would remove never accumulates
+ * into drift, and it stays within what the drivers and the motors' start speeds tolerate; test_motion_profile
+ * checks every interval to within one tick.
+ *
+ * The tick only runs while an axis is moving or ending a pulse, and idle axes are skipped without calling into
+ * them; the longest tick is measured on the board and reported by getMaxTickUs().
+ */
+
+#ifndef STEPTIMER_H
+#define STEPTIMER_H
+
+#include <Arduino.h>
+
+class StepperController;
+
+/**
+ * @class StepTimer
+ * @brief Shared periodic tick that generates step pulses for all attached steppers in the background.
+ *
+ * Every tick the timer gives each busy StepperController a chance to end its current pulse and, when its
+ * step interval has elapsed, to start the next one. Steppers attach themselves in StepperController::init().
+ */
+class StepTimer {
+public:
+    static const byte MAX_STEPPERS = 4;     ///< Maximum number of steppers served by the timer
+    static const unsigned int TICK_US = 50; ///< Tick period in microseconds (20 kHz)
+
+    /**
+     * @brief Starts the periodic tick.
+     *
+     * Configures Timer1 for a TICK_US compare-match interrupt. Calling it more than once has no further effect.
+     */
+    static void begin();
+
+    /**
+     * @brief Registers a stepper so it is serviced on every tick.
+     *
+     * @param stepper The stepper to attach.
+     * @return true if the stepper is attached (or already was), false if the table is full.
+     */
+    static bool attach(StepperController* stepper);
+
+    /**
+     * @brief Restarts the tick after it stopped because every axis was idle.
+     *
+     * Called by StepperController when a move starts; safe to call with interrupts disabled.
+     */
+    static void wake();
+
+    /**
+     * @brief Returns the longest tick interrupt so far, from the compare match to the end of the handler.
+     *
+     * @return Time in microseconds; a tick that overran into the next one reports TICK_US. Always 0 on the host.
+     */
+    static unsigned int getMaxTickUs();
+
+    /**
+     * @brief Services the attached steppers that are moving or ending a pulse, for one tick.
+     *
+     * Called from the timer interrupt; exposed so the mock timer can drive it on the host.
+     */
+    static void tick();
+
+#if !defined(__AVR__)
+    /**
+     * @brief Advances the mock timer by the given time, running every tick that falls inside it.
+     *
+     * @param us Time to advance, in microseconds.
+     */
+    static void advance(unsigned long us);
+
+    /**
+     * @brief Returns the virtual time of the mock timer.
+     *
+     * @return Microseconds elapsed since the mock timer started.
+     */
+    static unsigned long now();
+#endif
+
+private:
+    static StepperController* steppers[MAX_STEPPERS]; ///< Attached steppers
+    static volatile byte stepperCount;                 ///< Number of attached steppers
+    static bool isStarted;                             ///< Whether the tick has been started
+    static volatile uint16_t maxTickCounts;            ///< Longest tick interrupt, in Timer1 counts
+};
+
+#endif  // STEPTIMER_H
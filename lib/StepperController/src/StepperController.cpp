@@ -11,72 +11,329 @@
  * @param _pulseInterval The time interval between pulses to control the speed of the motor (default is 1).
  * @param _positiveDirection Boolean to set the motor's positive direction (true for clockwise, false for counterclockwise).
  */
-StepperController::StepperController(byte _pulPin, byte _dirPin, int _pulseInterval, bool _positiveDirection) {
-    this->pulPin = _pulPin;
-    this->dirPin = _dirPin;
+StepperController::StepperController(byte _pulPin, byte _dirPin, int _pulseInterval, bool _positiveDirection)
+    : pulPin(_pulPin), dirPin(_dirPin) {
     this->pulseInterval = _pulseInterval;
     this->positiveDirection = _positiveDirection;
     this->currentPosition = 0;
+    this->elapsedUs = 0;
+    this->stepsRemaining = 0;
+    this->isMoving = false;
+    this->isPulseHigh = false;
+    this->stepDelta = 1;
+    this->stopSwitch = nullptr;
+    this->isHomingMove = false;
+    this->isCountedMove = false;
+    this->isLimitReached = false;
+    this->isTravelFault = false;
+    this->isProfiledMove = false;
+    this->moveIntervalUs = 0;
+    this->homingPhase = HOMING_IDLE;
+    this->homeSwitch = nullptr;
+    this->homingSteps = 0;
+    this->homingBackoffSteps = 0;
+    this->homingTouchIntervalUs = 0;
+    this->axisState = AXIS_POSITION_LOST;  ///< Unknown until the first homing move
+    setPulseInterval(_pulseInterval);
 }
 
 /**
  * @brief Initializes the stepper motor control pins.
  *
- * Configures the pins for pulse and direction as OUTPUT.
+ * Configures the pins for pulse and direction as OUTPUT, attaches the motor to the StepTimer and starts the
+ * timer tick.
  */
 void StepperController::init() {
-    pinMode(pulPin, OUTPUT);  ///< Set pulse pin as output
-    pinMode(dirPin, OUTPUT);  ///< Set direction pin as output
+    pinMode(pulPin.number(), OUTPUT);  ///< Set pulse pin as output
+    pinMode(dirPin.number(), OUTPUT);  ///< Set direction pin as output
+    pulPin.low();
+
+    StepTimer::attach(this);
+    StepTimer::begin();
 }
 
 /**
- * @brief Moves the stepper motor by a specific number of steps based on the sign of the steps.
+ * @brief Starts moving the stepper motor by a specific number of steps based on the sign of the steps.
  * 
  * The direction is determined by the sign of the `steps` value. Positive steps mean forward, and negative steps
- * mean reverse, depending on the `positiveDirection` setting.
+ * mean reverse, depending on the `positiveDirection` setting. The steps are generated by the StepTimer interrupt.
  * 
  * @param steps The number of steps to move the motor. A positive value moves the motor forward, and a negative 
  * value moves it in reverse.
  */
 void StepperController::moveTo(long steps) {
-    // Determine the direction based on steps and positiveDirection
-    bool dir = (steps > 0) ? positiveDirection : !positiveDirection;
-    digitalWrite(dirPin, dir ? HIGH : LOW);  ///< Set direction pin
-
-    for (long i = 0; i < abs(steps); i++) {
-        digitalWrite(pulPin, HIGH);  ///< Send pulse signal
-        delay(pulseInterval);
-        digitalWrite(pulPin, LOW);  ///< End pulse signal
-        delay(pulseInterval);
-    }
-
-    currentPosition += dir ? steps : -steps;  ///< Update current position based on direction
+    homingPhase = HOMING_IDLE;
+    startMove(steps, nullptr, stepIntervalUs, profile.isEnabled(), false);
 }
 
 /**
- * @brief Moves the stepper motor until a limit switch is triggered.
+ * @brief Starts moving the stepper motor until a limit switch is triggered.
  * 
  * Moves the motor based on the direction determined by the sign of `steps` until the limit switch is activated.
+ * If the switch is still not triggered after `abs(steps)` steps, the move stops with a travel fault and the
+ * position is marked as lost. A counted move ends normally there instead, with the position kept.
  * 
- * @param steps The number of steps to move the motor. A positive value moves the motor forward, and a negative 
- * value moves it in reverse.
+ * @param steps The maximum number of steps to move the motor. A positive value moves the motor forward, and a 
+ * negative value moves it in reverse.
  * @param limitSwitch A reference to the limit switch object to detect activation.
+ * @param isCounted Whether using up the steps is the normal end of the move rather than a fault.
+ */
+void StepperController::moveToLimit(long steps, LimitSwitch& limitSwitch, bool isCounted) {
+    homingPhase = HOMING_IDLE;
+    startMove(steps, &limitSwitch, stepIntervalUs, profile.isEnabled(), false, isCounted);
+}
+
+/**
+ * @brief Starts a homing move towards the home switch.
+ *
+ * Without a backoff (see setHomingBackoff()) this is a single limit move. With one, the axis approaches the switch
+ * at full speed, backs off by the backoff distance on first contact and touches the switch again at the slow touch
+ * interval; poll() advances these phases. When the final touch reaches the switch the position is reset to 0 and
+ * the axis becomes AXIS_HOMED.
+ *
+ * @param steps The direction and maximum travel towards the home switch.
+ * @param homeSwitch The limit switch that marks the home position.
+ */
+void StepperController::home(long steps, LimitSwitch& homeSwitch) {
+    this->homeSwitch = &homeSwitch;
+    this->homingSteps = steps;
+    if (homingBackoffSteps == 0) {
+        homingPhase = HOMING_TOUCH;
+        startMove(steps, &homeSwitch, stepIntervalUs, profile.isEnabled(), true);
+    } else {
+        homingPhase = HOMING_APPROACH;
+        startMove(steps, &homeSwitch, stepIntervalUs, profile.isEnabled(), false);
+    }
+}
+
+/**
+ * @brief Sets up two-speed homing for all following home() calls.
+ *
+ * @param backoffSteps Distance to back off after the fast approach touches the switch. 0 homes in a single move.
+ * @param touchIntervalUs Time between steps for the slow second touch (in microseconds).
+ */
+void StepperController::setHomingBackoff(unsigned long backoffSteps, unsigned long touchIntervalUs) {
+    this->homingBackoffSteps = backoffSteps;
+    unsigned long minimumUs = 2UL * StepTimer::TICK_US;
+    this->homingTouchIntervalUs = (touchIntervalUs < minimumUs) ? minimumUs : touchIntervalUs;
+}
+
+/**
+ * @brief Starts a move to an absolute position, relative to the home position.
+ *
+ * @param position The target position in steps.
+ */
+void StepperController::moveToPosition(long position) {
+    moveTo(position - getPosition());
+}
+
+/**
+ * @brief Checks whether a move is still running.
+ *
+ * @return true while step pulses are being generated.
  */
-void StepperController::moveToLimit(long steps, LimitSwitch& limitSwitch) {
+bool StepperController::isBusy() const {
+    return isMoving || homingPhase != HOMING_IDLE;
+}
+
+/**
+ * @brief Services the running move from the main loop.
+ *
+ * Starts the next phase of a two-speed homing move once the previous one has finished: the backoff after the fast
+ * approach touched the switch, then the slow touch. The touch is bounded to twice the backoff distance.
+ *
+ * @return true while the move is still running, false once it has finished.
+ */
+bool StepperController::poll() {
+    if (isMoving) {
+        return true;
+    }
+
+    long direction = (homingSteps > 0) ? 1 : -1;
+    switch (homingPhase) {
+        case HOMING_APPROACH:
+            if (!isLimitReached) {
+                homingPhase = HOMING_IDLE;  ///< Travel fault, already reported by the interrupt
+                return false;
+            }
+            homingPhase = HOMING_BACKOFF;
+            startMove(-direction * (long)homingBackoffSteps, nullptr, homingTouchIntervalUs, false, false);
+            return true;
+
+        case HOMING_BACKOFF:
+            homingPhase = HOMING_TOUCH;
+            startMove(direction * 2L * (long)homingBackoffSteps, homeSwitch, homingTouchIntervalUs, false, true);
+            return true;
+
+        case HOMING_TOUCH:
+            homingPhase = HOMING_IDLE;
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Stops the running move.
+ *
+ * Cutting the pulses of a motor running well above its start speed would let it overrun, so a profiled move is cut
+ * short to the steps its deceleration takes instead. The shortened move counts as a counted move: using up its
+ * steps is its normal end, not a travel fault.
+ */
+void StepperController::stop() {
+    homingPhase = HOMING_IDLE;
+    noInterrupts();
+    unsigned long rampSteps = (isMoving && isProfiledMove) ? profile.beginStop() : 0;
+    if (rampSteps == 0) {
+        isMoving = false;
+    } else {
+        if (stepsRemaining > (long)rampSteps) {
+            stepsRemaining = rampSteps;
+        }
+        isCountedMove = true;
+    }
+    interrupts();
+}
+
+/**
+ * @brief Checks whether the last limit or homing move ran out of travel before reaching its switch.
+ *
+ * @return true if the switch was not reached within the allowed steps.
+ */
+bool StepperController::hasFault() const {
+    return isTravelFault;
+}
+
+/**
+ * @brief Sets the direction pin and arms the interrupt for a new move.
+ *
+ * @param steps The signed number of steps to move.
+ * @param limitSwitch Limit switch that ends the move, or nullptr for a plain move.
+ * @param intervalUs Time between steps when the move does not follow the profile (in microseconds).
+ * @param isProfiled Whether the move follows the acceleration profile.
+ * @param isHoming Whether reaching the switch sets the home position.
+ * @param isCounted Whether a limit move ends normally when its steps run out (see moveToLimit()).
+ */
+void StepperController::startMove(long steps, LimitSwitch* limitSwitch, unsigned long intervalUs, bool isProfiled,
+                                  bool isHoming, bool isCounted) {
+    bool wasMoving = isMoving;
+    isMoving = false;  ///< Park the interrupt before touching the move state
+    if (wasMoving && isProfiledMove && profile.getSpeed() > 1000000UL / stepIntervalUs) {
+        axisState = AXIS_POSITION_LOST;  ///< Replaced at speed, so the motor may overrun the new move's first steps
+    }
+    if (stopSwitch != nullptr) {
+        stopSwitch->setTriggerHandler(nullptr, nullptr);  ///< Detach from the previous move's switch
+    }
+
     // Determine the direction based on steps and positiveDirection
     bool dir = (steps > 0) ? positiveDirection : !positiveDirection;
-    digitalWrite(dirPin, dir ? HIGH : LOW);  ///< Set direction pin
+    dirPin.write(dir);  ///< Set direction pin
 
-    long stepsTaken = 0;
-    while (!limitSwitch.isTriggered()) {  ///< Continue moving until limit switch is triggered
-        digitalWrite(pulPin, HIGH);  ///< Send pulse signal
-        delay(pulseInterval);
-        digitalWrite(pulPin, LOW);  ///< End pulse signal
-        delay(pulseInterval);
-        stepsTaken++;
+    noInterrupts();
+    stepDelta = (steps > 0) ? 1 : -1;
+    stepsRemaining = abs(steps);
+    stopSwitch = limitSwitch;
+    isHomingMove = isHoming;
+    isCountedMove = isCounted;
+    isLimitReached = false;
+    isTravelFault = false;
+    isProfiledMove = isProfiled;
+    moveIntervalUs = intervalUs;
+    if (axisState == AXIS_HOMED && steps != 0) {
+        axisState = AXIS_POSITION_KNOWN;  ///< Leaving the home switch; the steps are still counted
+    }
+    elapsedUs = 0;  ///< First step after one full interval, which also covers the direction setup time
+    if (isProfiled) {
+        profile.start((limitSwitch != nullptr && !isCounted) ? 0 : stepsRemaining, 1000000UL / stepIntervalUs);
+    }
+    if (limitSwitch != nullptr) {
+        limitSwitch->clearLatch();
+        limitSwitch->setTriggerHandler(&StepperController::onLimitTriggered, this);
     }
+    isMoving = (stepsRemaining > 0);
+    if (isMoving) {
+        StepTimer::wake();  ///< The tick stops while every axis is idle
+    }
+    interrupts();
+}
+
+/**
+ * @brief Called from the limit switch's pin interrupt when the switch closes.
+ *
+ * @param context The StepperController moving towards the switch.
+ */
+void StepperController::onLimitTriggered(void* context) {
+    static_cast<StepperController*>(context)->haltAtLimit();
+}
 
-    currentPosition += dir ? stepsTaken : -stepsTaken;  ///< Update current position based on direction
+/**
+ * @brief Ends a limit move because its switch has closed. Runs in interrupt context.
+ *
+ * A homing move sets the home position here, at the step where the switch was seen.
+ */
+void StepperController::haltAtLimit() {
+    if (!isMoving || stopSwitch == nullptr) {
+        return;
+    }
+    if (isHomingMove) {
+        currentPosition = 0;  ///< The home switch defines position 0
+        axisState = AXIS_HOMED;
+    }
+    isLimitReached = true;
+    isMoving = false;
+}
+
+/**
+ * @brief Advances the step generation by one timer tick. Runs in interrupt context.
+ *
+ * Ends the pulse started on the previous tick, then emits a new pulse once the step interval has elapsed. A limit
+ * move that has used up its steps without reaching the switch stops with a travel fault.
+ *
+ * @param tickUs The time elapsed since the previous tick (in microseconds).
+ */
+void StepperController::onTick(unsigned int tickUs) {
+    if (isPulseHigh) {
+        pulPin.low();  ///< End pulse signal
+        isPulseHigh = false;
+    }
+    if (!isMoving) {
+        return;
+    }
+
+    if (isProfiledMove) {
+        if (!profile.tick()) {
+            return;
+        }
+    } else {
+        elapsedUs += tickUs;
+        if (elapsedUs < moveIntervalUs) {
+            return;
+        }
+        elapsedUs -= moveIntervalUs;
+    }
+
+    if (stopSwitch != nullptr) {
+        if (stopSwitch->isLatched() || stopSwitch->isTriggered()) {  ///< Continue moving until limit switch is triggered
+            haltAtLimit();
+            return;
+        }
+        if (stepsRemaining <= 0) {
+            isTravelFault = true;  ///< Full travel without the switch: broken switch or stalled axis
+            axisState = AXIS_POSITION_LOST;
+            isMoving = false;
+            return;
+        }
+        if (--stepsRemaining <= 0 && isCountedMove) {
+            isMoving = false;  ///< Last step of a counted move that never reached its switch
+        }
+    } else if (--stepsRemaining <= 0) {
+        isMoving = false;  ///< Last step of a plain move
+    }
+
+    pulPin.high();  ///< Send pulse signal
+    isPulseHigh = true;
+    currentPosition += stepDelta;  ///< Update current position based on direction
 }
 
 /**
@@ -87,16 +344,100 @@ void StepperController::moveToLimit(long steps, LimitSwitch& limitSwitch) {
  * @return The current position of the stepper motor.
  */
 long StepperController::getPosition() const {
-    return currentPosition;  ///< Return the current position
+    noInterrupts();
+    long position = currentPosition;  ///< Read atomically, the interrupt updates it
+    interrupts();
+    return position;
+}
+
+/**
+ * @brief Returns how far the tracked position can be trusted.
+ *
+ * @return The current AxisState of the motor.
+ */
+AxisState StepperController::getAxisState() const {
+    return axisState;
+}
+
+/**
+ * @brief Checks whether the tracked position can be used for a relative move.
+ *
+ * @return true if the axis is homed or has only moved by counted steps since.
+ */
+bool StepperController::isPositionKnown() const {
+    return axisState != AXIS_POSITION_LOST;
+}
+
+/**
+ * @brief Checks whether the axis is resting on its home switch.
+ *
+ * @return true if the last move was a completed homing move.
+ */
+bool StepperController::isHomed() const {
+    return axisState == AXIS_HOMED;
+}
+
+/**
+ * @brief Marks the position as lost, e.g. after the drivers lost power or the motor stalled.
+ */
+void StepperController::invalidatePosition() {
+    axisState = AXIS_POSITION_LOST;
 }
 
 /**
  * @brief Sets the pulse interval for the stepper motor.
  * 
- * This modifies the time between pulses, which affects the speed of the motor.
+ * This modifies the time between pulses, which affects the speed of the motor. A step takes two intervals.
  * 
- * @param interval The time interval between pulses (in microseconds).
+ * @param interval The time interval between pulses (in milliseconds).
  */
 void StepperController::setPulseInterval(int interval) {
     this->pulseInterval = interval;  ///< Set the new pulse interval
+    setStepInterval(interval * 2000UL);
+}
+
+/**
+ * @brief Sets the time between two steps.
+ *
+ * @param intervalUs The time between steps (in microseconds).
+ */
+void StepperController::setStepInterval(unsigned long intervalUs) {
+    unsigned long minimumUs = 2UL * StepTimer::TICK_US;  ///< One tick high, at least one tick low
+    noInterrupts();
+    stepIntervalUs = (intervalUs < minimumUs) ? minimumUs : intervalUs;
+    interrupts();
+}
+
+/**
+ * @brief Enables an acceleration profile for all following moves.
+ *
+ * The start speed of each move is taken from the step interval, so the interval that was safe for a constant-speed
+ * move stays the speed the motor starts and stops at.
+ *
+ * @param maxSpeed Cruise speed (steps per second).
+ * @param acceleration Maximum acceleration (steps per second squared). 0 returns to a constant step interval.
+ * @param jerk Maximum jerk (steps per second cubed), or 0 for a trapezoidal profile.
+ */
+void StepperController::setMotionProfile(unsigned long maxSpeed, unsigned long acceleration, unsigned long jerk) {
+    noInterrupts();
+    profile.configure(maxSpeed, acceleration, jerk);
+    interrupts();
+}
+
+/**
+ * @brief Returns the current speed of the stepper motor.
+ *
+ * @return The speed in steps per second, or 0 if the motor is not moving.
+ */
+unsigned long StepperController::getSpeed() const {
+    if (!isMoving) {
+        return 0;
+    }
+    if (!profile.isEnabled()) {
+        return 1000000UL / stepIntervalUs;
+    }
+    noInterrupts();
+    unsigned long speed = profile.getSpeed();
+    interrupts();
+    return speed;
 }
@@ -7,7 +7,8 @@
  * motor to a target position, move it until a limit switch is triggered, and get the current position of the motor.
  * 
  * The motor's direction and pulse rate can be configured, and the current position is maintained relative to the 
- * motor's home position.
+ * motor's home position. Moves run in the background: the step pulses are generated by the StepTimer interrupt,
+ * so the caller starts a move and then polls for its completion.
  * 
  * @version 1.0
  * @date 2025-05-04
@@ -20,6 +21,18 @@
  
  #include <Arduino.h>
  #include "LimitSwitch.h"  ///< Include the LimitSwitch class for limit switch functionality
+ #include "StepTimer.h"    ///< Include the StepTimer class that generates the step pulses
+ #include "MotionProfile.h" ///< Include the MotionProfile class for acceleration ramps
+ #include "FastGpio.h"      ///< Include GpioPin for direct port register writes
+ 
+ /**
+  * @brief How far the tracked position of an axis can be trusted.
+  */
+ enum AxisState {
+     AXIS_POSITION_LOST,   ///< Never homed, or the motor may have moved without being stepped
+     AXIS_POSITION_KNOWN,  ///< Moved by counted steps since the last homing
+     AXIS_HOMED            ///< Resting on the home switch, position is 0
+ };
  
  /**
   * @class StepperController
@@ -46,15 +59,15 @@
      /**
       * @brief Initializes the stepper motor control pins.
       * 
-      * Configures the pins for pulse and direction as OUTPUT.
+      * Configures the pins for pulse and direction as OUTPUT, attaches the motor to the StepTimer and starts it.
       */
      void init();
  
      /**
-      * @brief Moves the stepper motor by a specific number of steps based on the sign of the steps.
+      * @brief Starts moving the stepper motor by a specific number of steps based on the sign of the steps.
       * 
       * The direction is determined by the sign of the `steps` value. Positive steps mean forward, and negative steps
-      * mean reverse.
+      * mean reverse. The call returns immediately; a move that is still running is replaced.
       * 
       * @param steps The number of steps to move the motor. A positive value moves the motor forward, and a negative 
       * value moves it in reverse.
@@ -62,15 +75,84 @@
      void moveTo(long steps);
  
      /**
-      * @brief Moves the stepper motor until a limit switch is triggered.
+      * @brief Starts moving the stepper motor until a limit switch is triggered.
       * 
       * Moves the motor based on the direction determined by the sign of `steps` until the limit switch is activated.
+      * The switch is checked before every step by the timer interrupt. The call returns immediately. If the switch is
+      * not reached within `abs(steps)` steps the move stops and hasFault() reports it.
+      *
+      * A counted move instead ends normally after `abs(steps)` steps, decelerating like moveTo(), and keeps the
+      * position; the switch only guards it, as when jogging an axis towards the end of its travel.
       * 
-      * @param steps The number of steps to move the motor. A positive value moves the motor forward, and a negative 
-      * value moves it in reverse.
+      * @param steps The maximum number of steps to move the motor. A positive value moves the motor forward, and a 
+      * negative value moves it in reverse.
       * @param limitSwitch A reference to the limit switch object to detect activation.
+      * @param isCounted Whether using up the steps is the normal end of the move rather than a fault.
+      */
+     void moveToLimit(long steps, LimitSwitch& limitSwitch, bool isCounted = false);
+ 
+     /**
+      * @brief Starts a homing move towards the home switch.
+      * 
+      * Works like moveToLimit(), but when the switch is reached the position is reset to 0 and the axis becomes
+      * AXIS_HOMED. With a backoff set (see setHomingBackoff()) the axis approaches fast, backs off on first contact
+      * and touches the switch again slowly; keep calling poll() to run the phases.
+      * 
+      * @param steps The direction and maximum travel towards the home switch.
+      * @param homeSwitch The limit switch that marks the home position.
       */
-     void moveToLimit(long steps, LimitSwitch& limitSwitch);
+     void home(long steps, LimitSwitch& homeSwitch);
+ 
+     /**
+      * @brief Sets up two-speed homing for all following home() calls.
+      * 
+      * @param backoffSteps Distance to back off after the fast approach touches the switch. 0 homes in a single move.
+      * @param touchIntervalUs Time between steps for the slow second touch (in microseconds).
+      */
+     void setHomingBackoff(unsigned long backoffSteps, unsigned long touchIntervalUs);
+ 
+     /**
+      * @brief Starts a move to an absolute position, relative to the home position.
+      * 
+      * Only meaningful while the position is known (see isPositionKnown()).
+      * 
+      * @param position The target position in steps.
+      */
+     void moveToPosition(long position);
+ 
+     /**
+      * @brief Checks whether a move is still running.
+      * 
+      * @return true while step pulses are being generated, false once the move has finished or was stopped.
+      */
+     bool isBusy() const;
+ 
+     /**
+      * @brief Services the running move from the main loop.
+      * 
+      * Call this repeatedly while waiting for a move, e.g. `while (stepper.poll()) { ... }`.
+      * 
+      * @return true while the move is still running, false once it has finished.
+      */
+     bool poll();
+ 
+     /**
+      * @brief Stops the running move.
+      *
+      * A profiled move above its start speed first decelerates to it, over about as many steps as it took to
+      * accelerate, so no steps are lost and the position stays known; isBusy() stays true until it has stopped.
+      * Any other move stops after the current step. A limit switch still ends the move on the way.
+      */
+     void stop();
+ 
+     /**
+      * @brief Checks whether the last limit or homing move ran out of travel before reaching its switch.
+      * 
+      * A fault also marks the position as lost.
+      * 
+      * @return true if the switch was not reached within the allowed steps.
+      */
+     bool hasFault() const;
  
      /**
       * @brief Returns the current position of the stepper motor.
@@ -81,21 +163,136 @@
       */
      long getPosition() const;
  
+     /**
+      * @brief Returns how far the tracked position can be trusted.
+      * 
+      * @return The current AxisState of the motor.
+      */
+     AxisState getAxisState() const;
+ 
+     /**
+      * @brief Checks whether the tracked position can be used for a relative move.
+      * 
+      * @return true if the axis is homed or has only moved by counted steps since.
+      */
+     bool isPositionKnown() const;
+ 
+     /**
+      * @brief Checks whether the axis is resting on its home switch.
+      * 
+      * @return true if the last move was a completed homing move.
+      */
+     bool isHomed() const;
+ 
+     /**
+      * @brief Marks the position as lost, e.g. after the drivers lost power or the motor stalled.
+      * 
+      * The axis has to be homed again before the position can be trusted.
+      */
+     void invalidatePosition();
+ 
      /**
       * @brief Sets the pulse interval for the stepper motor.
       * 
-      * This modifies the time between pulses, which affects the speed of the motor.
+      * This modifies the time between pulses, which affects the speed of the motor. A step takes two intervals
+      * (pulse high, then low).
       * 
-      * @param interval The time interval between pulses (in microseconds).
+      * @param interval The time interval between pulses (in milliseconds).
       */
      void setPulseInterval(int interval);
  
+     /**
+      * @brief Sets the time between two steps.
+      * 
+      * The interval is rounded to whole StepTimer ticks per step on average, with the remainder carried over to the
+      * next step. It is clamped to two ticks so every pulse has a low phase.
+      * 
+      * @param intervalUs The time between steps (in microseconds).
+      */
+     void setStepInterval(unsigned long intervalUs);
+ 
+     /**
+      * @brief Enables an acceleration profile for all following moves.
+      * 
+      * Moves start and end at the speed given by the step interval and ramp up to `maxSpeed` in between. A plain
+      * move decelerates back to the start speed before its last step; a limit move cruises until the switch.
+      * 
+      * @param maxSpeed Cruise speed (steps per second).
+      * @param acceleration Maximum acceleration (steps per second squared). 0 returns to a constant step interval.
+      * @param jerk Maximum jerk (steps per second cubed) for an S-curve, or 0 for a trapezoidal profile.
+      */
+     void setMotionProfile(unsigned long maxSpeed, unsigned long acceleration, unsigned long jerk = 0);
+ 
+     /**
+      * @brief Returns the current speed of the stepper motor.
+      * 
+      * @return The speed in steps per second, or 0 if the motor is not moving.
+      */
+     unsigned long getSpeed() const;
+ 
  private:
-     byte pulPin;         ///< Pin used for pulse signal
-     byte dirPin;         ///< Pin used for direction signal
+     friend class StepTimer;
+ 
+     /**
+      * @brief Advances the step generation by one timer tick. Runs in interrupt context.
+      * 
+      * @param tickUs The time elapsed since the previous tick (in microseconds).
+      */
+     void onTick(unsigned int tickUs);
+ 
+     /**
+      * @brief Called from the limit switch's pin interrupt when the switch closes.
+      * 
+      * @param context The StepperController moving towards the switch.
+      */
+     static void onLimitTriggered(void* context);
+ 
+     /**
+      * @brief Ends a limit move because its switch has closed. Runs in interrupt context.
+      */
+     void haltAtLimit();
+ 
+     /**
+      * @brief Sets the direction pin and arms the interrupt for a new move.
+      * 
+      * @param steps The signed number of steps to move.
+      * @param limitSwitch Limit switch that ends the move, or nullptr for a plain move.
+      * @param intervalUs Time between steps when the move does not follow the profile (in microseconds).
+      * @param isProfiled Whether the move follows the acceleration profile.
+      * @param isHoming Whether reaching the switch sets the home position.
+      * @param isCounted Whether a limit move ends normally when its steps run out (see moveToLimit()).
+      */
+     void startMove(long steps, LimitSwitch* limitSwitch, unsigned long intervalUs, bool isProfiled, bool isHoming,
+                    bool isCounted = false);
+ 
+     GpioPin pulPin;      ///< Pin used for pulse signal
+     GpioPin dirPin;      ///< Pin used for direction signal
      int pulseInterval;   ///< Time interval between pulses (controls motor speed)
      bool positiveDirection; ///< Boolean to set the motor's positive direction
-     long currentPosition; ///< Current position of the motor, relative to the home position
+     volatile long currentPosition; ///< Current position of the motor, relative to the home position
+ 
+     unsigned long stepIntervalUs;     ///< Time between steps, in microseconds
+     unsigned long elapsedUs;          ///< Time accumulated towards the next step (interrupt only)
+     volatile long stepsRemaining;     ///< Steps left in a plain move
+     volatile bool isMoving;           ///< Whether the interrupt is generating steps
+     volatile bool isPulseHigh;        ///< Whether the pulse pin is currently HIGH
+     int8_t stepDelta;                 ///< Position change per step (+1 or -1)
+     LimitSwitch* volatile stopSwitch; ///< Limit switch that ends the move, or nullptr
+     MotionProfile profile;            ///< Acceleration profile, used when enabled
+     volatile bool isHomingMove;       ///< Whether the running limit move sets the home position
+     volatile bool isCountedMove;      ///< Whether the running limit move ends normally when its steps run out
+     volatile bool isLimitReached;     ///< Whether the last limit move ended at its switch
+     volatile bool isTravelFault;      ///< Whether the last limit move ran out of steps
+     bool isProfiledMove;              ///< Whether the running move follows the profile
+     unsigned long moveIntervalUs;     ///< Time between steps of a constant-speed move
+     volatile AxisState axisState;     ///< How far currentPosition can be trusted
+ 
+     enum HomingPhase { HOMING_IDLE, HOMING_APPROACH, HOMING_BACKOFF, HOMING_TOUCH };
+     HomingPhase homingPhase;          ///< Current phase of a home() call
+     LimitSwitch* homeSwitch;          ///< Switch of the running home() call
+     long homingSteps;                 ///< Direction and maximum travel of the running home() call
+     unsigned long homingBackoffSteps; ///< Backoff distance for two-speed homing, 0 for single-speed
+     unsigned long homingTouchIntervalUs; ///< Time between steps of the slow touch
  };
  
  #endif  // STEPPERCONTROLLER_H
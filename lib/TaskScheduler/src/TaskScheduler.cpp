@@ -0,0 +1,195 @@
+#include "TaskScheduler.h"
+
+/**
+ * @brief Construct a new TaskScheduler object with an empty task table.
+ */
+TaskScheduler::TaskScheduler() {
+    this->taskCount = 0;
+    this->nestedUs = 0;
+    this->lastRunUs = 0;
+    this->maxLatencyUs = 0;
+}
+
+/**
+ * @brief Adds a task to the table.
+ *
+ * @param name Short name of the task for formatStats().
+ * @param callback Function to run.
+ * @param periodMs Time between runs in milliseconds, or 0 for a one-shot task started with runTaskIn().
+ * @param isEnabled Whether the task starts enabled.
+ * @return The task id, or NO_TASK if the table is full.
+ */
+int8_t TaskScheduler::addTask(const char* name, TaskCallback callback, unsigned long periodMs, bool isEnabled) {
+    if (taskCount >= MAX_TASKS) {
+        return NO_TASK;
+    }
+
+    Task& task = tasks[taskCount];
+    task.name = name;
+    task.callback = callback;
+    task.periodMs = periodMs;
+    task.nextRunMs = millis();
+    task.isEnabled = isEnabled;
+    task.isRunning = false;
+    task.runCount = 0;
+    task.totalUs = 0;
+    task.maxUs = 0;
+    return taskCount++;
+}
+
+/**
+ * @brief Enables a task; it runs on the next run().
+ *
+ * @param task The task id.
+ */
+void TaskScheduler::enableTask(int8_t task) {
+    runTaskIn(task, 0);
+}
+
+/**
+ * @brief Disables a task, cancelling its next run.
+ *
+ * @param task The task id.
+ */
+void TaskScheduler::disableTask(int8_t task) {
+    if (task >= 0 && task < taskCount) {
+        tasks[task].isEnabled = false;
+    }
+}
+
+/**
+ * @brief Enables a task and sets its next run.
+ *
+ * @param task The task id.
+ * @param delayMs Time until the task runs, in milliseconds.
+ */
+void TaskScheduler::runTaskIn(int8_t task, unsigned long delayMs) {
+    if (task >= 0 && task < taskCount) {
+        tasks[task].nextRunMs = millis() + delayMs;
+        tasks[task].isEnabled = true;
+    }
+}
+
+/**
+ * @brief Checks whether a task is enabled.
+ *
+ * @param task The task id.
+ * @return true if the task will run when its deadline passes.
+ */
+bool TaskScheduler::isTaskEnabled(int8_t task) const {
+    return task >= 0 && task < taskCount && tasks[task].isEnabled;
+}
+
+/**
+ * @brief Runs every enabled task whose deadline has passed.
+ *
+ * Deadlines are compared as a signed difference, so they keep working when millis() wraps around.
+ */
+void TaskScheduler::run() {
+    unsigned long nowUs = micros();
+    if (lastRunUs != 0 && nowUs - lastRunUs > maxLatencyUs) {
+        maxLatencyUs = nowUs - lastRunUs;
+    }
+    lastRunUs = nowUs;
+
+    for (byte i = 0; i < taskCount; i++) {
+        Task& task = tasks[i];
+        if (!task.isEnabled || task.isRunning || (long)(millis() - task.nextRunMs) < 0) {
+            continue;
+        }
+
+        if (task.periodMs == 0) {
+            task.isEnabled = false;  // One-shot
+        } else {
+            task.nextRunMs += task.periodMs;
+            if ((long)(millis() - task.nextRunMs) >= 0) {
+                task.nextRunMs = millis() + task.periodMs;  // Fell behind; skip the missed runs
+            }
+        }
+        runTask(task);
+    }
+}
+
+/**
+ * @brief Waits for the given time while running the other tasks.
+ *
+ * @param ms Time to wait, in milliseconds.
+ */
+void TaskScheduler::wait(unsigned long ms) {
+    unsigned long start = millis();
+    while (millis() - start < ms) {
+        run();
+    }
+}
+
+/**
+ * @brief Runs one task and records its run time.
+ *
+ * The time of tasks that ran nested inside this one (through wait()) is subtracted, so each task is charged only
+ * for its own work.
+ *
+ * @param task The task to run.
+ */
+void TaskScheduler::runTask(Task& task) {
+    unsigned long nestedBefore = nestedUs;
+    unsigned long start = micros();
+
+    task.isRunning = true;
+    task.callback();
+    task.isRunning = false;
+
+    unsigned long elapsed = (micros() - start) - (nestedUs - nestedBefore);
+    nestedUs += elapsed;
+    task.runCount++;
+    task.totalUs += elapsed;
+    if (elapsed > task.maxUs) {
+        task.maxUs = elapsed;
+    }
+}
+
+/**
+ * @brief Returns the longest time between two run() passes.
+ *
+ * @return The worst loop latency in microseconds since the last resetStats().
+ */
+unsigned long TaskScheduler::getMaxLatency() const {
+    return maxLatencyUs;
+}
+
+/**
+ * @brief Clears the run-time statistics of every task and the loop latency.
+ */
+void TaskScheduler::resetStats() {
+    for (byte i = 0; i < taskCount; i++) {
+        tasks[i].runCount = 0;
+        tasks[i].totalUs = 0;
+        tasks[i].maxUs = 0;
+    }
+    maxLatencyUs = 0;
+    lastRunUs = 0;
+}
+
+/**
+ * @brief Formats the run count and run times of the next task, or the loop latency after the last task.
+ *
+ * One line per task: name, runs, mean and longest run time in microseconds.
+ *
+ * @param cursor Index of the task, advanced past it; the task count stands for the latency line.
+ * @param line Buffer for the line.
+ * @return true if a line was formatted, false after the latency line.
+ */
+bool TaskScheduler::formatStats(byte& cursor, TextBuffer& line) const {
+    if (cursor > taskCount) {
+        return false;
+    }
+    if (cursor == taskCount) {
+        line.append(F("[TASK] max loop latency=")).appendInt(maxLatencyUs).append(F("us"));
+        cursor++;
+        return true;
+    }
+    const Task& task = tasks[cursor++];
+    line.append(F("[TASK] ")).append(task.name).append(F(" runs=")).appendInt(task.runCount);
+    line.append(F(" mean=")).appendInt(task.runCount > 0 ? task.totalUs / task.runCount : 0);
+    line.append(F("us max=")).appendInt(task.maxUs).append(F("us"));
+    return true;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file TaskScheduler.h
+ * @brief Header file for the TaskScheduler class.
+ *
+ * This file contains the declaration of the TaskScheduler class, a small cooperative scheduler for the main loop.
+ * Work is registered once as a fixed table of tasks, each with a period in milliseconds, and run() calls every task
+ * whose deadline has passed. Long sequences wait with wait() instead of delay(), which keeps running the other tasks
+ * in the meantime, so buttons, timeouts and sounds are serviced while a sequence is waiting for a motor.
+ */
+
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <Arduino.h>
+#include "TextBuffer.h"
+
+/**
+ * @class TaskScheduler
+ * @brief Cooperative scheduler with a fixed task table, millisecond deadlines and per-task run-time accounting.
+ *
+ * A periodic task runs every period milliseconds; a task with a period of 0 is a one-shot that runs once after
+ * runTaskIn() and then disables itself. A task that is running (including one that is waiting inside wait()) is
+ * never started again until it returns, so tasks do not need to be reentrant.
+ *
+ * Run times are measured with micros(). Time spent in tasks that run nested inside another task's wait() is
+ * charged to those tasks, not to the waiting one.
+ */
+class TaskScheduler {
+public:
+    static const byte MAX_TASKS = 12;  ///< Size of the task table
+    static const int8_t NO_TASK = -1;  ///< Returned by addTask() when the table is full
+
+    typedef void (*TaskCallback)();    ///< Function run by a task
+
+    /**
+     * @brief Construct a new TaskScheduler object with an empty task table.
+     */
+    TaskScheduler();
+
+    /**
+     * @brief Adds a task to the table.
+     *
+     * @param name Short name of the task for formatStats().
+     * @param callback Function to run.
+     * @param periodMs Time between runs in milliseconds, or 0 for a one-shot task started with runTaskIn().
+     * @param isEnabled Whether the task starts enabled. A periodic task first runs on the next run().
+     * @return The task id, or NO_TASK if the table is full.
+     */
+    int8_t addTask(const char* name, TaskCallback callback, unsigned long periodMs, bool isEnabled = true);
+
+    /**
+     * @brief Enables a task; it runs on the next run().
+     *
+     * @param task The task id.
+     */
+    void enableTask(int8_t task);
+
+    /**
+     * @brief Disables a task, cancelling its next run.
+     *
+     * @param task The task id.
+     */
+    void disableTask(int8_t task);
+
+    /**
+     * @brief Enables a task and sets its next run.
+     *
+     * @param task The task id.
+     * @param delayMs Time until the task runs, in milliseconds.
+     */
+    void runTaskIn(int8_t task, unsigned long delayMs);
+
+    /**
+     * @brief Checks whether a task is enabled.
+     *
+     * @param task The task id.
+     * @return true if the task will run when its deadline passes.
+     */
+    bool isTaskEnabled(int8_t task) const;
+
+    /**
+     * @brief Runs every enabled task whose deadline has passed. Call this from loop().
+     */
+    void run();
+
+    /**
+     * @brief Waits for the given time while running the other tasks.
+     *
+     * Use this instead of delay() inside tasks and setup code.
+     *
+     * @param ms Time to wait, in milliseconds.
+     */
+    void wait(unsigned long ms);
+
+    /**
+     * @brief Returns the longest time between two run() passes.
+     *
+     * @return The worst loop latency in microseconds since the last resetStats().
+     */
+    unsigned long getMaxLatency() const;
+
+    /**
+     * @brief Clears the run-time statistics of every task and the loop latency.
+     */
+    void resetStats();
+
+    /**
+     * @brief Formats the run count and run times of the next task, or the loop latency after the last task.
+     *
+     * A Logger reply source: one line per call, so the statistics never hold up the loop they measure.
+     *
+     * @param cursor Index of the task, advanced past it; the task count stands for the latency line.
+     * @param line Buffer for the line.
+     * @return true if a line was formatted, false after the latency line.
+     */
+    bool formatStats(byte& cursor, TextBuffer& line) const;
+
+private:
+    /**
+     * @brief An entry of the task table.
+     */
+    struct Task {
+        const char* name;          ///< Name for formatStats()
+        TaskCallback callback;     ///< Function to run
+        unsigned long periodMs;    ///< Time between runs (ms), 0 for one-shot
+        unsigned long nextRunMs;   ///< Deadline of the next run (millis)
+        bool isEnabled;            ///< Whether the task is scheduled
+        bool isRunning;            ///< Whether the task is inside its callback
+        unsigned long runCount;    ///< Number of completed runs
+        unsigned long totalUs;     ///< Total run time (us)
+        unsigned long maxUs;       ///< Longest run (us)
+    };
+
+    /**
+     * @brief Runs one task and records its run time.
+     *
+     * @param task The task to run.
+     */
+    void runTask(Task& task);
+
+    Task tasks[MAX_TASKS];         ///< Task table
+    byte taskCount;                ///< Number of tasks in the table
+    unsigned long nestedUs;        ///< Run time already charged to tasks, for excluding nested runs
+    unsigned long lastRunUs;       ///< Time of the last run() pass (micros)
+    unsigned long maxLatencyUs;    ///< Longest time between run() passes (us)
+};
+
+#endif  // TASKSCHEDULER_H
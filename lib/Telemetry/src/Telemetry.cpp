@@ -0,0 +1,150 @@
+#include "Telemetry.h"
+
+/**
+ * @brief Construct a new Telemetry object.
+ *
+ * @param out Port the records are sent on.
+ */
+Telemetry::Telemetry(Print& out) : out(out) {
+    this->length = 0;
+    this->isOverflow = false;
+    this->sequence = 0;
+    this->sentCount = 0;
+    this->dropCount = 0;
+}
+
+/**
+ * @brief Starts a record.
+ *
+ * @param type Record type, defined by the application.
+ * @param nowMs Time stamp of the record (millis).
+ */
+void Telemetry::beginFrame(byte type, unsigned long nowMs) {
+    length = 0;
+    isOverflow = false;
+    addByte(type);
+    addByte(sequence++);
+    addInt32((int32_t)nowMs);
+}
+
+/**
+ * @brief Appends a byte to the payload.
+ *
+ * @param value Value to append.
+ */
+void Telemetry::addByte(byte value) {
+    add(&value, 1);
+}
+
+/**
+ * @brief Appends a 16-bit value to the payload.
+ *
+ * @param value Value to append.
+ */
+void Telemetry::addInt16(int16_t value) {
+    byte data[2] = { (byte)value, (byte)(value >> 8) };
+    add(data, sizeof(data));
+}
+
+/**
+ * @brief Appends a 32-bit value to the payload.
+ *
+ * @param value Value to append.
+ */
+void Telemetry::addInt32(int32_t value) {
+    byte data[4] = { (byte)value, (byte)(value >> 8), (byte)(value >> 16), (byte)(value >> 24) };
+    add(data, sizeof(data));
+}
+
+/**
+ * @brief Appends a 32-bit float to the payload.
+ *
+ * Both the AVR and the host are little-endian, so the bytes are copied as they are.
+ *
+ * @param value Value to append.
+ */
+void Telemetry::addFloat(float value) {
+    byte data[sizeof(float)];
+    memcpy(data, &value, sizeof(data));
+    add(data, sizeof(data));
+}
+
+/**
+ * @brief Adds the CRC, encodes the record and sends it if the port has room.
+ *
+ * COBS replaces every 0x00 in the frame with the distance to the next one, so the only 0x00 on the wire is the
+ * delimiter. The encoding adds one byte per 254 bytes, plus the delimiter.
+ *
+ * @return true if the record was sent, false if it was dropped or its payload overflowed.
+ */
+bool Telemetry::endFrame() {
+    if (isOverflow) {
+        dropCount++;
+        return false;
+    }
+    uint16_t check = Crc16::compute(frame, length);
+    frame[length++] = (byte)check;
+    frame[length++] = (byte)(check >> 8);
+
+    byte encoded[MAX_ENCODED];
+    byte size = 1;
+    byte codeIndex = 0;
+    byte code = 1;
+    for (byte i = 0; i < length; i++) {
+        if (frame[i] == 0) {
+            encoded[codeIndex] = code;
+            codeIndex = size++;
+            code = 1;
+            continue;
+        }
+        encoded[size++] = frame[i];
+        if (++code == 0xFF) {
+            encoded[codeIndex] = code;
+            codeIndex = size++;
+            code = 1;
+        }
+    }
+    encoded[codeIndex] = code;
+    encoded[size++] = 0;
+
+    if (out.availableForWrite() < size) {
+        dropCount++;
+        return false;
+    }
+    out.write(encoded, size);
+    sentCount++;
+    return true;
+}
+
+/**
+ * @brief Returns the number of records sent.
+ *
+ * @return Records sent since start-up.
+ */
+unsigned long Telemetry::getSentCount() const {
+    return sentCount;
+}
+
+/**
+ * @brief Returns the number of records dropped because the port was busy or the payload too long.
+ *
+ * @return Records dropped since start-up.
+ */
+unsigned long Telemetry::getDropCount() const {
+    return dropCount;
+}
+
+/**
+ * @brief Appends raw bytes to the frame, marking an overflow if they do not fit.
+ *
+ * @param data Bytes to append.
+ * @param size Number of bytes.
+ */
+void Telemetry::add(const byte* data, byte size) {
+    if (length + size > MAX_FRAME - CRC_SIZE) {
+        isOverflow = true;
+        return;
+    }
+    memcpy(frame + length, data, size);
+    length += size;
+}
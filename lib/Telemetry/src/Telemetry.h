@@ -0,0 +1,121 @@
+/**
+ * @file Telemetry.h
+ * @brief Header file for the Telemetry class.
+ *
+ * This file contains the declaration of the Telemetry class, which sends compact binary records over a serial port
+ * for monitoring. Each record is framed as:
+ *
+ *     type (1) | sequence (1) | time in ms (4) | payload (0 to MAX_PAYLOAD) | CRC-16 (2)
+ *
+ * All fields are little-endian. The CRC is CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) over everything
+ * before it. The frame is COBS-encoded and ends with a 0x00 byte, so a reader can start listening at any point and
+ * find the next frame boundary. The sequence number goes up by one for every record, including records that were
+ * dropped because the port was busy, so gaps show on the host.
+ *
+ * tools/telemetry_decode.py decodes a recorded stream.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "Crc16.h"
+
+/**
+ * @class Telemetry
+ * @brief Builds, frames and sends binary records without ever waiting for the port.
+ *
+ * A record is built with beginFrame(), the add functions and endFrame(). endFrame() only writes the frame if the
+ * port's TX buffer has room for all of it; otherwise the record is dropped and counted.
+ */
+class Telemetry {
+public:
+    static const byte MAX_PAYLOAD = 32;   ///< Largest record payload
+    static const byte HEADER_SIZE = 6;    ///< Type, sequence and time
+    static const byte CRC_SIZE = 2;       ///< CRC-16 after the payload
+    static const byte MAX_FRAME = HEADER_SIZE + MAX_PAYLOAD + CRC_SIZE;   ///< Largest frame before encoding
+    static const byte MAX_ENCODED = MAX_FRAME + MAX_FRAME / 254 + 2;     ///< Largest frame on the wire
+
+    /**
+     * @brief Construct a new Telemetry object.
+     *
+     * @param out Port the records are sent on.
+     */
+    Telemetry(Print& out);
+
+    /**
+     * @brief Starts a record.
+     *
+     * @param type Record type, defined by the application.
+     * @param nowMs Time stamp of the record (millis).
+     */
+    void beginFrame(byte type, unsigned long nowMs);
+
+    /**
+     * @brief Appends a byte to the payload.
+     *
+     * @param value Value to append.
+     */
+    void addByte(byte value);
+
+    /**
+     * @brief Appends a 16-bit value to the payload.
+     *
+     * @param value Value to append.
+     */
+    void addInt16(int16_t value);
+
+    /**
+     * @brief Appends a 32-bit value to the payload.
+     *
+     * @param value Value to append.
+     */
+    void addInt32(int32_t value);
+
+    /**
+     * @brief Appends a 32-bit float to the payload.
+     *
+     * @param value Value to append.
+     */
+    void addFloat(float value);
+
+    /**
+     * @brief Adds the CRC, encodes the record and sends it if the port has room.
+     *
+     * @return true if the record was sent, false if it was dropped or its payload overflowed.
+     */
+    bool endFrame();
+
+    /**
+     * @brief Returns the number of records sent.
+     *
+     * @return Records sent since start-up.
+     */
+    unsigned long getSentCount() const;
+
+    /**
+     * @brief Returns the number of records dropped because the port was busy or the payload too long.
+     *
+     * @return Records dropped since start-up.
+     */
+    unsigned long getDropCount() const;
+
+private:
+    /**
+     * @brief Appends raw bytes to the frame, marking an overflow if they do not fit.
+     *
+     * @param data Bytes to append.
+     * @param size Number of bytes.
+     */
+    void add(const byte* data, byte size);
+
+    Print& out;                   ///< Port the records are sent on
+    byte frame[MAX_FRAME];        ///< Record being built
+    byte length;                  ///< Bytes in the record
+    bool isOverflow;              ///< Whether the payload did not fit
+    byte sequence;                ///< Sequence number of the next record
+    unsigned long sentCount;      ///< Records sent since start-up
+    unsigned long dropCount;      ///< Records dropped since start-up
+};
+
+#endif  // TELEMETRY_H
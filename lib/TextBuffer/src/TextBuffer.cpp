@@ -0,0 +1,174 @@
+#include "TextBuffer.h"
+
+/**
+ * @brief Construct a new TextBuffer object over an array and empties it.
+ *
+ * @param buffer Array the text is built in.
+ * @param size Size of the array, including the terminating NUL.
+ */
+TextBuffer::TextBuffer(char* buffer, byte size) {
+    this->buffer = buffer;
+    this->size = size;
+    this->used = 0;
+    this->isCut = false;
+    clear();
+}
+
+/**
+ * @brief Empties the text.
+ *
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::clear() {
+    used = 0;
+    isCut = false;
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+    return *this;
+}
+
+/**
+ * @brief Appends a string from RAM.
+ *
+ * @param text Text to append.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::append(const char* text) {
+    while (*text != '\0') {
+        append(*text++);
+    }
+    return *this;
+}
+
+/**
+ * @brief Appends a string from flash, e.g. F("WEIGHT: ").
+ *
+ * @param text Text to append.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::append(const __FlashStringHelper* text) {
+    PGM_P p = reinterpret_cast<PGM_P>(text);
+    char c;
+    while ((c = pgm_read_byte(p++)) != '\0') {
+        append(c);
+    }
+    return *this;
+}
+
+/**
+ * @brief Appends one character.
+ *
+ * @param c Character to append.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::append(char c) {
+    if (used + 1 >= size) {
+        isCut = true;
+        return *this;
+    }
+    buffer[used++] = c;
+    buffer[used] = '\0';
+    return *this;
+}
+
+/**
+ * @brief Appends a whole number in decimal.
+ *
+ * The digits are produced backwards into a small stack array, then copied in order.
+ *
+ * @param value Number to append.
+ * @param minDigits Pads with leading zeros to at least this many digits.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::appendInt(long value, byte minDigits) {
+    unsigned long magnitude = (value < 0) ? 0UL - (unsigned long)value : (unsigned long)value;
+    if (value < 0) {
+        append('-');
+    }
+
+    char digits[10];
+    byte count = 0;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    for (byte i = count; i < minDigits; i++) {
+        append('0');
+    }
+    while (count > 0) {
+        append(digits[--count]);
+    }
+    return *this;
+}
+
+/**
+ * @brief Appends a fixed-point number, e.g. 1234 with 2 decimals as "12.34".
+ *
+ * @param value Number scaled by 10^decimals.
+ * @param decimals Digits after the decimal point.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::appendFixed(long value, byte decimals) {
+    if (decimals == 0) {
+        return appendInt(value);
+    }
+
+    unsigned long divisor = 1;
+    for (byte i = 0; i < decimals; i++) {
+        divisor *= 10;
+    }
+    unsigned long magnitude = (value < 0) ? 0UL - (unsigned long)value : (unsigned long)value;
+    if (value < 0) {
+        append('-');
+    }
+    appendInt(magnitude / divisor);
+    append('.');
+    return appendInt(magnitude % divisor, decimals);
+}
+
+/**
+ * @brief Appends a float rounded to a number of decimals.
+ *
+ * @param value Number to append.
+ * @param decimals Digits after the decimal point, 0 to 4.
+ * @return This buffer, so calls can be chained.
+ */
+TextBuffer& TextBuffer::appendFloat(float value, byte decimals) {
+    if (decimals > 4) {
+        decimals = 4;
+    }
+    float scale = 1.0f;
+    for (byte i = 0; i < decimals; i++) {
+        scale *= 10.0f;
+    }
+    return appendFixed(lround(value * scale), decimals);
+}
+
+/**
+ * @brief Returns the text.
+ *
+ * @return The NUL-terminated text.
+ */
+const char* TextBuffer::c_str() const {
+    return buffer;
+}
+
+/**
+ * @brief Returns the length of the text.
+ *
+ * @return The number of characters, excluding the NUL.
+ */
+byte TextBuffer::length() const {
+    return used;
+}
+
+/**
+ * @brief Checks whether any appended text was cut off.
+ *
+ * @return true if text was dropped since the last clear().
+ */
+bool TextBuffer::isTruncated() const {
+    return isCut;
+}
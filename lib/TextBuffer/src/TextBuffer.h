@@ -0,0 +1,120 @@
+/**
+ * @file TextBuffer.h
+ * @brief Header file for the TextBuffer class.
+ *
+ * This file contains the declaration of the TextBuffer class, which builds text in a fixed char array supplied by
+ * the caller. It replaces Arduino String concatenation on paths that run for the whole fermentation: nothing is
+ * allocated on the heap, so the Mega's 8 KB of RAM cannot fragment however long the machine runs.
+ *
+ * Numbers are formatted with integer arithmetic only; fractional values are rounded to a fixed number of decimals
+ * and printed as a scaled integer.
+ */
+
+#ifndef TEXTBUFFER_H
+#define TEXTBUFFER_H
+
+#include <Arduino.h>
+
+/**
+ * @class TextBuffer
+ * @brief Appends text and numbers to a caller-owned char array, always keeping it NUL-terminated.
+ *
+ * Text that does not fit is cut off at the end of the array; isTruncated() reports it.
+ */
+class TextBuffer {
+public:
+    /**
+     * @brief Construct a new TextBuffer object over an array and empties it.
+     *
+     * @param buffer Array the text is built in.
+     * @param size Size of the array, including the terminating NUL.
+     */
+    TextBuffer(char* buffer, byte size);
+
+    /**
+     * @brief Empties the text.
+     *
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& clear();
+
+    /**
+     * @brief Appends a string from RAM.
+     *
+     * @param text Text to append.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& append(const char* text);
+
+    /**
+     * @brief Appends a string from flash, e.g. F("WEIGHT: ").
+     *
+     * @param text Text to append.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& append(const __FlashStringHelper* text);
+
+    /**
+     * @brief Appends one character.
+     *
+     * @param c Character to append.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& append(char c);
+
+    /**
+     * @brief Appends a whole number in decimal.
+     *
+     * @param value Number to append.
+     * @param minDigits Pads with leading zeros to at least this many digits.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& appendInt(long value, byte minDigits = 1);
+
+    /**
+     * @brief Appends a fixed-point number, e.g. 1234 with 2 decimals as "12.34".
+     *
+     * @param value Number scaled by 10^decimals.
+     * @param decimals Digits after the decimal point.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& appendFixed(long value, byte decimals);
+
+    /**
+     * @brief Appends a float rounded to a number of decimals.
+     *
+     * @param value Number to append.
+     * @param decimals Digits after the decimal point, 0 to 4.
+     * @return This buffer, so calls can be chained.
+     */
+    TextBuffer& appendFloat(float value, byte decimals);
+
+    /**
+     * @brief Returns the text.
+     *
+     * @return The NUL-terminated text.
+     */
+    const char* c_str() const;
+
+    /**
+     * @brief Returns the length of the text.
+     *
+     * @return The number of characters, excluding the NUL.
+     */
+    byte length() const;
+
+    /**
+     * @brief Checks whether any appended text was cut off.
+     *
+     * @return true if text was dropped since the last clear().
+     */
+    bool isTruncated() const;
+
+private:
+    char* buffer;      ///< Caller-owned array
+    byte size;         ///< Size of the array, including the NUL
+    byte used;         ///< Characters in the text
+    bool isCut;        ///< Whether text was dropped
+};
+
+#endif  // TEXTBUFFER_H
@@ -0,0 +1,240 @@
+#include "SampleFilter.h"
+
+/**
+ * @brief Construct a new MedianFilter object.
+ *
+ * @param size Window size, 1 to MAX_SIZE; odd sizes give a true median.
+ */
+MedianFilter::MedianFilter(byte size) {
+    this->size = constrain(size, 1, MAX_SIZE);
+    this->head = 0;
+    this->count = 0;
+}
+
+/**
+ * @brief Changes the window size and empties the window.
+ *
+ * @param size Window size, 1 to MAX_SIZE.
+ */
+void MedianFilter::setSize(byte size) {
+    this->size = constrain(size, 1, MAX_SIZE);
+    reset();
+}
+
+/**
+ * @brief Adds a sample and returns the median of the window.
+ *
+ * Sorts a copy of the window by insertion; with at most MAX_SIZE entries this is a few dozen comparisons.
+ *
+ * @param sample The input sample.
+ * @return The median of the samples in the window.
+ */
+long MedianFilter::apply(long sample) {
+    window[head] = sample;
+    head = (head + 1) % size;
+    if (count < size) {
+        count++;
+    }
+
+    long sorted[MAX_SIZE];
+    for (byte i = 0; i < count; i++) {
+        long value = window[i];
+        byte j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+    return sorted[count / 2];
+}
+
+/**
+ * @brief Empties the window.
+ */
+void MedianFilter::reset() {
+    head = 0;
+    count = 0;
+}
+
+/**
+ * @brief Construct a new EmaFilter object.
+ *
+ * @param shift Smoothing; the average moves 1/2^shift of the way to each sample.
+ */
+EmaFilter::EmaFilter(byte shift) {
+    this->shift = shift;
+    this->average = 0;
+    this->isEmpty = true;
+}
+
+/**
+ * @brief Changes the smoothing; the current average is kept.
+ *
+ * @param shift Smoothing; the average moves 1/2^shift of the way to each sample.
+ */
+void EmaFilter::setShift(byte shift) {
+    this->shift = shift;
+}
+
+/**
+ * @brief Moves the average towards a sample.
+ *
+ * @param sample The input sample.
+ * @return The new average.
+ */
+long EmaFilter::apply(long sample) {
+    if (isEmpty) {
+        reset(sample);
+    } else {
+        long target = sample * (1L << FRACTION_BITS);
+        average += (target - average) / (1L << shift);
+    }
+    return value();
+}
+
+/**
+ * @brief Forgets the average; the next sample starts it again.
+ */
+void EmaFilter::reset() {
+    isEmpty = true;
+}
+
+/**
+ * @brief Restarts the average at a given value.
+ *
+ * @param sample The new average.
+ */
+void EmaFilter::reset(long sample) {
+    average = sample * (1L << FRACTION_BITS);
+    isEmpty = false;
+}
+
+/**
+ * @brief Returns the current average.
+ *
+ * @return The average in raw counts, rounded to nearest.
+ */
+long EmaFilter::value() const {
+    const long half = 1L << (FRACTION_BITS - 1);
+    return (average >= 0 ? average + half : average - half) / (1L << FRACTION_BITS);
+}
+
+/**
+ * @brief Construct a new StepChangeDetector object.
+ *
+ * @param average The average to restart on a step.
+ * @param threshold Distance from the average that counts as a change (raw counts).
+ * @param confirmSamples Consecutive samples beyond the threshold needed for a step.
+ */
+StepChangeDetector::StepChangeDetector(EmaFilter& average, long threshold, byte confirmSamples)
+    : average(average) {
+    this->threshold = threshold;
+    this->confirmSamples = confirmSamples > 0 ? confirmSamples : 1;
+    this->outsideCount = 0;
+    this->isStep = false;
+}
+
+/**
+ * @brief Checks a sample against the average and passes it through.
+ *
+ * On a confirmed step the average is restarted at the sample, so the next stage outputs the new load at once.
+ *
+ * @param sample The input sample.
+ * @return The same sample.
+ */
+long StepChangeDetector::apply(long sample) {
+    long distance = sample - average.value();
+    if (distance < 0) {
+        distance = -distance;
+    }
+
+    isStep = false;
+    if (distance <= threshold) {
+        outsideCount = 0;
+    } else if (++outsideCount >= confirmSamples) {
+        average.reset(sample);
+        outsideCount = 0;
+        isStep = true;
+    }
+    return sample;
+}
+
+/**
+ * @brief Clears the confirmation count.
+ */
+void StepChangeDetector::reset() {
+    outsideCount = 0;
+    isStep = false;
+}
+
+/**
+ * @brief Sets the distance from the average that counts as a change.
+ *
+ * @param threshold Threshold in raw counts.
+ */
+void StepChangeDetector::setThreshold(long threshold) {
+    this->threshold = threshold;
+}
+
+/**
+ * @brief Sets how many consecutive samples beyond the threshold make a step.
+ *
+ * @param confirmSamples Number of samples, at least 1.
+ */
+void StepChangeDetector::setConfirmSamples(byte confirmSamples) {
+    this->confirmSamples = confirmSamples > 0 ? confirmSamples : 1;
+    outsideCount = 0;
+}
+
+/**
+ * @brief Checks whether the last sample completed a step.
+ *
+ * @return true if the average was restarted on the last sample.
+ */
+bool StepChangeDetector::isStepDetected() const {
+    return isStep;
+}
+
+/**
+ * @brief Construct a new FilterPipeline object with no stages.
+ */
+FilterPipeline::FilterPipeline() {
+    this->stageCount = 0;
+}
+
+/**
+ * @brief Appends a stage.
+ *
+ * @param stage The filter to run after the current last stage.
+ * @return true if it was added, false if the chain is full.
+ */
+bool FilterPipeline::addStage(SampleFilter& stage) {
+    if (stageCount >= MAX_STAGES) {
+        return false;
+    }
+    stages[stageCount++] = &stage;
+    return true;
+}
+
+/**
+ * @brief Runs a sample through every stage.
+ *
+ * @param sample The raw sample.
+ * @return The filtered sample.
+ */
+long FilterPipeline::apply(long sample) {
+    for (byte i = 0; i < stageCount; i++) {
+        sample = stages[i]->apply(sample);
+    }
+    return sample;
+}
+
+/**
+ * @brief Resets every stage.
+ */
+void FilterPipeline::reset() {
+    for (byte i = 0; i < stageCount; i++) {
+        stages[i]->reset();
+    }
+}
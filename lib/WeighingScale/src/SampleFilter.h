@@ -0,0 +1,208 @@
+/**
+ * @file SampleFilter.h
+ * @brief Header file for the weighing scale sample filters.
+ *
+ * This file contains integer filters that run on every raw HX711 sample: a median filter that rejects single
+ * spikes (e.g. chopper vibration), an exponential moving average that smooths the noise, and a step-change detector
+ * that lets the average jump to a real change of load instead of creeping towards it. The stages are chained in a
+ * FilterPipeline. They only use integer additions, shifts and comparisons, and depend on nothing but Arduino types,
+ * so recorded sample traces can be run through them on the host.
+ */
+
+#ifndef SAMPLEFILTER_H
+#define SAMPLEFILTER_H
+
+#include <Arduino.h>
+
+/**
+ * @class SampleFilter
+ * @brief One stage of a FilterPipeline.
+ */
+class SampleFilter {
+public:
+    virtual ~SampleFilter() {}
+
+    /**
+     * @brief Filters one sample.
+     *
+     * @param sample The input sample (raw HX711 counts).
+     * @return The output sample.
+     */
+    virtual long apply(long sample) = 0;
+
+    /**
+     * @brief Forgets the previous samples.
+     */
+    virtual void reset() = 0;
+};
+
+/**
+ * @class MedianFilter
+ * @brief Outputs the median of the last few samples, so a spike shorter than half the window never gets through.
+ */
+class MedianFilter : public SampleFilter {
+public:
+    static const byte MAX_SIZE = 9;  ///< Largest window
+
+    /**
+     * @brief Construct a new MedianFilter object.
+     *
+     * @param size Window size, 1 to MAX_SIZE; odd sizes give a true median.
+     */
+    MedianFilter(byte size);
+
+    /**
+     * @brief Changes the window size and empties the window.
+     *
+     * @param size Window size, 1 to MAX_SIZE.
+     */
+    void setSize(byte size);
+
+    long apply(long sample) override;
+    void reset() override;
+
+private:
+    long window[MAX_SIZE];  ///< Last samples, oldest overwritten first
+    byte size;              ///< Window size
+    byte head;              ///< Next slot to overwrite
+    byte count;             ///< Samples in the window
+};
+
+/**
+ * @class EmaFilter
+ * @brief Exponential moving average with a power-of-two weight: y += (x - y) / 2^shift.
+ *
+ * The average keeps FRACTION_BITS extra bits, so small changes are not lost to rounding. The first sample after a
+ * reset sets the average directly.
+ */
+class EmaFilter : public SampleFilter {
+public:
+    static const byte FRACTION_BITS = 4;  ///< Extra precision of the stored average
+
+    /**
+     * @brief Construct a new EmaFilter object.
+     *
+     * @param shift Smoothing; the average moves 1/2^shift of the way to each sample.
+     */
+    EmaFilter(byte shift);
+
+    /**
+     * @brief Changes the smoothing; the current average is kept.
+     *
+     * @param shift Smoothing; the average moves 1/2^shift of the way to each sample.
+     */
+    void setShift(byte shift);
+
+    long apply(long sample) override;
+    void reset() override;
+
+    /**
+     * @brief Restarts the average at a given value.
+     *
+     * @param sample The new average.
+     */
+    void reset(long sample);
+
+    /**
+     * @brief Returns the current average.
+     *
+     * @return The average in raw counts.
+     */
+    long value() const;
+
+private:
+    long average;   ///< Average with FRACTION_BITS extra bits
+    byte shift;     ///< Smoothing shift
+    bool isEmpty;   ///< Whether no sample has been seen since the reset
+};
+
+/**
+ * @class StepChangeDetector
+ * @brief Passes samples through and restarts an EmaFilter when the load really changes.
+ *
+ * A sample further than the threshold from the average counts as a step once enough consecutive samples agree,
+ * which tells a new load apart from noise the median let through.
+ */
+class StepChangeDetector : public SampleFilter {
+public:
+    /**
+     * @brief Construct a new StepChangeDetector object.
+     *
+     * @param average The average to restart on a step; it must come after this stage in the pipeline.
+     * @param threshold Distance from the average that counts as a change (raw counts).
+     * @param confirmSamples Consecutive samples beyond the threshold needed for a step.
+     */
+    StepChangeDetector(EmaFilter& average, long threshold, byte confirmSamples);
+
+    long apply(long sample) override;
+    void reset() override;
+
+    /**
+     * @brief Sets the distance from the average that counts as a change.
+     *
+     * @param threshold Threshold in raw counts.
+     */
+    void setThreshold(long threshold);
+
+    /**
+     * @brief Sets how many consecutive samples beyond the threshold make a step.
+     *
+     * @param confirmSamples Number of samples, at least 1.
+     */
+    void setConfirmSamples(byte confirmSamples);
+
+    /**
+     * @brief Checks whether the last sample completed a step.
+     *
+     * @return true if the average was restarted on the last sample.
+     */
+    bool isStepDetected() const;
+
+private:
+    EmaFilter& average;     ///< Average restarted on a step
+    long threshold;         ///< Distance that counts as a change
+    byte confirmSamples;    ///< Samples needed to confirm a step
+    byte outsideCount;      ///< Consecutive samples beyond the threshold
+    bool isStep;            ///< Whether the last sample completed a step
+};
+
+/**
+ * @class FilterPipeline
+ * @brief Runs a sample through a chain of filters in the order they were added.
+ */
+class FilterPipeline {
+public:
+    static const byte MAX_STAGES = 4;  ///< Longest chain
+
+    /**
+     * @brief Construct a new FilterPipeline object with no stages.
+     */
+    FilterPipeline();
+
+    /**
+     * @brief Appends a stage.
+     *
+     * @param stage The filter to run after the current last stage.
+     * @return true if it was added, false if the chain is full.
+     */
+    bool addStage(SampleFilter& stage);
+
+    /**
+     * @brief Runs a sample through every stage.
+     *
+     * @param sample The raw sample.
+     * @return The filtered sample.
+     */
+    long apply(long sample);
+
+    /**
+     * @brief Resets every stage.
+     */
+    void reset();
+
+private:
+    SampleFilter* stages[MAX_STAGES];  ///< Stages in order
+    byte stageCount;                   ///< Number of stages
+};
+
+#endif  // SAMPLEFILTER_H
@@ -0,0 +1,406 @@
+#include "WeighingScale.h"
+
+/**
+ * @brief Construct a new WeighingScale object.
+ *
+ * @param dataPin HX711 DOUT pin.
+ * @param clockPin HX711 PD_SCK pin.
+ * @param ratePin Pin wired to the HX711 RATE input, or NO_PIN if the board fixes the rate.
+ */
+WeighingScale::WeighingScale(byte dataPin, byte clockPin, byte ratePin) {
+    this->dataPin = dataPin;
+    this->clockPin = clockPin;
+    this->ratePin = ratePin;
+    this->rate = RATE_10SPS;
+    this->scale = 1.0f;
+    this->offset = 0;
+    this->averageMs = DEFAULT_AVERAGE_MS;
+    this->head = 0;
+    this->count = 0;
+    this->sampleCount = 0;
+    this->lastSampleUs = 0;
+    this->samplePeriodUs = 1000000UL / RATE_10SPS;
+    this->seedIntervals = SEED_INTERVALS;
+    this->isStarted = false;
+    this->filter = nullptr;
+    this->filteredRaw = 0;
+    this->stabilityMs = DEFAULT_STABILITY_MS;
+    this->stabilityThreshold = 1.0f;
+    this->isTareRunning = false;
+    this->tareStartMs = 0;
+}
+
+/**
+ * @brief Initializes the HX711 pins at gain 128 (channel A) and the selected rate.
+ */
+void WeighingScale::begin() {
+    if (ratePin != NO_PIN) {
+        pinMode(ratePin, OUTPUT);
+    }
+    setRate(rate);
+    hx711.begin(dataPin, clockPin);
+    isStarted = true;
+    clear();
+}
+
+/**
+ * @brief Selects the HX711 sample rate.
+ *
+ * @param samplesPerSecond RATE_10SPS or RATE_80SPS.
+ */
+void WeighingScale::setRate(byte samplesPerSecond) {
+    rate = (samplesPerSecond == RATE_80SPS) ? RATE_80SPS : RATE_10SPS;
+    if (ratePin != NO_PIN) {
+        digitalWrite(ratePin, rate == RATE_80SPS ? HIGH : LOW);
+    }
+    samplePeriodUs = 1000000UL / rate;
+    seedIntervals = SEED_INTERVALS;
+    lastSampleUs = 0;
+}
+
+/**
+ * @brief Returns the measured time between samples.
+ *
+ * @return The sample period in microseconds.
+ */
+unsigned long WeighingScale::getSamplePeriod() const {
+    return samplePeriodUs;
+}
+
+/**
+ * @brief Checks whether the sample period has been measured since begin() or setRate().
+ *
+ * @return true once SEED_INTERVALS intervals have been measured.
+ */
+bool WeighingScale::isSamplePeriodMeasured() const {
+    return seedIntervals == 0;
+}
+
+/**
+ * @brief Converts a time window to a number of samples at the measured rate.
+ *
+ * @param ms Window length in milliseconds.
+ * @return The number of samples in the window, 1 to BUFFER_SIZE.
+ */
+byte WeighingScale::samplesFor(unsigned long ms) const {
+    unsigned long samples = (ms * 1000UL + samplePeriodUs / 2) / samplePeriodUs;
+    return constrain(samples, 1UL, (unsigned long)BUFFER_SIZE);
+}
+
+/**
+ * @brief Reads one conversion if the HX711 has one ready.
+ *
+ * The HX711 pulls DOUT low when a conversion is ready, so checking it costs one pin read. The read itself clocks
+ * out 25 bits, well under a millisecond. The time since the previous sample updates the sample period estimate.
+ * The first SEED_INTERVALS intervals after setRate() seed it with the shortest of them, whatever the nominal rate:
+ * a late read only ever lengthens an interval. After that it is a moving average over 8 samples, and gaps of more
+ * than twice the estimate (the caller was busy) are left out.
+ *
+ * @return true if a new sample was added to the buffer.
+ */
+bool WeighingScale::update() {
+    if (!isStarted || !hx711.is_ready()) {
+        return false;
+    }
+
+    unsigned long nowUs = micros();
+    if (lastSampleUs != 0) {
+        unsigned long interval = nowUs - lastSampleUs;
+        if (seedIntervals > 0) {
+            if (seedIntervals == SEED_INTERVALS || interval < samplePeriodUs) {
+                samplePeriodUs = interval;
+            }
+            seedIntervals--;
+        } else if (interval < samplePeriodUs * 2) {
+            samplePeriodUs += ((long)interval - (long)samplePeriodUs) / 8;
+        }
+    }
+    lastSampleUs = nowUs;
+
+    head = (head + 1) % BUFFER_SIZE;
+    samples[head] = hx711.read();
+    if (filter != nullptr) {
+        filteredRaw = filter->apply(samples[head]);
+    }
+    if (count < BUFFER_SIZE) {
+        count++;
+    }
+    sampleCount++;
+
+    if (isTareRunning) {
+        if (isStable()) {
+            offset = getAverageRaw(getStabilityWindow());
+            isTareRunning = false;
+        } else if (millis() - tareStartMs >= TARE_TIMEOUT_MS) {
+            offset = getAverageRaw(count);
+            isTareRunning = false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether any sample has been collected since begin() or clear().
+ *
+ * @return true if getWeight() has data to work with.
+ */
+bool WeighingScale::isReady() const {
+    return count > 0;
+}
+
+/**
+ * @brief Returns the number of samples collected since begin().
+ *
+ * @return The total sample count.
+ */
+unsigned long WeighingScale::getSampleCount() const {
+    return sampleCount;
+}
+
+/**
+ * @brief Returns the most recent raw sample.
+ *
+ * @return The raw HX711 reading, or 0 if there is none.
+ */
+long WeighingScale::getLatestRaw() const {
+    return (count > 0) ? samples[head] : 0;
+}
+
+/**
+ * @brief Averages the most recent raw samples.
+ *
+ * @param n Number of samples to average; fewer are used if fewer are buffered.
+ * @return The average raw reading, or 0 if there is none.
+ */
+long WeighingScale::getAverageRaw(byte n) const {
+    if (n > count) {
+        n = count;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    long long sum = 0;
+    byte index = head;
+    for (byte i = 0; i < n; i++) {
+        sum += samples[index];
+        index = (index + BUFFER_SIZE - 1) % BUFFER_SIZE;
+    }
+    return (long)(sum / n);
+}
+
+/**
+ * @brief Returns the latest output of the filter pipeline.
+ *
+ * @return The filtered raw reading, or the plain average if no filter is set.
+ */
+long WeighingScale::getFilteredRaw() const {
+    if (filter == nullptr || count == 0) {
+        return getAverageRaw(samplesFor(averageMs));
+    }
+    return filteredRaw;
+}
+
+/**
+ * @brief Returns the weight from the most recent samples.
+ *
+ * @return The filtered weight in grams, or the average over the setAverageTime() window without a filter.
+ */
+float WeighingScale::getWeight() const {
+    return (getFilteredRaw() - offset) / scale;
+}
+
+/**
+ * @brief Sets the filter every new sample is run through.
+ *
+ * @param filter The pipeline, or nullptr for the plain average.
+ */
+void WeighingScale::setFilter(FilterPipeline* filter) {
+    this->filter = filter;
+    if (filter != nullptr) {
+        filter->reset();
+    }
+}
+
+/**
+ * @brief Sets the time getWeight() averages over when no filter is set.
+ *
+ * @param ms Averaging window in milliseconds.
+ */
+void WeighingScale::setAverageTime(unsigned int ms) {
+    averageMs = ms;
+}
+
+/**
+ * @brief Sets the calibration factor.
+ *
+ * @param scale Raw counts per gram.
+ */
+void WeighingScale::setScale(float scale) {
+    this->scale = (scale != 0.0f) ? scale : 1.0f;
+}
+
+/**
+ * @brief Returns the calibration factor.
+ *
+ * @return Raw counts per gram.
+ */
+float WeighingScale::getScale() const {
+    return scale;
+}
+
+/**
+ * @brief Sets the zero offset.
+ *
+ * @param offset Raw reading of the empty scale.
+ */
+void WeighingScale::setOffset(long offset) {
+    this->offset = offset;
+}
+
+/**
+ * @brief Returns the zero offset.
+ *
+ * @return Raw reading of the empty scale.
+ */
+long WeighingScale::getOffset() const {
+    return offset;
+}
+
+/**
+ * @brief Sets when the reading counts as stable.
+ *
+ * @param windowMs Time of the recent samples checked, in milliseconds; at least 2 samples are checked.
+ * @param threshold Largest standard deviation of those samples, in grams.
+ */
+void WeighingScale::setStability(unsigned int windowMs, float threshold) {
+    stabilityMs = windowMs;
+    stabilityThreshold = threshold;
+}
+
+/**
+ * @brief Returns the number of samples checked for stability at the measured rate.
+ *
+ * @return The stability window in samples.
+ */
+byte WeighingScale::getStabilityWindow() const {
+    byte window = samplesFor(stabilityMs);
+    return window < 2 ? 2 : window;
+}
+
+/**
+ * @brief Checks whether the reading has settled.
+ *
+ * Compares the variance of the window, in raw counts, with the squared threshold converted to raw counts. The
+ * deviations from the mean are small, so their squares are summed in 64 bits without overflow.
+ *
+ * @return true if the window is full and its standard deviation is within the threshold.
+ */
+bool WeighingScale::isStable() const {
+    byte window = getStabilityWindow();
+    if (count < window) {
+        return false;
+    }
+
+    long mean = getAverageRaw(window);
+    long long sumSquares = 0;
+    byte index = head;
+    for (byte i = 0; i < window; i++) {
+        long deviation = samples[index] - mean;
+        sumSquares += (long long)deviation * deviation;
+        index = (index + BUFFER_SIZE - 1) % BUFFER_SIZE;
+    }
+
+    float thresholdRaw = stabilityThreshold * scale;
+    return (float)sumSquares <= thresholdRaw * thresholdRaw * window;
+}
+
+/**
+ * @brief Starts zeroing the scale on the current load.
+ */
+void WeighingScale::startTare() {
+    clear();
+    tareStartMs = millis();
+    isTareRunning = true;
+}
+
+/**
+ * @brief Checks whether a tare is still waiting for a stable reading.
+ *
+ * @return true until the tare has set the offset.
+ */
+bool WeighingScale::isTaring() const {
+    return isTareRunning;
+}
+
+/**
+ * @brief Sets the calibration factor from a known weight on the scale.
+ *
+ * @param referenceWeight Weight on the scale, in grams.
+ * @return true if the factor was set, false if the reading is not stable or did not change from the tare.
+ */
+bool WeighingScale::calibrate(float referenceWeight) {
+    if (!isStable() || referenceWeight == 0.0f) {
+        return false;
+    }
+    long delta = getAverageRaw(getStabilityWindow()) - offset;
+    if (delta == 0) {
+        return false;
+    }
+    scale = delta / referenceWeight;
+    return true;
+}
+
+/**
+ * @brief Loads the calibration factor and zero offset stored by saveCalibration().
+ *
+ * A blank or partly written record fails the CRC and leaves the current calibration unchanged.
+ *
+ * @param address EEPROM address of the calibration record.
+ * @return true if a record with a valid CRC was found and applied.
+ */
+bool WeighingScale::loadCalibration(int address) {
+    CalibrationRecord record;
+    EEPROM.get(address, record);
+    if (record.crc != calibrationCrc(record) || !(record.scale == record.scale) || record.scale == 0.0f) {
+        return false;  // Bad CRC, NaN or zero factor
+    }
+    scale = record.scale;
+    offset = record.offset;
+    return true;
+}
+
+/**
+ * @brief Stores the calibration factor and zero offset in EEPROM with a CRC.
+ *
+ * @param address EEPROM address of the calibration record (CALIBRATION_SIZE bytes).
+ */
+void WeighingScale::saveCalibration(int address) const {
+    CalibrationRecord record;
+    record.scale = scale;
+    record.offset = offset;
+    record.crc = calibrationCrc(record);
+    EEPROM.put(address, record);
+}
+
+/**
+ * @brief Computes the CRC of a calibration record.
+ *
+ * @param record The record; its crc field is not included.
+ * @return The CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+ */
+uint16_t WeighingScale::calibrationCrc(const CalibrationRecord& record) {
+    uint16_t crc = Crc16::update(Crc16::INITIAL, &record.scale, sizeof(record.scale));
+    return Crc16::update(crc, &record.offset, sizeof(record.offset));
+}
+
+/**
+ * @brief Drops every buffered sample and restarts the filter.
+ */
+void WeighingScale::clear() {
+    head = 0;
+    count = 0;
+    if (filter != nullptr) {
+        filter->reset();
+    }
+}
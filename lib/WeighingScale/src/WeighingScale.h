@@ -0,0 +1,306 @@
+/**
+ * @file WeighingScale.h
+ * @brief Header file for the WeighingScale class.
+ *
+ * This file contains the declaration of the WeighingScale class, which reads an HX711 load cell amplifier in the
+ * background. update() polls the data-ready line and reads a conversion only once the HX711 has one, so it never
+ * waits; the samples are kept in a ring buffer and the weight is available at any time from the latest of them.
+ */
+
+#ifndef WEIGHINGSCALE_H
+#define WEIGHINGSCALE_H
+
+#include <Arduino.h>
+#include <HX711.h>
+#include <EEPROM.h>
+#include "Crc16.h"
+#include "SampleFilter.h"
+
+/**
+ * @class WeighingScale
+ * @brief Non-blocking HX711 reader with a ring buffer of raw samples.
+ *
+ * Weights are computed as (raw - offset) / scale, like the HX711 library's get_units(), but from samples that have
+ * already been collected. With a FilterPipeline set, every sample is filtered as it arrives and getWeight() returns
+ * the filter output instead of the plain average.
+ *
+ * The reading is stable when the standard deviation of the last few raw samples is within a threshold. A tare
+ * started with startTare() completes as soon as the reading is stable, instead of after a fixed number of samples.
+ *
+ * The calibration factor and zero offset can be stored in EEPROM with a CRC, so a calibrated scale needs no tare at
+ * boot.
+ *
+ * The HX711 samples at 10 or 80 SPS, selected with its RATE pin. Averaging and stability windows are given in
+ * milliseconds and converted to sample counts with the measured sample period, so they cover the same time at
+ * either rate.
+ */
+class WeighingScale {
+public:
+    static const byte BUFFER_SIZE = 32;          ///< Number of raw samples kept (400 ms at 80 SPS)
+    static const byte NO_PIN = 0xFF;             ///< RATE pin value for a rate fixed by the board
+    static const byte RATE_10SPS = 10;           ///< HX711 rate with RATE low
+    static const byte RATE_80SPS = 80;           ///< HX711 rate with RATE high
+    static const unsigned int DEFAULT_AVERAGE_MS = 400;   ///< Time averaged by getWeight() without a filter
+    static const unsigned int DEFAULT_STABILITY_MS = 500; ///< Time checked by isStable()
+    static const unsigned int TARE_TIMEOUT_MS = 3000;     ///< Time after which a tare completes even if never stable
+    static const byte SEED_INTERVALS = 4;        ///< Intervals that seed the period estimate after setRate()
+    static const byte CALIBRATION_SIZE = 10;     ///< EEPROM bytes used by saveCalibration() on the AVR
+
+    /**
+     * @brief Construct a new WeighingScale object.
+     *
+     * @param dataPin HX711 DOUT pin.
+     * @param clockPin HX711 PD_SCK pin.
+     * @param ratePin Pin wired to the HX711 RATE input, or NO_PIN if the board fixes the rate.
+     */
+    WeighingScale(byte dataPin, byte clockPin, byte ratePin = NO_PIN);
+
+    /**
+     * @brief Initializes the HX711 pins at gain 128 (channel A) and the selected rate.
+     */
+    void begin();
+
+    /**
+     * @brief Selects the HX711 sample rate.
+     *
+     * Drives the RATE pin if there is one and restarts the sample period estimate at the nominal period. The next
+     * SEED_INTERVALS intervals then set the estimate outright, so a board whose RATE input is tied to a fixed level
+     * is measured at its real rate even when that is 8 times slower than the one selected.
+     *
+     * @param samplesPerSecond RATE_10SPS or RATE_80SPS.
+     */
+    void setRate(byte samplesPerSecond);
+
+    /**
+     * @brief Returns the measured time between samples.
+     *
+     * @return The sample period in microseconds.
+     */
+    unsigned long getSamplePeriod() const;
+
+    /**
+     * @brief Checks whether the sample period has been measured since begin() or setRate().
+     *
+     * Until then getSamplePeriod() and samplesFor() may still be based on the nominal rate; windows sized once,
+     * such as those of a filter, should be sized again when this turns true.
+     *
+     * @return true once SEED_INTERVALS intervals have been measured.
+     */
+    bool isSamplePeriodMeasured() const;
+
+    /**
+     * @brief Converts a time window to a number of samples at the measured rate.
+     *
+     * @param ms Window length in milliseconds.
+     * @return The number of samples in the window, 1 to BUFFER_SIZE.
+     */
+    byte samplesFor(unsigned long ms) const;
+
+    /**
+     * @brief Reads one conversion if the HX711 has one ready. Call this at least once per sample period.
+     *
+     * Does nothing before begin().
+     *
+     * @return true if a new sample was added to the buffer.
+     */
+    bool update();
+
+    /**
+     * @brief Checks whether any sample has been collected since begin() or clear().
+     *
+     * @return true if getWeight() has data to work with.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Returns the number of samples collected since begin().
+     *
+     * The count keeps increasing across clear(), so a caller can tell whether a new sample has arrived.
+     *
+     * @return The total sample count.
+     */
+    unsigned long getSampleCount() const;
+
+    /**
+     * @brief Returns the most recent raw sample.
+     *
+     * @return The raw HX711 reading, or 0 if there is none.
+     */
+    long getLatestRaw() const;
+
+    /**
+     * @brief Averages the most recent raw samples.
+     *
+     * @param count Number of samples to average; fewer are used if fewer are buffered.
+     * @return The average raw reading, or 0 if there is none.
+     */
+    long getAverageRaw(byte count) const;
+
+    /**
+     * @brief Returns the latest output of the filter pipeline.
+     *
+     * @return The filtered raw reading, or the plain average if no filter is set.
+     */
+    long getFilteredRaw() const;
+
+    /**
+     * @brief Returns the weight from the most recent samples.
+     *
+     * @return The filtered weight in grams, or the average over the setAverageTime() window without a filter.
+     */
+    float getWeight() const;
+
+    /**
+     * @brief Sets the filter every new sample is run through.
+     *
+     * @param filter The pipeline, or nullptr for the plain average.
+     */
+    void setFilter(FilterPipeline* filter);
+
+    /**
+     * @brief Sets the time getWeight() averages over when no filter is set.
+     *
+     * @param ms Averaging window in milliseconds.
+     */
+    void setAverageTime(unsigned int ms);
+
+    /**
+     * @brief Sets the calibration factor.
+     *
+     * @param scale Raw counts per gram.
+     */
+    void setScale(float scale);
+
+    /**
+     * @brief Returns the calibration factor.
+     *
+     * @return Raw counts per gram.
+     */
+    float getScale() const;
+
+    /**
+     * @brief Sets the zero offset.
+     *
+     * @param offset Raw reading of the empty scale.
+     */
+    void setOffset(long offset);
+
+    /**
+     * @brief Returns the zero offset.
+     *
+     * @return Raw reading of the empty scale.
+     */
+    long getOffset() const;
+
+    /**
+     * @brief Sets when the reading counts as stable.
+     *
+     * @param windowMs Time of the recent samples checked, in milliseconds; at least 2 samples are checked.
+     * @param threshold Largest standard deviation of those samples, in grams.
+     */
+    void setStability(unsigned int windowMs, float threshold);
+
+    /**
+     * @brief Returns the number of samples checked for stability at the measured rate.
+     *
+     * @return The stability window in samples.
+     */
+    byte getStabilityWindow() const;
+
+    /**
+     * @brief Checks whether the reading has settled.
+     *
+     * @return true if the window is full and its standard deviation is within the threshold.
+     */
+    bool isStable() const;
+
+    /**
+     * @brief Starts zeroing the scale on the current load. Returns immediately.
+     *
+     * The buffer is cleared and the offset is set from the new samples once they are stable, or from all of them
+     * after TARE_TIMEOUT_MS if the load never settles.
+     */
+    void startTare();
+
+    /**
+     * @brief Checks whether a tare is still waiting for a stable reading.
+     *
+     * @return true until the tare has set the offset.
+     */
+    bool isTaring() const;
+
+    /**
+     * @brief Sets the calibration factor from a known weight on the scale.
+     *
+     * The scale must have been tared empty first. The factor is computed from the stable average of the window.
+     *
+     * @param referenceWeight Weight on the scale, in grams.
+     * @return true if the factor was set, false if the reading is not stable or did not change from the tare.
+     */
+    bool calibrate(float referenceWeight);
+
+    /**
+     * @brief Loads the calibration factor and zero offset stored by saveCalibration().
+     *
+     * @param address EEPROM address of the calibration record.
+     * @return true if a record with a valid CRC was found and applied.
+     */
+    bool loadCalibration(int address);
+
+    /**
+     * @brief Stores the calibration factor and zero offset in EEPROM with a CRC.
+     *
+     * @param address EEPROM address of the calibration record (CALIBRATION_SIZE bytes).
+     */
+    void saveCalibration(int address) const;
+
+    /**
+     * @brief Drops every buffered sample and restarts the filter.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief Calibration as stored in EEPROM.
+     */
+    struct CalibrationRecord {
+        float scale;     ///< Raw counts per gram
+        long offset;     ///< Raw reading of the empty scale
+        uint16_t crc;    ///< CRC-16/CCITT of the fields above
+    };
+
+    /**
+     * @brief Computes the CRC of a calibration record.
+     *
+     * @param record The record; its crc field is not included.
+     * @return The CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF).
+     */
+    static uint16_t calibrationCrc(const CalibrationRecord& record);
+
+    HX711 hx711;                   ///< HX711 driver used for the bit-banged reads
+    byte dataPin;                  ///< HX711 DOUT pin
+    byte clockPin;                 ///< HX711 PD_SCK pin
+    byte ratePin;                  ///< HX711 RATE pin, or NO_PIN
+    byte rate;                     ///< Selected rate (samples per second)
+    float scale;                   ///< Raw counts per gram
+    long offset;                   ///< Raw reading of the empty scale
+    unsigned int averageMs;        ///< Time averaged by getWeight() without a filter
+    bool isStarted;                ///< Whether begin() has set up the pins
+
+    long samples[BUFFER_SIZE];     ///< Ring buffer of raw samples
+    byte head;                     ///< Index of the most recent sample
+    byte count;                    ///< Number of buffered samples
+    unsigned long sampleCount;     ///< Samples collected since begin()
+    unsigned long lastSampleUs;    ///< Time of the last sample (micros)
+    unsigned long samplePeriodUs;  ///< Measured time between samples (us)
+    byte seedIntervals;            ///< Intervals still to seed the period estimate, 0 once measured
+    FilterPipeline* filter;        ///< Filter run on every sample, or nullptr
+    long filteredRaw;              ///< Latest filter output
+
+    unsigned int stabilityMs;      ///< Time checked by isStable()
+    float stabilityThreshold;      ///< Largest standard deviation of a stable reading (g)
+    bool isTareRunning;            ///< Whether a tare is waiting for a stable reading
+    unsigned long tareStartMs;     ///< Time the tare started (millis)
+};
+
+#endif  // WEIGHINGSCALE_H
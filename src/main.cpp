@@ -1,11 +1,21 @@
 #include <Arduino.h>
-#include <HX711.h>       // For Load cell (not used in this code yet)
 #include "LimitSwitch.h"
 #include "RelayModule.h"
 #include "StepperController.h"  
+#include "MotionCoordinator.h"
 #include "MotorController.h"  
 #include "Buzzer.h"  
-#include "EEPROMStatus.h"  
+#include "BatchStateMachine.h"
+#include "WeighingScale.h"
+#include "DosingController.h"
+#include "TaskScheduler.h"
+#include "LcdFrameBuffer.h"
+#include "TextBuffer.h"
+#include "Logger.h"
+#include "Telemetry.h"
+#include "CommandConsole.h"
+#include "Profiler.h"
+#include "RamMonitor.h"
 #include <EEPROM.h>
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
@@ -13,274 +23,336 @@
 
 RTC_DS3231 rtc;
 DateTime nowDateTime;
-DateTime startDateTime;
 bool isRtcReady = false;
 
+TaskScheduler scheduler;  ///< Runs the machine's periodic work; long sequences wait through it instead of delay()
+
+// Timing zones reported by the console's profile command. The stage zones run from entering a batch state to
+// entering the next one and are in the same order as the states they time.
+enum ProfileZone : byte {
+    ZONE_LOOP,           // One scheduler pass of loop()
+    ZONE_MACHINE,        // One run of the process task
+    ZONE_SCALE,          // Reading and filtering a scale sample
+    ZONE_LCD,            // Sending the changed characters to the LCD
+    ZONE_TELEMETRY,      // Building and sending telemetry records
+    ZONE_HOMING,         // Homing stage, entry to exit
+    ZONE_ADD_BANANA,     // Banana dosing stage
+    ZONE_ADD_MOLASSES,   // Molasses dosing stage
+    ZONE_MIX,            // Mixing stage
+    ZONE_SEAL            // Sealing stage
+};
+
 //TRY EDIT
 
 
 void setupRtc()
 {
-    Serial.println("Setting up RTC");
+    LOG_INFO("Setting up RTC");
     if (!rtc.begin()) {
-        Serial.println("RTC failed");
+        LOG_ERROR("RTC failed");
         isRtcReady = false;
     } else {
-        Serial.println("RTC is ready");
+        LOG_INFO("RTC is ready");
         isRtcReady = true;
         if (rtc.lostPower()) {
-            Serial.println("RTC lost power, setting time to compile time");
+            LOG_WARN("RTC lost power, setting time to compile time");
             rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
         }
     } 
 }
 
-void testRtc()
-{
+/**
+ * @brief Formats the RTC date and time as a one-line reply. A Logger reply source.
+ *
+ * @param cursor 0 for the line, then past it.
+ * @param line Buffer for the line.
+ * @return true if the line was formatted.
+ */
+bool formatRtcTime(byte& cursor, TextBuffer& line) {
+    if (cursor++ > 0) {
+        return false;
+    }
     nowDateTime = rtc.now();
-    Serial.print(nowDateTime .year(), DEC);
-    Serial.print('/');
-    Serial.print(nowDateTime.month(), DEC);
-    Serial.print('/');
-    Serial.print(nowDateTime.day(), DEC);
-    Serial.print(" ");
-    Serial.print(nowDateTime.hour(), DEC);
-    Serial.print(':');
-    Serial.print(nowDateTime.minute(), DEC);
-    Serial.print(':');
-    Serial.println(nowDateTime.second(), DEC);
-
-    delay(1000);
-}
-
-/*
-    Returns the current date and time as a string
-*/
-String timestamp(DateTime _now){
-    String timeStr = String(_now.year()) + "/" + 
-                    String(_now.month()) + "/" + 
-                    String(_now.day()) + " " +
-                    String(_now.hour()) + ":" + 
-                    String(_now.minute()) + ":" + 
-                    String(_now.second());
-    return timeStr;
+    line.appendInt(nowDateTime.year()).append('/').appendInt(nowDateTime.month(), 2).append('/');
+    line.appendInt(nowDateTime.day(), 2).append(' ').appendInt(nowDateTime.hour(), 2).append(':');
+    line.appendInt(nowDateTime.minute(), 2).append(':').appendInt(nowDateTime.second(), 2);
+    return true;
 }
 
 LiquidCrystal_I2C lcd(0X20,16, 2);
+LcdFrameBuffer display(lcd);  ///< Shadow copy of the LCD; only changed characters are sent
+const unsigned int lcdBytesPerRun = 4;  // Bytes sent per LCD task run, about 0.5 ms of I2C each
+int8_t lcdTask = TaskScheduler::NO_TASK;       ///< Sends the framebuffer to the LCD
+int8_t lcdClearTask = TaskScheduler::NO_TASK;  ///< One-shot task that clears an auto-clear message
+
+/**
+ * @brief Sends a few changed characters to the LCD.
+ *
+ * Each run is limited to lcdBytesPerRun bytes, so a full screen is drawn over several runs and no run holds the
+ * I2C bus long enough to delay the scale or the buttons.
+ */
+void serviceLcd() {
+    PROFILE_SCOPE(ZONE_LCD);
+    display.flush(lcdBytesPerRun);
+}
+
+/**
+ * @brief Clears the LCD once an auto-clear message has been shown for 5 seconds.
+ */
+void clearLcd() {
+    display.clear();
+}
+
+/**
+ * @brief Replaces any pending auto-clear with the one for a new message.
+ *
+ * @param autoClear If true, clears the display after 5 seconds.
+ */
+void scheduleLcdClear(bool autoClear) {
+    scheduler.disableTask(lcdClearTask);  // A new message replaces any pending auto-clear
+    if (autoClear) {
+        scheduler.runTaskIn(lcdClearTask, 5000);
+    }
+}
+
 /**
  * @brief Displays two lines of text centered on a 16x2 LCD.
  * 
+ * Both lines are drawn into the framebuffer and the LCD task sends only the characters that changed, so the call
+ * never waits for the I2C bus, repeating a message sends nothing and there is no clear to flicker.
+ *
  * @param line1 The first line of text.
  * @param line2 The second line of text.
  * @param autoClear Optional. If true, clears the display after 5 seconds. Default is false.
+ *                  The call returns at once; the display is cleared by a one-shot task.
  */
-void lcdPrint(String line1, String line2, bool autoClear = false) {
-    lcd.clear();
-
-    int len1 = line1.length();
-    int len2 = line2.length();
-    int pad1 = max((16 - len1) / 2, 0);
-    int pad2 = max((16 - len2) / 2, 0);
+void lcdPrint(const char* line1, const char* line2, bool autoClear = false) {
+    display.printCentered(0, line1);
+    display.printCentered(1, line2);
+    scheduleLcdClear(autoClear);
+}
 
-    lcd.setCursor(pad1, 0);
-    lcd.print(line1);
-    lcd.setCursor(pad2, 1);
-    lcd.print(line2);
+/**
+ * @brief Displays two lines of text from flash centered on a 16x2 LCD, e.g. lcdPrint(F("MACHINE"), F("READY")).
+ *
+ * @param line1 The first line of text.
+ * @param line2 The second line of text.
+ * @param autoClear Optional. If true, clears the display after 5 seconds. Default is false.
+ */
+void lcdPrint(const __FlashStringHelper* line1, const __FlashStringHelper* line2, bool autoClear = false) {
+    display.printCentered(0, line1);
+    display.printCentered(1, line2);
+    scheduleLcdClear(autoClear);
+}
 
-    if (autoClear) {
-        delay(5000);
-        lcd.clear();
-    }
+/**
+ * @brief Displays a title from flash and a formatted line from RAM centered on a 16x2 LCD.
+ *
+ * @param line1 The first line of text.
+ * @param line2 The second line of text.
+ * @param autoClear Optional. If true, clears the display after 5 seconds. Default is false.
+ */
+void lcdPrint(const __FlashStringHelper* line1, const char* line2, bool autoClear = false) {
+    display.printCentered(0, line1);
+    display.printCentered(1, line2);
+    scheduleLcdClear(autoClear);
 }
 
   
 void setupLcd() {
     lcd.init();
     lcd.backlight();
+    display.begin();
+    scheduler.enableTask(lcdTask);
 
     for (int i = 0; i < 3; i++) {
-        lcdPrint("WELCOME TO", "AUTO FFJ", false);
-        delay(2000);
+        lcdPrint(F("WELCOME TO"), F("AUTO FFJ"), false);
+        scheduler.wait(2000);
     }
 
-    lcdPrint("WELCOME TO", "AUTO FFJ", true);
+    lcdPrint(F("WELCOME TO"), F("AUTO FFJ"), true);
 
 }
 
-/**
- * @class TimerHelper
- * @brief A simple one-shot timer that executes a callback function after a specified number of seconds.
- */
-class TimerHelper {
-    private:
-        unsigned long startTime = 0;          ///< Stores the start time in milliseconds.
-        unsigned long durationMs = 0;         ///< Duration in milliseconds.
-        bool isRunning = false;               ///< Flag to track if the timer is currently active.
-        void (*callback)() = nullptr;         ///< Pointer to the callback function to execute when the timer expires.
-    
-    public:
-        /**
-         * @brief Construct a new TimerHelper object.
-         */
-        TimerHelper() {}
-    
-        /**
-         * @brief Start the timer with a given duration and a function to execute.
-         * 
-         * @param durationSeconds Duration of the timer in seconds.
-         * @param _callback Function to execute after the timer ends.
-         */
-        void timerStart(unsigned int durationSeconds, void (*_callback)()) {
-            startTime = millis();
-            durationMs = durationSeconds * 1000UL;
-            callback = _callback;
-            isRunning = true;
-        }
-    
-        /**
-         * @brief Call this in the main loop to check if the timer has expired and execute the callback.
-         */
-        void timerLoop() {
-            if (isRunning && (millis() - startTime >= durationMs)) {
-                isRunning = false;
-                if (callback != nullptr) {
-                    callback();
-                }
-            }
-        }
-    
-        /**
-         * @brief Cancel the timer before it completes.
-         */
-        void timerCancel() {
-            isRunning = false;
-        }
-    
-        /**
-         * @brief Check if the timer is currently active.
-         * 
-         * @return true If the timer is running.
-         * @return false If the timer is not running.
-         */
-        bool isActive() const {
-            return isRunning;
-        }
+int8_t cameraPowerTask = TaskScheduler::NO_TASK;    ///< One-shot task that runs the camera's power sequence
+int8_t cameraTask = TaskScheduler::NO_TASK;         ///< Camera button task
+int8_t machineTask = TaskScheduler::NO_TASK;        ///< Process task
+
+// ======================= Task Periods =======================
+const unsigned long inputsPeriod = 2;      // ms, well inside the switch debounce time
+const unsigned long buzzerPeriod = 5;
+const unsigned long scalePeriod = 2;       // ms, polls the HX711 data-ready line
+const unsigned long lcdPeriod = 10;        // ms between display updates
+const unsigned long telemetryPeriod = 5;   // ms, sends each new scale sample and the due status records
+const unsigned long consolePeriod = 20;    // ms, reads commands typed on Serial
+const unsigned long logPeriod = 5;         // ms, refills the serial TX buffer (about 5 characters per 5 ms at 9600)
+const unsigned long cameraPeriod = 10;
+const unsigned long machinePeriod = 10;     // Steps poll their moves and weights on every run
+const unsigned long taskStatsPeriod = 0;   // ms between task run-time reports on Serial, 0 = off
+
+
+// Camera power sequence. The camera needs a few seconds to boot or shut down; cameraPowerTask beeps once it has,
+// and turns the camera off when its webserver time is up, so switching the camera never holds up the process.
+enum CameraPhase : byte {
+    CAMERA_OFF,
+    CAMERA_STARTING,   // Relay on, beeps when the camera has booted
+    CAMERA_RUNNING,    // Webserver up until cameraWebserverDuration runs out
+    CAMERA_STOPPING    // Relay off, beeps when the camera has shut down
 };
+CameraPhase cameraPhase = CAMERA_OFF;
+const byte cameraWebserverDuration = 5;       // minutes
+const unsigned long cameraSwitchTime = 3000;  // ms for the camera to boot or shut down
 
-TimerHelper cameraTimer;
+// ======================= Persistent Storage =======================
+const int batchStateAddress = 0;    // Batch state and sub-step, one byte
+const int dosingOffsetAddress = 1;  // Scale offset of the current dosing step (long)
+const int bananaCorrectionAddress = 5;    // Learned banana dosing correction (float)
+const int molassesCorrectionAddress = 9;  // Learned molasses dosing correction (float)
+const int scaleCalibrationAddress = 13;   // Scale factor and zero offset with CRC (WeighingScale::CALIBRATION_SIZE)
 
 
-bool hasStarted = false;
-bool isSliderAtHome = false;
-bool isCameraRunning = false;
-const byte cameraWebserverDuration = 5;
-
-bool processStarted = false;
-bool processCompleted = false;
-
 
+Buzzer buzzer(A15);
+const byte hx711DatPin = 2;
+const byte hx711SckPin = 3;
+const byte hx711RatePin = 12;   // HX711 RATE; boards with RATE tied to GND stay at 10 SPS and the measured rate is used
+const byte scaleRate = WeighingScale::RATE_80SPS;
+WeighingScale weighingScale(hx711DatPin, hx711SckPin, hx711RatePin);  ///< Collects HX711 samples in the background
+const float defaultCalibrationFactor = 13.40f;  // Used until the scale is calibrated on the machine
+const float calibrationWeight = 500.0f;         // g, reference weight for the calibration routine
+
+// Filter run on every scale sample: the median drops chopper vibration spikes, the average smooths the noise and
+// the step detector lets the average jump to a real change of load. Window sizes are set from the times below
+// for the sample rate in configureScaleFilter().
+MedianFilter scaleMedian(5);
+EmaFilter scaleAverage(2);
+StepChangeDetector scaleStep(scaleAverage, 0, 2);       // Threshold set from the calibration in setup
+FilterPipeline scaleFilter;
+const unsigned int scaleSpikeTime = 500;                // ms, median window (capped at MAX_SIZE samples)
+const unsigned int scaleAverageTime = 400;              // ms, time constant of the average
+const unsigned int scaleStepConfirmTime = 150;          // ms beyond the step threshold that counts as a step
+const float scaleStepThreshold = 10.0f;                 // g away from the average that counts as a step
+const unsigned int scaleStabilityTime = 500;            // ms of samples checked for a settled reading
+const float scaleStabilityThreshold = 1.0f;             // g standard deviation of a settled reading
+const unsigned long scaleTareTimeout = 5000;            // ms to wait for the startup tare
+bool isScaleFilterMeasured = false;  ///< Whether the filter was sized for the measured sample rate
 
-EEPROMStatus fermenting (0);
-EEPROMStatus bananaAdded (1);
-EEPROMStatus molassesAdded (2);
-EEPROMStatus mixtureMixed (3);
-EEPROMStatus mixtureSealed (4);
+/**
+ * @brief Sizes the scale filter stages for the current sample rate.
+ *
+ * The median window is the odd sample count covering scaleSpikeTime, at least 3 and at most MedianFilter::MAX_SIZE.
+ * The average's shift is the power of two closest to scaleAverageTime in samples.
+ */
+void configureScaleFilter() {
+    byte medianSize = weighingScale.samplesFor(scaleSpikeTime) | 1;
+    scaleMedian.setSize(constrain(medianSize, 3, MedianFilter::MAX_SIZE));
+
+    byte averageSamples = weighingScale.samplesFor(scaleAverageTime);
+    byte shift = 0;
+    while ((2U << shift) <= averageSamples + (averageSamples >> 1)) {
+        shift++;
+    }
+    scaleAverage.setShift(shift);
 
-void resetEeprom(){
-    fermenting.setStatus(false);
-    bananaAdded.setStatus(false);
-    molassesAdded.setStatus(false);
-    mixtureMixed.setStatus(false);
-    mixtureSealed.setStatus(false);
+    scaleStep.setConfirmSamples(weighingScale.samplesFor(scaleStepConfirmTime));
 }
 
-void setEeprom() {
-    fermenting.setStatus(true);
-    bananaAdded.setStatus(true);
-    molassesAdded.setStatus(true);
-    mixtureMixed.setStatus(true);
-    mixtureSealed.setStatus(true);
+/**
+ * @brief Converts the gram thresholds of the scale filter to raw counts for the current calibration.
+ */
+void applyScaleThresholds() {
+    scaleStep.setThreshold(lround(fabs(scaleStepThreshold * weighingScale.getScale())));
 }
 
-
-
-Buzzer buzzer(A15);
-HX711 weighingScale;
-const byte hx711DatPin = 2;
-const byte hx711SckPin = 3;
-float calibrationFactor = 13.40f;  // Adjust after calibration +-20grams margin of error
-
 /**
  * @brief Initializes the HX711 weighing scale.
  * 
- * Sets the data and clock pins, applies the calibration factor,
- * and tares the scale to zero. Call this in setup().
+ * Sets the data and clock pins and loads the stored calibration. Only an uncalibrated scale is tared at boot,
+ * as soon as the reading is stable. Call this in setup().
  */
 void setupWeighingScale() {
-    Serial.println(F("[INFO] Initializing weighing scale..."));
-    weighingScale.begin(hx711DatPin, hx711SckPin);
-    weighingScale.set_scale(calibrationFactor);
-    weighingScale.tare();  // Reset the scale to 0
-    delay(2000);
-    Serial.println(F("[INFO] Scale is tared. Ready to read weight."));
+    LOG_INFO("[INFO] Initializing weighing scale...");
+    weighingScale.setRate(scaleRate);
+    weighingScale.begin();
+    configureScaleFilter();
+    scaleFilter.addStage(scaleMedian);
+    scaleFilter.addStage(scaleStep);
+    scaleFilter.addStage(scaleAverage);
+    weighingScale.setFilter(&scaleFilter);
+    weighingScale.setStability(scaleStabilityTime, scaleStabilityThreshold);
+
+    if (weighingScale.loadCalibration(scaleCalibrationAddress)) {
+        applyScaleThresholds();
+        LOG_INFO("[INFO] Scale calibration loaded, factor %", LogArg(weighingScale.getScale(), 3));
+        return;
+    }
+
+    LOG_INFO("[INFO] Scale not calibrated, using the default factor.");
+    weighingScale.setScale(defaultCalibrationFactor);
+    applyScaleThresholds();
+    weighingScale.startTare();  // Reset the scale to 0
+    unsigned long start = millis();
+    while (weighingScale.isTaring() && millis() - start < scaleTareTimeout) {
+        scheduler.run();
+    }
+    if (weighingScale.isTaring()) {
+        LOG_ERROR("[ERROR] Weighing scale not detected.");
+        return;
+    }
+    LOG_INFO("[INFO] Scale is tared. Ready to read weight.");
 }
 
 /**
  * @brief Gets the weight reading from the HX711 in grams.
  * 
- * Takes the average of 20 samples. Make sure the scale has been tared and calibrated.
+ * Returns at once with the filtered weight of the samples collected by the scale task. Make sure the scale has
+ * been tared and calibrated.
  * 
  * @return float The measured weight in grams. Returns -1.0 if scale is not ready.
  */
 float getWeight() {
-    if (weighingScale.is_ready()) {
-        float weightGrams = weighingScale.get_units(20);
-        Serial.print(F("[DATA] Weight: "));
-        Serial.print(weightGrams, 2);
-        Serial.println(F(" g"));
-        return weightGrams;
+    if (weighingScale.isReady()) {
+        return weighingScale.getWeight();
     } else {
-        Serial.println(F("[ERROR] Weighing scale not detected."));
+        LOG_ERROR("[ERROR] Weighing scale not detected.");
         return -1.0f;
     }
 }
 
 
+// Buzzer patterns: on/off durations in milliseconds, starting with on, terminated by 0
+const uint16_t startPattern[] PROGMEM = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 1000, 0 };
+const uint16_t endPattern[] PROGMEM = { 1000, 1000, 200, 150, 200, 150, 200, 1000, 1000, 1000, 0 };
+const uint16_t cameraPattern[] PROGMEM = { 2000, 500, 2000, 500, 2000, 1000, 0 };
+const uint16_t powerOnPattern[] PROGMEM = { 100, 1000, 300, 1000, 600, 1000, 0 };
+const uint16_t motorPattern[] PROGMEM = { 3000, 500, 0 };
+
 /**
  * @brief Plays a short startup sequence (5 quick beeps).
  */
 void beepStartSequence() {
-    buzzer.beep(5, 100, 100);
-    delay(1000);
+    buzzer.play(startPattern);
 }
 
 /**
  * @brief Plays an end sequence: long-short pattern (1 long + 3 short + 1 long).
  */
 void beepEndSequence() {
-    buzzer.beep(1, 1000, 300);
-    buzzer.beep(3, 200, 150);
-    buzzer.beep(1, 1000, 0);
-    delay(1000);
-
+    buzzer.play(endPattern);
 }
 
 /**
  * @brief Plays a long triple beep for camera triggering or alert.
  */
 void beepCamera() {
-    buzzer.beep(3, 2000, 500);
-    delay(1000);
+    buzzer.play(cameraPattern);
 }
 
 /**
  * @brief Plays a custom "power on" pattern: rising rhythm (short > medium > long).
  */
 void powerOnBeep() {
-    buzzer.beep(1, 100, 100);   // short
-    buzzer.beep(1, 300, 150);   // medium
-    buzzer.beep(1, 600);        // long
-    delay(1000);
+    buzzer.play(powerOnPattern);
 }
 
 // ======================= Stepper + Limit Pins =======================
@@ -322,6 +394,7 @@ LimitSwitch cameraButton(cameraButtonPin);
 const byte pumpEnaPin = 5;
 const byte pumpPwmPin = 6;
 const byte pumpSpeed = 100;
+const byte pumpTrickleSpeed = 40;   // Speed for the last grams of molasses
 
 const byte chopperEnaPin = 7;
 const byte chopperPwmPin = 8;
@@ -332,42 +405,82 @@ MotorController chopperMotor(chopperEnaPin, chopperPwmPin);
 MotorController pumpMotor(pumpEnaPin, pumpPwmPin);
 
 // ======================= Stepper Controller Instances =======================
-StepperController sliderStepper(sliderPulPin, sliderDirPin, 1, false);  // 10ms interval, clockwise
+StepperController sliderStepper(sliderPulPin, sliderDirPin, 1, false);
 StepperController sealerStepper(sealerPulPin, sealerDirPin, 3, true);
 StepperController mixingToolStepper(mixingPulPin, mixingDirPin, 3, true);
 StepperController mixerStepper(mixerPulPin, mixerDirPin, 1, true);
 
+// ======================= Motion Profiles =======================
+// Moves start and stop at the pulse interval speed above and ramp up to the cruise speed in between.
+const unsigned long sliderMaxSpeed = 2000;          // steps/s, 4x the 1 ms pulse interval
+const unsigned long sliderAcceleration = 4000;      // steps/s^2
+const unsigned long sliderJerk = 20000;             // steps/s^3, S-curve for the long slider travel
+const unsigned long sealerMaxSpeed = 1500;
+const unsigned long sealerAcceleration = 3000;
+const unsigned long mixingToolMaxSpeed = 500;       // 3x the 3 ms pulse interval
+const unsigned long mixingToolAcceleration = 1000;
+const unsigned long mixerMaxSpeed = 2000;
+const unsigned long mixerAcceleration = 4000;
+
+// ======================= Axis Positions =======================
+// Positions in steps from each axis' home switch.
+const long sliderHomePosition = 0;      // Dosing station, under the chopper and the pump
+const long sliderMixerPosition = 18000;
+const long sliderSealerPosition = 57000;
+const long sliderEndPosition = 58000;     // Far end of the slider's travel, which has no switch
+
+// ======================= Homing =======================
+// Maximum travel towards each switch; running out of it means a failed switch or a stalled axis.
+const long sliderHomeTravel = -62000;   // full slider travel is ~58,000 steps
+const long sealerUpTravel = 12000;
+const long sealerDownTravel = -12000;
+const long mixerUpTravel = -40000;      // mixer is lowered by 37,000 steps
+// Two-speed homing: approach at full speed, back off, then touch the switch again slowly.
+const unsigned long homingBackoffSteps = 400;
+const unsigned long homingTouchInterval = 4000;  // us per step (250 steps/s)
+
+MotionCoordinator motion;  ///< Runs moves on the four axes concurrently
+
 void turnOnCamera(){
-    Serial.println("Turning on camera");
+    LOG_INFO("Turning on camera");
     camera.turnOn();
-    delay(3000);
-    beepCamera();
+    cameraPhase = CAMERA_STARTING;
+    scheduler.runTaskIn(cameraPowerTask, cameraSwitchTime);
 }
 
 void turnOffCamera(){
-    Serial.println("Shutting down camera");
+    LOG_INFO("Shutting down camera");
     camera.turnOff();
-    delay(3000);
-    beepCamera();
+    cameraPhase = CAMERA_STOPPING;
+    scheduler.runTaskIn(cameraPowerTask, cameraSwitchTime);
 }
 
 void powerUpMotors(){
-    Serial.println("Turning on motor power supply");
+    LOG_INFO("Turning on motor power supply");
     motors.turnOn();
-    delay(1000);
-}
-
-void shutdownMotors(){
-    Serial.println("Turning off motor power supply");
-    motors.turnOff();
-    delay(1000);
+    scheduler.wait(1000);
 }
 
 
 void setupRelay(){
     camera.init();
     motors.init();
-    Serial.println("[Setup] Relays initialized.");
+    LOG_INFO("[Setup] Relays initialized.");
+}
+
+/**
+ * @brief Backs a limit switch with its pin interrupt, if the pin has one.
+ *
+ * @param limitSwitch The switch to latch.
+ * @param name Name of the switch for the setup log.
+ */
+void enableLimitInterrupt(LimitSwitch& limitSwitch, const __FlashStringHelper* name) {
+    (void)name;  // Only logged, so unused when LOG_LEVEL compiles LOG_INFO out
+    if (limitSwitch.enableInterrupt()) {
+        LOG_INFO("[Setup] % switch latched by pin interrupt.", name);
+    } else {
+        LOG_INFO("[Setup] % switch polled (no pin interrupt).", name);
+    }
 }
 
 void setupLimitSwitches() {
@@ -380,19 +493,37 @@ void setupLimitSwitches() {
     startButton.init();
     resetButton.init();
     cameraButton.init();
+
+    // Latch the limit switches in a pin interrupt so a move stops within one step of the switch closing.
+    // Pins 10, 11 and 13 are on pin-change group 0 (LIMITSWITCH_USE_PCINT0 in platformio.ini). Pins 9 (slider home)
+    // and 4 (mixer down) have no INT/PCINT and are polled by the step interrupt instead.
+    enableLimitInterrupt(sliderHomeSwitch, F("Slider home"));
+    enableLimitInterrupt(sealerDownSwitch, F("Sealer down"));
+    enableLimitInterrupt(sealerUpSwitch, F("Sealer up"));
+    enableLimitInterrupt(mixerDownSwitch, F("Mixer down"));
+    enableLimitInterrupt(mixerUpSwitch, F("Mixer up"));
     
-    Serial.println("[Setup] Limit switches initialized.");
+    LOG_INFO("[Setup] Limit switches initialized.");
 }
 
 
 void setupStepperMotors() {
     // Initialize the stepper motors
-    sliderStepper.init();
-    sealerStepper.init();
-    mixingToolStepper.init();
-    mixerStepper.init();
+    motion.addAxis(sliderStepper);
+    motion.addAxis(sealerStepper);
+    motion.addAxis(mixingToolStepper);
+    motion.addAxis(mixerStepper);
+    motion.init();
+
+    sliderStepper.setHomingBackoff(homingBackoffSteps, homingTouchInterval);
+    sealerStepper.setHomingBackoff(homingBackoffSteps, homingTouchInterval);
+    mixerStepper.setHomingBackoff(homingBackoffSteps, homingTouchInterval);
+    sliderStepper.setMotionProfile(sliderMaxSpeed, sliderAcceleration, sliderJerk);
+    sealerStepper.setMotionProfile(sealerMaxSpeed, sealerAcceleration);
+    mixingToolStepper.setMotionProfile(mixingToolMaxSpeed, mixingToolAcceleration);
+    mixerStepper.setMotionProfile(mixerMaxSpeed, mixerAcceleration);
     
-    Serial.println("[Setup] Stepper motors initialized.");
+    LOG_INFO("[Setup] Stepper motors initialized.");
 }
 
 void setupMotors() {
@@ -400,423 +531,1220 @@ void setupMotors() {
     pumpMotor.init();
     chopperMotor.init();
     
-    Serial.println("[Setup] Motors initialized.");
+    LOG_INFO("[Setup] Motors initialized.");
 }
 
 void setupBuzzer(){
     buzzer.begin();
 }
 
-void liftCover() {
-    Serial.println("[Action] Lifting cover.");
-    lcdPrint("CURRENT ACTIVITY","LIFTING COVER");
-    sealerStepper.setPulseInterval(1);
-    sealerStepper.moveToLimit(10000, sealerUpSwitch);
-    lcdPrint("CURRENT ACTIVITY","COVER IS LIFTED");
-    Serial.println("[Action] Cover lifted.");
-    delay(2000);
+void turnOnPump() {
+    buzzer.play(motorPattern);
+    LOG_INFO("[Action] Turning on pump.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("PUMPING MOLASSES"));
+    pumpMotor.turnOn(pumpSpeed);
+    LOG_INFO("[Action] Pump turned on.");
 }
 
-void moveMixerUp() {
-    Serial.println("[Action] Moving mixer up.") ;
-    lcdPrint("CURRENT ACTIVITY","MOVING MIXER UP");
-    mixerStepper.moveToLimit(-35000, mixerUpSwitch);
-    Serial.println("[Action] Mixer moved up.");
-    lcdPrint("CURRENT ACTIVITY","MIXER RESET DONE");
-    delay(2000);
+void turnOffPump() {
+    LOG_INFO("[Action] Turning off pump.");
+    pumpMotor.turnOff();
+    LOG_INFO("[Action] Pump turned off.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("PUMP TURNED OFF"));
+    buzzer.play(motorPattern);
 }
 
-void resetSlider() {
-    beepStartSequence();
-    Serial.println("[Action] Resetting slider to home position.");
-    liftCover();
-    moveMixerUp();
-    lcdPrint("CURRENT ACTIVITY","RESETTING SLIDER");
-    sliderStepper.moveToLimit(-58000, sliderHomeSwitch);
-    Serial.println("[Action] Slider reset to home position.");
-    lcdPrint("CURRENT ACTIVITY","SLIDER RESET DONE");
-    beepEndSequence();
-    delay(2000);
-
+void turnOnChopper() {
+    buzzer.play(motorPattern);
+    LOG_INFO("[Action] Turning on chopper.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("CHOPPER TURNED ON"));
+    chopperMotor.turnOn(chopperSpeed);
+    LOG_INFO("[Action] Chopper turned on.");
 }
 
-void moveMixerDown() {
-    beepStartSequence();
-    Serial.println("[Action] Moving mixer down.");
-    lcdPrint("CURRENT ACTIVITY","DEPLOYING MIXER");
-    //mixerStepper.moveToLimit(40000, mixerDownSwitch);
-    mixerStepper.moveTo(37000);
-    Serial.println("[Action] Mixer moved down.");
-    lcdPrint("CURRENT ACTIVITY","MIXER DEPLOYED");
-    beepEndSequence();
-    delay(2000);
+void turnOffChopper() {
+    LOG_INFO("[Action] Turning off chopper.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("CHOPPER TURNED OFF"));
+    chopperMotor.turnOff();
+    LOG_INFO("[Action] Chopper turned off.");
+    buzzer.play(motorPattern);
 }
 
-void putCover() {
-    beepStartSequence();
-    Serial.println("[Action] Putting cover down.");
-    lcdPrint("CURRENT ACTIVITY","SEALING");
-    sealerStepper.moveToLimit(-10000, sealerDownSwitch);
-    Serial.println("[Action] Cover put down.");
-    lcdPrint("CURRENT ACTIVITY","SEALED");
-    delay(2000);
-    beepEndSequence();
+/**
+ * @brief Formats the limit switch states as a one-line reply. A Logger reply source.
+ *
+ * The states are shown as 5 digits, 1 for a triggered switch: slider home, sealer down, sealer up, mixer down and
+ * mixer up.
+ *
+ * @param cursor 0 for the line, then past it.
+ * @param line Buffer for the line.
+ * @return true if the line was formatted.
+ */
+bool formatSwitchStates(byte& cursor, TextBuffer& line) {
+    if (cursor++ > 0) {
+        return false;
+    }
+    line.append(F("Limit Switch States: "));
+    line.append(sliderHomeSwitch.isTriggered() ? '1' : '0');
+    line.append(sealerDownSwitch.isTriggered() ? '1' : '0');
+    line.append(sealerUpSwitch.isTriggered() ? '1' : '0');
+    line.append(mixerDownSwitch.isTriggered() ? '1' : '0');
+    line.append(mixerUpSwitch.isTriggered() ? '1' : '0');
+    return true;
 }
 
-void moveSliderToMixer() {
-    beepStartSequence();
-    resetSlider();
-    Serial.println("[Action] Moving to mixer position.");
-    lcdPrint("CURRENT ACTIVITY","MOVING TO MIXER");
-    sliderStepper.moveTo(18000);
-    Serial.println("[Action] Moved to mixer position.");
-    beepEndSequence();
-    delay(2000);
+// ======================= Batch Process =======================
+// The FFJ batch as a state machine. Each step function starts its work on the first call of a sub-step and then
+// only checks on it, so the machine task never blocks. The state and sub-step are kept in EEPROM.
+enum BatchStateId : byte {
+    BATCH_IDLE,          // Waiting for the start button
+    BATCH_HOMING,        // Homing the slider, cover and mixer
+    BATCH_ADD_BANANA,    // Chopping banana into the container
+    BATCH_ADD_MOLASSES,  // Pumping molasses into the container
+    BATCH_MIX,           // Stirring the mixture
+    BATCH_SEAL,          // Putting the cover down
+    BATCH_FERMENTING,    // Done; the mixture ferments for days
+    BATCH_FAULT,         // An axis did not reach its switch; waiting for reset
+    BATCH_CALIBRATE,     // Calibrating the scale with the reference weight
+    BATCH_STATE_COUNT
+};
+
+const float bananaTarget = 500.0f;    // g
+const float molassesTarget = 500.0f;  // g
+const unsigned long weightDisplayInterval = 500;  // ms between weight updates on the LCD while dosing
+const unsigned long doseSettleTimeout = 3000;     // ms to wait for a stable reading before the dose is weighed anyway
+// Predictive cutoff: stop early by the flow during the stop latency plus the correction learned from past batches.
+const unsigned long bananaStopLatency = 300;      // ms, chopper spin-down
+const unsigned long molassesStopLatency = 500;    // ms, molasses still falling from the hose
+const float molassesTrickleBand = 50.0f;          // g filled at pumpTrickleSpeed
+const float dosingLearningRate = 0.5f;
+const float maxDosingCorrection = 100.0f;         // g, larger stored values are treated as blank EEPROM
+
+DosingController bananaDosing;
+DosingController molassesDosing;
+DosingPhase dosingPhase = DOSING_FAST;            ///< Phase of the running dose
+const long mixerDownSteps = 37000;
+const long stirSteps = 10000;
+
+bool isReadyShown = false;            ///< Whether the idle screen is on the LCD
+bool isCalibrationConfirmed = false;  ///< Set by the start button during the calibration routine
+unsigned long lastWeightMs = 0;       ///< Time the weight was last shown while dosing
+unsigned long lastSampleCount = 0;    ///< Scale sample count at the last dosing check
+
+/**
+ * @brief Polls the running moves.
+ *
+ * @return STEP_RUNNING while a move is running, STEP_FAILED if one ran out of travel, otherwise STEP_NEXT.
+ */
+BatchStepResult waitForMoves() {
+    if (motion.poll()) {
+        return STEP_RUNNING;
+    }
+    if (motion.hasFault()) {
+        LOG_ERROR("[ERROR] Limit switch not reached within the maximum travel.");
+        return STEP_FAILED;
+    }
+    return STEP_NEXT;
 }
 
-void stir() {
-    beepStartSequence();
-    Serial.println("[Action] Stirring.");
-    lcdPrint("CURRENT ACTIVITY","STIR MIXTURE");
-    mixingToolStepper.moveTo(10000);
-    Serial.println("[Action] Stirring complete.");
-    beepEndSequence();
-    delay(2000);
+/**
+ * @brief Starts homing every axis the slider needs out of the way, and the slider itself if it is lost.
+ *
+ * The cover and mixer are clear of the slider exactly when they are still homed at their up switches.
+ */
+void startSliderPreparation() {
+    if (!sealerStepper.isHomed()) {
+        sealerStepper.setPulseInterval(1);
+        motion.home(sealerStepper, sealerUpTravel, sealerUpSwitch);
+    }
+    if (!mixerStepper.isHomed()) {
+        motion.home(mixerStepper, mixerUpTravel, mixerUpSwitch);
+    }
+    if (!sliderStepper.isPositionKnown()) {
+        motion.home(sliderStepper, sliderHomeTravel, sliderHomeSwitch);
+    }
 }
 
-void turnOnPump() {
-    buzzer.beep(1, 3000, 500);
-    Serial.println("[Action] Turning on pump.");
-    lcdPrint("CURRENT ACTIVITY","PUMPING MOLASSES");
-    pumpMotor.turnOn(pumpSpeed);
-    Serial.println("[Action] Pump turned on.");
+/**
+ * @brief Tares the scale for a dosing step and keeps the offset, so a resumed step weighs against the same zero.
+ *
+ * @param isStart Whether this is the first call of the tare sub-step.
+ * @return STEP_NEXT once the reading was stable and the offset is stored, otherwise STEP_RUNNING.
+ */
+BatchStepResult tareForDosing(bool isStart) {
+    if (isStart) {
+        weighingScale.startTare();
+    }
+    if (weighingScale.isTaring()) {
+        return STEP_RUNNING;
+    }
+    EEPROM.put(dosingOffsetAddress, weighingScale.getOffset());
+    return STEP_NEXT;
 }
 
-void turnOffPump() {
-    Serial.println("[Action] Turning off pump.");
-    pumpMotor.turnOff();
-    Serial.println("[Action] Pump turned off.");
-    lcdPrint("CURRENT ACTIVITY","PUMP TURNED OFF");
-    buzzer.beep(1, 3000, 500);
+/**
+ * @brief Restores the tare of the current dosing step, which is kept in EEPROM across power cuts.
+ */
+void restoreDosingOffset() {
+    long offset;
+    EEPROM.get(dosingOffsetAddress, offset);
+    weighingScale.setOffset(offset);
 }
 
-void turnOnChopper() {
-    buzzer.beep(1, 3000, 500);
-    Serial.println("[Action] Turning on chopper.");
-    lcdPrint("CURRENT ACTIVITY","CHOPPER TURNED ON");
-    chopperMotor.turnOn(chopperSpeed);
-    Serial.println("[Action] Chopper turned on.");
+/**
+ * @brief Feeds every new scale sample to the dosing controller and shows the weight every weightDisplayInterval.
+ *
+ * @param title First LCD line.
+ * @param dosing The controller of the material being dosed.
+ * @param isStart Whether this is the first call of the dosing sub-step.
+ * @return The phase the motor should run in.
+ */
+DosingPhase dose(const __FlashStringHelper* title, DosingController& dosing, bool isStart) {
+    if (isStart) {
+        restoreDosingOffset();
+        dosing.start();
+        dosingPhase = DOSING_FAST;
+        lastWeightMs = millis() - weightDisplayInterval;
+        lastSampleCount = weighingScale.getSampleCount();
+    }
+    if (weighingScale.getSampleCount() == lastSampleCount) {
+        return dosingPhase;  // Nothing new to weigh
+    }
+    lastSampleCount = weighingScale.getSampleCount();
+
+    float weight = getWeight();
+    dosingPhase = dosing.update(weight, millis());
+    if (millis() - lastWeightMs >= weightDisplayInterval || dosingPhase == DOSING_STOP) {
+        lastWeightMs = millis();
+        LOG_INFO("[DATA] Weight: % g, flow: % g/s", LogArg(weight, 2), LogArg(dosing.getFlowRate(), 1));
+        char weightLine[LcdFrameBuffer::COLS + 1];
+        TextBuffer weightText(weightLine, sizeof(weightLine));
+        weightText.append(F("WEIGHT: ")).appendFloat(weight, 2).append('g');
+        lcdPrint(title, weightLine);
+    }
+    return dosingPhase;
 }
 
-void turnOffChopper() {
-    Serial.println("[Action] Turning off chopper.");
-    lcdPrint("CURRENT ACTIVITY","CHOPPER TURNED OFF");
-    chopperMotor.turnOff();
-    Serial.println("[Action] Chopper turned off.");
-    buzzer.beep(1, 3000, 500);
+/**
+ * @brief Weighs the dose once the reading is stable and learns its overshoot for the next batch.
+ *
+ * Only samples taken after the motor stopped count towards stability, so material still landing keeps it unsettled.
+ *
+ * @param dosing The controller of the material that was dosed.
+ * @param correctionAddress EEPROM address of the controller's learned correction.
+ * @param isStart Whether this is the first call of the settling sub-step.
+ * @return STEP_NEXT once the dose has been weighed, otherwise STEP_RUNNING.
+ */
+BatchStepResult settleDose(DosingController& dosing, int correctionAddress, bool isStart) {
+    if (isStart) {
+        restoreDosingOffset();
+        lastWeightMs = millis();
+        lastSampleCount = weighingScale.getSampleCount();
+    }
+    bool isSettled = weighingScale.getSampleCount() - lastSampleCount >= weighingScale.getStabilityWindow()
+        && weighingScale.isStable();
+    if (!isSettled && millis() - lastWeightMs < doseSettleTimeout) {
+        return STEP_RUNNING;
+    }
+
+    float weight = getWeight();
+    dosing.finish(weight);
+    EEPROM.put(correctionAddress, dosing.getCorrection());
+    LOG_INFO("[DATA] Dosed: % g, next correction: % g", LogArg(weight, 2), LogArg(dosing.getCorrection(), 2));
+    return STEP_NEXT;
 }
 
-void testLimitSwitch(){
-    // Read states (1 = triggered, 0 = not triggered)
-    byte s1 = sliderHomeSwitch.isTriggered();
-    byte s2 = sealerDownSwitch.isTriggered();
-    byte s3 = sealerUpSwitch.isTriggered();
-    byte s4 = mixerDownSwitch.isTriggered();
-    byte s5 = mixerUpSwitch.isTriggered();
+/**
+ * @brief Loads a learned dosing correction, ignoring a blank or corrupt EEPROM value.
+ *
+ * @param dosing The controller to set up.
+ * @param target Weight each dose fills to, in grams.
+ * @param correctionAddress EEPROM address of the learned correction.
+ */
+void loadDosing(DosingController& dosing, float target, int correctionAddress) {
+    float correction;
+    EEPROM.get(correctionAddress, correction);
+    if (!(correction > -maxDosingCorrection && correction < maxDosingCorrection)) {  // Also rejects NaN
+        correction = 0.0f;
+    }
+    dosing.setTarget(target);
+    dosing.setCorrection(correction);
+}
 
-    // Print as a 5-digit binary number
-    Serial.print("Limit Switch States: ");
-    Serial.print(s1);
-    Serial.print(s2);
-    Serial.print(s3);
-    Serial.print(s4);
-    Serial.println(s5);
+void enterIdle() {
+    isReadyShown = false;
+}
 
-    delay(500); // Adjust delay as needed
+/**
+ * @brief Shows the idle screen once any auto-clear message is gone.
+ */
+BatchStepResult stepIdle(byte, bool) {
+    if (!isReadyShown && !scheduler.isTaskEnabled(lcdClearTask)) {
+        lcdPrint(F("MACHINE READY."), F("PRESS START"));
+        isReadyShown = true;
+    }
+    return STEP_RUNNING;
 }
 
-void mixIngredients(){
+void enterHoming() {
     beepStartSequence();
-    Serial.println("[Action] Mixing ingredients process started");
-    moveSliderToMixer();
-    delay(1000);
-    moveMixerDown();
-    delay(1000);
-    stir();
-    delay(1000);
-    moveMixerUp();
-    Serial.println("[Action] Mixing ingredients process is done");
-    lcdPrint("CURRENT ACTIVITY", "MIXING DONE");
-    beepEndSequence();
-    delay(2000);
+    LOG_INFO("[Action] Resetting slider to home position.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("RESETTING SLIDER"));
+}
 
+/**
+ * @brief Sub-steps: 0 home the cover, mixer and a lost slider together, 1 slider back to the dosing station.
+ *
+ * A slider whose position is still known (e.g. parked at the sealer by the last batch) is homed again rather than
+ * moved by counted steps, so it stops at the switch even if it lost steps on the way, and doses from a fresh zero.
+ */
+BatchStepResult stepHoming(byte subStep, bool isStart) {
+    if (isStart) {
+        if (subStep == 0) {
+            startSliderPreparation();
+        } else if (!sliderStepper.isHomed()) {
+            motion.home(sliderStepper, sliderHomeTravel, sliderHomeSwitch);
+        }
+    }
+    BatchStepResult result = waitForMoves();
+    if (result == STEP_NEXT && subStep == 1) {
+        LOG_INFO("[Action] Slider reset to home position.");
+        lcdPrint(F("CURRENT ACTIVITY"), F("SLIDER RESET DONE"));
+    }
+    return result;
 }
 
-void moveSliderToSealer(){
-    beepStartSequence();
-    resetSlider();
-    Serial.println("[Action] Moving to sealer position.");
-    lcdPrint("CURRENT ACTIVITY","MOVING TO SEALER");
-    sliderStepper.moveTo(57000);
-    Serial.println("[Action] Moved to sealer position.");
-    lcdPrint("CURRENT ACTIVITY","ARRIVED AT SEALER");
-    beepEndSequence();
-    delay(2000);
+/**
+ * @brief A slider move cut by a power loss restarts from homing, since the slider's position is lost with it.
+ */
+byte resumeHoming(byte subStep) {
+    return (subStep == 1) ? 0 : subStep;
 }
 
-void seal(){
-    //resetSlider();
-    beepStartSequence();
-    Serial.println("[Action] Sealing process started.");
-    lcdPrint("CURRENT ACTIVITY","SEALING STARTED");
-    moveSliderToSealer();
-    putCover();
-    Serial.println("[Action] Sealing process successful.");
-    lcdPrint("CURRENT ACTIVITY","SEALING IS DONE");
-    beepEndSequence();
-    delay(2000);
+void enterAddBanana() {
+    lcdPrint(F("CHOPPER RUNNING"), F("INSERT BANANA"));
+}
+
+/**
+ * @brief Sub-steps: 0 tare, 1 chop until the predicted weight reaches the target, 2 settle and learn.
+ */
+BatchStepResult stepAddBanana(byte subStep, bool isStart) {
+    if (subStep == 0) {
+        return tareForDosing(isStart);
+    }
+    if (subStep == 2) {
+        return settleDose(bananaDosing, bananaCorrectionAddress, isStart);
+    }
+
+    if (isStart) {
+        turnOnChopper();
+    }
+    if (dose(F("ADDING BANANA"), bananaDosing, isStart) == DOSING_STOP) {
+        turnOffChopper();
+        return STEP_NEXT;
+    }
+    return STEP_RUNNING;
 }
 
+void exitAddBanana() {
+    chopperMotor.turnOff();  // Already off unless the batch was aborted
+}
 
+void enterAddMolasses() {
+    lcdPrint(F("PUMP RUNNING"), F("ADD MOLASSES"));
+}
 
+/**
+ * @brief Sub-steps: 0 tare, 1 pump until the predicted weight reaches the target, slowing down for the last
+ * grams, 2 settle and learn.
+ */
+BatchStepResult stepAddMolasses(byte subStep, bool isStart) {
+    if (subStep == 0) {
+        return tareForDosing(isStart);
+    }
+    if (subStep == 2) {
+        return settleDose(molassesDosing, molassesCorrectionAddress, isStart);
+    }
 
-bool checkLcd() {
-    bool _isDetected = false;
-    byte error, address;
-  
-    for (address = 1; address < 127; address++) {
-      Wire.beginTransmission(address);
-      error = Wire.endTransmission();
-  
-      if (error == 0) {
-        Serial.print("I2C device found at address 0x");
-        if (address < 16)
-          Serial.print("0");
-        Serial.println(address, HEX);
-  
-        if (address == 0x20) {
-          Serial.println("✅ LCD at 0x20 is detected.");
-          _isDetected = true;
+    if (isStart) {
+        turnOnPump();
+    }
+    DosingPhase phase = dose(F("ADDING MOLASSES"), molassesDosing, isStart);
+    if (phase == DOSING_STOP) {
+        turnOffPump();
+        return STEP_NEXT;
+    }
+    if (phase == DOSING_TRICKLE) {
+        pumpMotor.setSpeed(pumpTrickleSpeed);
+    }
+    return STEP_RUNNING;
+}
+
+void exitAddMolasses() {
+    pumpMotor.turnOff();  // Already off unless the batch was aborted
+}
+
+void enterMix() {
+    beepStartSequence();
+    LOG_INFO("[Action] Mixing ingredients process started");
+}
+
+/**
+ * @brief Sub-steps: 0 clear the slider's path, 1 slider to mixer, 2 raise the mixer if lost, 3 mixer down,
+ * 4 stir, 5 mixer up.
+ */
+BatchStepResult stepMix(byte subStep, bool isStart) {
+    if (isStart) {
+        switch (subStep) {
+            case 0:
+                startSliderPreparation();
+                break;
+            case 1:
+                lcdPrint(F("CURRENT ACTIVITY"), F("MOVING TO MIXER"));
+                motion.moveToPosition(sliderStepper, sliderMixerPosition);
+                break;
+            case 2:
+                if (!mixerStepper.isHomed()) {
+                    motion.home(mixerStepper, mixerUpTravel, mixerUpSwitch);
+                }
+                break;
+            case 3:
+                lcdPrint(F("CURRENT ACTIVITY"), F("DEPLOYING MIXER"));
+                motion.moveTo(mixerStepper, mixerDownSteps);
+                break;
+            case 4:
+                lcdPrint(F("CURRENT ACTIVITY"), F("STIR MIXTURE"));
+                motion.moveTo(mixingToolStepper, stirSteps);
+                break;
+            case 5:
+                lcdPrint(F("CURRENT ACTIVITY"), F("MOVING MIXER UP"));
+                motion.home(mixerStepper, mixerUpTravel, mixerUpSwitch);
+                break;
         }
-      }
     }
-  
-    if (!_isDetected) {
-      Serial.println("❌ LCD not found at 0x20.");
+
+    BatchStepResult result = waitForMoves();
+    if (result == STEP_NEXT && subStep == 5) {
+        LOG_INFO("[Action] Mixing ingredients process is done");
+        lcdPrint(F("CURRENT ACTIVITY"), F("MIXING DONE"));
+        beepEndSequence();
     }
-  
-    delay(1000);
-    return _isDetected;
-  }
+    return result;
+}
 
-void testEeprom(){
-    // Read states (1 = positive, 0 = negative)
-    byte s1 = fermenting.isPositive();
-    byte s2 = bananaAdded.isPositive();
-    byte s3 = molassesAdded.isPositive();
-    byte s4 = mixtureSealed.isPositive();
-    byte s5 = mixtureSealed.isPositive();
-
-    // Print as a 5-digit binary number
-    Serial.print("EEPROM STATES: ");
-    Serial.print(s1);
-    Serial.print(s2);
-    Serial.print(s3);
-    Serial.print(s4);
-    Serial.println(s5);
-
-    delay(500); // Adjust delay as needed
-    
+/**
+ * @brief A slider move cut by a power loss restarts from clearing its path; a mixer move from raising the mixer.
+ */
+byte resumeMix(byte subStep) {
+    if (subStep == 1) {
+        return 0;
+    }
+    if (subStep == 3) {
+        return 2;
+    }
+    return subStep;
 }
 
+void enterSeal() {
+    beepStartSequence();
+    LOG_INFO("[Action] Sealing process started.");
+    lcdPrint(F("CURRENT ACTIVITY"), F("SEALING STARTED"));
+}
 
-  
+/**
+ * @brief Sub-steps: 0 clear the slider's path, 1 slider to sealer, 2 cover down.
+ */
+BatchStepResult stepSeal(byte subStep, bool isStart) {
+    if (isStart) {
+        switch (subStep) {
+            case 0:
+                startSliderPreparation();
+                break;
+            case 1:
+                lcdPrint(F("CURRENT ACTIVITY"), F("MOVING TO SEALER"));
+                motion.moveToPosition(sliderStepper, sliderSealerPosition);
+                break;
+            case 2:
+                lcdPrint(F("CURRENT ACTIVITY"), F("SEALING"));
+                motion.moveToLimit(sealerStepper, sealerDownTravel, sealerDownSwitch);
+                break;
+        }
+    }
 
+    BatchStepResult result = waitForMoves();
+    if (result == STEP_NEXT && subStep == 2) {
+        LOG_INFO("[Action] Sealing process successful.");
+        lcdPrint(F("CURRENT ACTIVITY"), F("SEALING IS DONE"));
+    }
+    return result;
+}
 
-void setup() {
-    Serial.begin(9600);
-    Wire.begin();
+/**
+ * @brief A slider move cut by a power loss restarts from clearing its path.
+ */
+byte resumeSeal(byte subStep) {
+    return (subStep == 1) ? 0 : subStep;
+}
 
-    powerOnBeep();
-    setupRelay();
-    setupLimitSwitches();
-    setupStepperMotors();
-    setupMotors();
-    setupWeighingScale();
-    setupBuzzer();
-    setupLcd();
-    setupRtc();
-    powerUpMotors();
-    //fermenting.setStatus(false); 
-    resetEeprom();
- 
+void enterFermenting() {
+    beepEndSequence();
+    lcdPrint(F("FERMENTING"), F("WAIT FOR DAYS"));
+}
 
+void enterFault() {
+    motion.stop();
+    lcdPrint(F("HOMING FAILED"), F("CHECK SWITCHES"));
+}
 
+void enterCalibrate() {
+    LOG_INFO("[Action] Scale calibration started.");
+}
 
-    if (!fermenting.isPositive()){
-        lcdPrint("NOT FERMENTING", "INITIALIZING");
-        resetSlider();
-    } else {
-        lcdPrint("FERMENTING", "WAIT FOR DAYS");
+/**
+ * @brief Waits for the start button during the calibration routine.
+ *
+ * @param line1 First LCD line.
+ * @param line2 Second LCD line.
+ * @param isStart Whether this is the first call of the sub-step.
+ * @return STEP_NEXT once start has been pressed, otherwise STEP_RUNNING.
+ */
+BatchStepResult waitForConfirmation(const __FlashStringHelper* line1, const __FlashStringHelper* line2,
+                                    bool isStart) {
+    if (isStart) {
+        lcdPrint(line1, line2);
+        isCalibrationConfirmed = false;
     }
+    return isCalibrationConfirmed ? STEP_NEXT : STEP_RUNNING;
+}
 
+/**
+ * @brief Sub-steps: 0 ask for an empty scale, 1 tare, 2 ask for the reference weight, 3 compute and store the
+ * calibration once the reading is stable.
+ */
+BatchStepResult stepCalibrate(byte subStep, bool isStart) {
+    switch (subStep) {
+        case 0:
+            return waitForConfirmation(F("EMPTY THE SCALE"), F("PRESS START"), isStart);
+        case 1:
+            if (isStart) {
+                lcdPrint(F("CALIBRATING"), F("TARING..."));
+                weighingScale.startTare();
+            }
+            return weighingScale.isTaring() ? STEP_RUNNING : STEP_NEXT;
+        case 2:
+            return waitForConfirmation(F("PLACE 500g"), F("PRESS START"), isStart);
+        default:
+            if (isStart) {
+                lcdPrint(F("CALIBRATING"), F("HOLD STILL..."));
+                lastSampleCount = weighingScale.getSampleCount();
+            }
+            if (weighingScale.getSampleCount() - lastSampleCount < weighingScale.getStabilityWindow()
+                || !weighingScale.isStable()) {
+                return STEP_RUNNING;
+            }
+            if (!weighingScale.calibrate(calibrationWeight)) {
+                LOG_ERROR("[ERROR] Scale calibration failed, weight not detected.");
+                lcdPrint(F("CALIBRATION"), F("FAILED"), true);
+                return STEP_DONE;
+            }
+            weighingScale.saveCalibration(scaleCalibrationAddress);
+            applyScaleThresholds();
+            LOG_INFO("[INFO] Scale calibrated, factor %", LogArg(weighingScale.getScale(), 3));
+            lcdPrint(F("CALIBRATION"), F("SAVED"), true);
+            return STEP_NEXT;
+    }
+}
 
-    //turnOnCamera();
-    //liftCover();
+/**
+ * @brief An interrupted calibration starts over, since the tare may no longer match what is on the scale.
+ */
+byte resumeCalibrate(byte) {
+    return 0;
+}
 
-    //turnOnPump();
-    //delay(5000);
-    //turnOffPump();
+const char idleName[] PROGMEM = "IDLE";
+const char homingName[] PROGMEM = "HOMING";
+const char addBananaName[] PROGMEM = "ADD BANANA";
+const char addMolassesName[] PROGMEM = "ADD MOLASSES";
+const char mixName[] PROGMEM = "MIX";
+const char sealName[] PROGMEM = "SEAL";
+const char fermentingName[] PROGMEM = "FERMENTING";
+const char faultName[] PROGMEM = "FAULT";
+const char calibrateName[] PROGMEM = "CALIBRATE";
+
+// name, enter, step, exit, resume, sub-steps, done, failed
+const BatchState batchStates[BATCH_STATE_COUNT] PROGMEM = {
+    { idleName,        enterIdle,        stepIdle,        nullptr,         nullptr,         1, BATCH_IDLE,         BATCH_FAULT },
+    { homingName,      enterHoming,      stepHoming,      nullptr,         resumeHoming,    2, BATCH_ADD_BANANA,   BATCH_FAULT },
+    { addBananaName,   enterAddBanana,   stepAddBanana,   exitAddBanana,   nullptr,         3, BATCH_ADD_MOLASSES, BATCH_FAULT },
+    { addMolassesName, enterAddMolasses, stepAddMolasses, exitAddMolasses, nullptr,         3, BATCH_MIX,          BATCH_FAULT },
+    { mixName,         enterMix,         stepMix,         nullptr,         resumeMix,       6, BATCH_SEAL,         BATCH_FAULT },
+    { sealName,        enterSeal,        stepSeal,        nullptr,         resumeSeal,      3, BATCH_FERMENTING,   BATCH_FAULT },
+    { fermentingName,  enterFermenting,  nullptr,         nullptr,         nullptr,         0, BATCH_FERMENTING,   BATCH_FAULT },
+    { faultName,       enterFault,       nullptr,         nullptr,         nullptr,         0, BATCH_FAULT,        BATCH_FAULT },
+    { calibrateName,   enterCalibrate,   stepCalibrate,   nullptr,         resumeCalibrate, 4, BATCH_IDLE,         BATCH_IDLE },
+};
 
-    //turnOnChopper();
-    //delay(5000);
-    //turnOffChopper();
-    //moveMixerDown();
+BatchStateMachine batch(batchStates, BATCH_STATE_COUNT, batchStateAddress);
 
-    //mixIngredients();
-    //seal();
-    //fermenting.setStatus(true);
+/**
+ * @brief Checks whether a batch is being processed.
+ *
+ * @return true from the start button until the mixture is sealed or the machine faults.
+ */
+bool isProcessRunning() {
+    byte state = batch.getState();
+    return state != BATCH_IDLE && state != BATCH_FERMENTING && state != BATCH_FAULT && state != BATCH_CALIBRATE;
+}
+
+
+bool isLcdFound = false;  ///< Whether the I2C scan of the lcd command found the LCD
 
-    //turnOnCamera();
-    //delay(3000);
-    //turnOffCamera();
-    //shutdownMotors();
-    //resetSlider();
-    //mixIngredients();
+/**
+ * @brief Scans the I2C bus for the LCD, one address per call. A Logger reply source.
+ *
+ * Every device that answers gets a line, and the last line says whether the LCD was among them. Probing one address
+ * per log update spreads the scan over about 0.6 s instead of holding the bus and the loop for all 126 addresses.
+ *
+ * @param cursor Next address to probe, 0 before the scan starts.
+ * @param line Buffer for the line; left empty while nothing was found.
+ * @return true until the result line has been formatted.
+ */
+bool scanI2cForLcd(byte& cursor, TextBuffer& line) {
+    static const char hexDigits[] PROGMEM = "0123456789ABCDEF";
+    if (cursor == 0) {
+        isLcdFound = false;
+        cursor = 1;
+    }
+    if (cursor < 127) {
+        byte address = cursor++;
+        Wire.beginTransmission(address);
+        if (Wire.endTransmission() == 0) {
+            line.append(F("I2C device found at address 0x")).append((char)pgm_read_byte(&hexDigits[address >> 4]));
+            line.append((char)pgm_read_byte(&hexDigits[address & 0x0F]));
+            if (address == 0x20) {
+                line.append(F(" (LCD)"));
+                isLcdFound = true;
+            }
+        }
+        return true;
+    }
+    if (cursor++ > 127) {
+        return false;
+    }
+    if (isLcdFound) {
+        line.append(F("LCD at 0x20 is detected."));
+    } else {
+        line.append(F("LCD not found at 0x20."));
+    }
+    return true;
 }
 
+void testEeprom(){
+    LOG_INFO("EEPROM STATE: % sub-step %", batch.getStateName(), batch.getSubStep());
+}
+
+
+  
+
+
 void loopCamera(){
     //Camera turning on or off, 3 long buzzer beeps
-    if (cameraButton.isPressed()){
-        if(!isCameraRunning){
-            Serial.println("Camera button is pressed");
-            lcdPrint("Camera webserver", "is now running.", true);
+    if (cameraButton.wasPressed()){
+        if (cameraPhase == CAMERA_OFF || cameraPhase == CAMERA_STOPPING) {
+            LOG_DEBUG("Camera button is pressed");
+            lcdPrint(F("Camera webserver"), F("is now running."), true);
             turnOnCamera();
-            cameraTimer.timerStart(cameraWebserverDuration * 60, turnOffCamera);
-            Serial.println("Camera webserver is turned on for 300 seconds");
-            isCameraRunning = true;
+            LOG_INFO("Camera webserver is turned on for 300 seconds");
 
         } else {
-            Serial.println("Camera button is pressed");
-            lcdPrint("Camera webserver", "is closed.", true);
+            LOG_DEBUG("Camera button is pressed");
+            lcdPrint(F("Camera webserver"), F("is closed."), true);
             turnOffCamera();
-            cameraTimer.timerCancel();
-            isCameraRunning = false;
         }  
     }
-    cameraTimer.timerLoop(); //automatically turn off camera for specified time to save power and avoid overheating of flash light.
 }
 
-void addBanana() {
-    if (!bananaAdded.isPositive()) {
-        lcdPrint("CHOPPER RUNNING", "INSERT BANANA");
-        weighingScale.tare();  // reset to 0
-        float _currentBananaWeight = 0;
+/**
+ * @brief Advances the camera's power sequence.
+ *
+ * Beeps once the camera has booted or shut down. A running camera is turned off when its webserver time is up, to
+ * save power and avoid overheating the flash light.
+ */
+void serviceCameraPower() {
+    switch (cameraPhase) {
+        case CAMERA_STARTING:
+            beepCamera();
+            cameraPhase = CAMERA_RUNNING;
+            scheduler.runTaskIn(cameraPowerTask, cameraWebserverDuration * 60000UL);
+            break;
+        case CAMERA_RUNNING:
+            turnOffCamera();
+            break;
+        case CAMERA_STOPPING:
+            beepCamera();
+            cameraPhase = CAMERA_OFF;
+            break;
+        case CAMERA_OFF:
+            break;
+    }
+}
+
+/**
+ * @brief Debounces the limit switches and buttons.
+ */
+void serviceInputs() {
+    LimitSwitch::updateAll();  // Presses are read by the other tasks as single events
+}
+
+/**
+ * @brief Collects a weighing scale sample when the HX711 has one ready.
+ */
+void serviceScale() {
+    PROFILE_SCOPE(ZONE_SCALE);
+    if (weighingScale.update() && !isScaleFilterMeasured && weighingScale.isSamplePeriodMeasured()) {
+        configureScaleFilter();  // Sized at the nominal rate in setup; the board may run at another one
+        isScaleFilterMeasured = true;
+    }
+}
+
+// ======================= Telemetry =======================
+// Binary records for monitoring on Serial1 (TX1, pin 18), separate from the text log so neither corrupts the other.
+// The record layouts are listed in tools/telemetry_decode.py.
+const unsigned long telemetryBaud = 115200;
+const unsigned long telemetryAxesInterval = 100;    // ms between axis position records
+const unsigned long telemetryStatusInterval = 1000; // ms between state and timing records (state also on change)
+Telemetry telemetry(Serial1);
+
+enum TelemetryRecord : byte {
+    TELEMETRY_WEIGHT = 1,  // Sample count (uint16), raw reading (int32), filtered weight (0.01 g, int32)
+    TELEMETRY_AXES = 2,    // Position (int32) and AxisState (byte) of slider, sealer, mixing tool and mixer
+    TELEMETRY_STATE = 3,   // Batch state, sub-step, dosing phase (bytes)
+    TELEMETRY_TIMING = 4   // Max loop latency (us), log drops, telemetry drops (uint32)
+};
+
+unsigned long telemetrySampleCount = 0;  ///< Scale sample count at the last weight record
+unsigned long lastAxesRecordMs = 0;      ///< Time of the last axis record
+unsigned long lastStatusRecordMs = 0;    ///< Time of the last state and timing records
+byte lastTelemetryState = 0xFF;          ///< Batch state and sub-step at the last state record
+
+/**
+ * @brief Adds the position and axis state of a stepper to an axis record.
+ *
+ * @param stepper The stepper to report.
+ */
+void addAxis(const StepperController& stepper) {
+    telemetry.addInt32(stepper.getPosition());
+    telemetry.addByte(stepper.getAxisState());
+}
+
+/**
+ * @brief Sends the telemetry records that are due.
+ *
+ * A weight record goes out for every new scale sample. Axis positions follow every telemetryAxesInterval, and
+ * the state every telemetryStatusInterval or as soon as it changes. Records the port has no room for are dropped
+ * and show as sequence gaps on the host.
+ */
+void serviceTelemetry() {
+    PROFILE_SCOPE(ZONE_TELEMETRY);
+    unsigned long now = millis();
+
+    if (weighingScale.getSampleCount() != telemetrySampleCount) {
+        telemetrySampleCount = weighingScale.getSampleCount();
+        telemetry.beginFrame(TELEMETRY_WEIGHT, now);
+        telemetry.addInt16((int16_t)telemetrySampleCount);
+        telemetry.addInt32(weighingScale.getLatestRaw());
+        telemetry.addInt32(lround(weighingScale.getWeight() * 100.0f));
+        telemetry.endFrame();
+    }
 
-        while (_currentBananaWeight < 500) {  // keep running until at least 500g
-            turnOnChopper();
-            _currentBananaWeight = getWeight();
-            String _weightString = "WEIGHT: " + String(_currentBananaWeight, 2) + "g";
-            lcdPrint("ADDING BANANA", _weightString);
-            delay(500);  // optional: small delay to avoid flickering
+    if (now - lastAxesRecordMs >= telemetryAxesInterval) {
+        lastAxesRecordMs = now;
+        telemetry.beginFrame(TELEMETRY_AXES, now);
+        addAxis(sliderStepper);
+        addAxis(sealerStepper);
+        addAxis(mixingToolStepper);
+        addAxis(mixerStepper);
+        telemetry.endFrame();
+    }
+
+    byte state = (batch.getState() << 4) | batch.getSubStep();
+    bool isStatusDue = now - lastStatusRecordMs >= telemetryStatusInterval;
+    if (state != lastTelemetryState || isStatusDue) {
+        telemetry.beginFrame(TELEMETRY_STATE, now);
+        telemetry.addByte(batch.getState());
+        telemetry.addByte(batch.getSubStep());
+        telemetry.addByte(dosingPhase);
+        if (telemetry.endFrame()) {
+            lastTelemetryState = state;
         }
+    }
 
-        turnOffChopper();
-        bananaAdded.setStatus(true);
+    if (isStatusDue) {
+        lastStatusRecordMs = now;
+        telemetry.beginFrame(TELEMETRY_TIMING, now);
+        telemetry.addInt32(scheduler.getMaxLatency());
+        telemetry.addInt32(logger.getDropCount());
+        telemetry.addInt32(telemetry.getDropCount());
+        telemetry.endFrame();
     }
 }
 
+// ======================= Command Console =======================
+// Commands typed on Serial (end the line with CR or LF). Replies go through the log. Anything that moves the
+// machine is only accepted while the batch is idle.
 
-void addMolasses() {
-    if (bananaAdded.isPositive()) {
-        if (!molassesAdded.isPositive()) {
-            lcdPrint("PUMP RUNNING", "ADD MOLASSES");
-            weighingScale.tare();  // reset scale to zero
-            float _currentMolassesWeight = 0;
+/**
+ * @brief An axis that can be jogged from the console, with the switches that end its travel.
+ */
+struct ConsoleAxis {
+    char name[8];                 ///< Name typed after jog
+    StepperController* stepper;   ///< Axis motor
+    LimitSwitch* negativeLimit;   ///< Switch at the end of negative travel, or nullptr
+    LimitSwitch* positiveLimit;   ///< Switch at the end of positive travel, or nullptr
+    long maxSteps;                ///< Longest jog in either direction, the axis' full travel
+    long maxPosition;             ///< Unswitched end of positive travel while the position is known, 0 for none
+};
 
-            while (_currentMolassesWeight < 500) {  // run until weight reaches 500g
-                turnOnPump();
-                _currentMolassesWeight = getWeight();
-                String _weightString = "WEIGHT: " + String(_currentMolassesWeight, 2) + "g";
-                lcdPrint("ADDING MOLASSES", _weightString);
-                delay(500);
-            }
+const ConsoleAxis consoleAxes[] PROGMEM = {
+    { "slider", &sliderStepper,     &sliderHomeSwitch, nullptr,          sliderEndPosition, sliderEndPosition },
+    { "sealer", &sealerStepper,     &sealerDownSwitch, &sealerUpSwitch,  sealerUpTravel,    0 },
+    { "tool",   &mixingToolStepper, nullptr,           nullptr,          stirSteps,         0 },
+    { "mixer",  &mixerStepper,      &mixerUpSwitch,    &mixerDownSwitch, -mixerUpTravel,    0 },
+};
+const byte consoleAxisCount = sizeof(consoleAxes) / sizeof(consoleAxes[0]);
+
+extern CommandConsole console;
 
-            turnOffPump();
-            molassesAdded.setStatus(true);
+/**
+ * @brief Starts a reply of many lines, or replies busy while the previous one is still being sent.
+ *
+ * @param source Formats the reply line by line.
+ */
+void sendReply(ReplySource source) {
+    if (!logger.startReply(source)) {
+        logger.print(F("[Console] Busy, the previous reply is still being sent."));
+    }
+}
+
+/**
+ * @brief Formats the help line of the next command. A Logger reply source.
+ */
+bool formatHelpLine(byte& cursor, TextBuffer& line) {
+    return console.formatHelp(cursor, line);
+}
+
+/**
+ * @brief Formats the run times of the next task. A Logger reply source.
+ */
+bool formatStatsLine(byte& cursor, TextBuffer& line) {
+    return scheduler.formatStats(cursor, line);
+}
+
+/**
+ * @brief Checks that the machine is idle, replying if it is not.
+ *
+ * @return true if the batch is idle and no axis is moving.
+ */
+bool isIdleForCommand() {
+    if (batch.getState() != BATCH_IDLE || motion.isBusy()) {
+        logger.print(F("[Console] Busy, stop the process first (reset)."));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Compares a typed word with a PROGMEM name, ignoring case and treating '_' as a space.
+ *
+ * @param word The typed word.
+ * @param name The PROGMEM name.
+ * @return true if they match.
+ */
+bool matchesName(const char* word, PGM_P name) {
+    char c;
+    while ((c = pgm_read_byte(name++)) != '\0') {
+        char typed = (*word == '_') ? ' ' : toupper(*word);
+        if (typed != toupper(c)) {
+            return false;
         }
+        word++;
     }
+    return *word == '\0';
 }
 
+void commandHelp(byte, char*[]) {
+    sendReply(formatHelpLine);
+}
+
+void commandStatus(byte, char*[]) {
+    logger.print(F("State % sub-step %"), batch.getStateName(), batch.getSubStep());
+    if (weighingScale.isStable()) {
+        logger.print(F("Weight % g (stable)"), LogArg(getWeight(), 2));
+    } else {
+        logger.print(F("Weight % g (settling)"), LogArg(getWeight(), 2));
+    }
+    logger.print(F("Max loop latency % us, log drops %"), scheduler.getMaxLatency(), logger.getDropCount());
+    logger.print(F("Telemetry sent %, dropped %"), telemetry.getSentCount(), telemetry.getDropCount());
+}
+
+void commandWeight(byte, char*[]) {
+    logger.print(F("Weight % g, raw %"), LogArg(getWeight(), 2), weighingScale.getLatestRaw());
+    logger.print(F("Sample period % us, factor %"), weighingScale.getSamplePeriod(),
+                 LogArg(weighingScale.getScale(), 3));
+}
 
-void mix(){
-    if(molassesAdded.isPositive()){
-        if(!mixtureMixed.isPositive()){
-            mixIngredients();
-            mixtureMixed.setStatus(true);
+void commandTare(byte, char*[]) {
+    if (isIdleForCommand()) {
+        weighingScale.startTare();
+        logger.print(F("Taring once the reading is stable."));
+    }
+}
+
+void commandAxes(byte, char*[]) {
+    for (byte i = 0; i < consoleAxisCount; i++) {
+        ConsoleAxis axis;
+        memcpy_P(&axis, &consoleAxes[i], sizeof(axis));
+        const __FlashStringHelper* name = reinterpret_cast<const __FlashStringHelper*>(consoleAxes[i].name);
+        if (axis.stepper->isPositionKnown()) {
+            logger.print(F("% at % steps"), name, axis.stepper->getPosition());
+        } else {
+            logger.print(F("% at % steps (position lost)"), name, axis.stepper->getPosition());
+        }
+    }
+}
+
+void commandSwitches(byte, char*[]) {
+    sendReply(formatSwitchStates);
+}
+
+/**
+ * @brief Moves an axis by a number of steps.
+ *
+ * The steps are clamped to the axis' travel, and for a known position to the unswitched end of the slider. The move
+ * is refused if the switch in its direction is already pressed, and stops on contact if it closes on the way. Steps
+ * are counted, so a homed axis keeps its position.
+ */
+void commandJog(byte argc, char* argv[]) {
+    long steps;
+    if (argc != 3 || !CommandConsole::parseLong(argv[2], steps)) {
+        logger.print(F("[Console] Usage: jog <axis> <steps>"));
+        return;
+    }
+    for (byte i = 0; i < consoleAxisCount; i++) {
+        if (!matchesName(argv[1], consoleAxes[i].name)) {
+            continue;
+        }
+        if (!isIdleForCommand()) {
+            return;
         }
+        ConsoleAxis axis;
+        memcpy_P(&axis, &consoleAxes[i], sizeof(axis));
+        steps = constrain(steps, -axis.maxSteps, axis.maxSteps);
+        if (axis.maxPosition != 0 && axis.stepper->isPositionKnown()) {
+            steps = min(steps, axis.maxPosition - axis.stepper->getPosition());
+        }
+        LimitSwitch* limit = (steps < 0) ? axis.negativeLimit : axis.positiveLimit;
+        if (limit != nullptr && limit->isTriggered()) {
+            logger.print(F("[Console] Limit switch already pressed in that direction."));
+            return;
+        }
+        if (limit != nullptr) {
+            motion.moveToLimit(*axis.stepper, steps, *limit, true);
+        } else {
+            motion.moveTo(*axis.stepper, steps);
+        }
+        logger.print(F("Jogging % by % steps"), reinterpret_cast<const __FlashStringHelper*>(consoleAxes[i].name),
+                     steps);
+        return;
     }
+    logger.print(F("[Console] Unknown axis, use slider, sealer, tool or mixer."));
 }
 
-void sealMixture(){
-    if(mixtureMixed.isPositive()){
-        if(!mixtureSealed.isPositive()){
-            seal();
-            mixtureSealed.setStatus(true);
+void commandStop(byte, char*[]) {
+    motion.stop();
+    logger.print(F("Motion stopped."));
+}
+
+/**
+ * @brief Enters a batch state by name or number, e.g. "stage homing", "stage add_banana" or "stage 1".
+ *
+ * Any state can be entered from IDLE, which starts the process there; from any other state only "stage idle" is
+ * accepted, which works like the reset button. Without a name the states are listed.
+ */
+void commandStage(byte argc, char* argv[]) {
+    if (argc < 2) {
+        for (byte id = 0; id < batch.getStateCount(); id++) {
+            logger.print(F("  % %"), id, batch.getStateName(id));
+        }
+        return;
+    }
+    long number;
+    bool isNumber = CommandConsole::parseLong(argv[1], number);
+    for (byte id = 0; id < batch.getStateCount(); id++) {
+        if (isNumber ? number != id : !matchesName(argv[1], reinterpret_cast<PGM_P>(batch.getStateName(id)))) {
+            continue;
+        }
+        if (id == BATCH_IDLE) {
+            motion.stop();
+        } else if (!isIdleForCommand()) {
+            return;
         }
+        batch.transitionTo(id);
+        logger.print(F("Entered %"), batch.getStateName());
+        return;
     }
+    logger.print(F("[Console] Unknown stage, type stage for the list."));
 }
 
-void emergencyStop(){
-    if(resetButton.isPressed() && processStarted){
-        Serial.println("Emergency stop. Shutting down machine now");
+void commandRtc(byte, char*[]) {
+    if (!isRtcReady) {
+        logger.print(F("[Console] RTC not detected."));
+        return;
     }
+    sendReply(formatRtcTime);
 }
 
+void commandLcd(byte, char*[]) {
+    sendReply(scanI2cForLcd);
+}
 
-void loop() {
-    loopCamera();
-    
-    //testLimitSwitch();
-    //testRtc();
-    //testEeprom();
-    //checkLcd();
-
-    if (startButton.isPressed()){
-        Serial.println("Start button is pressed");
-        if(!processStarted){
-            processStarted = true;
-            Serial.println("Process started");
+void commandEeprom(byte, char*[]) {
+    testEeprom();
+}
+
+void commandStats(byte, char*[]) {
+    logger.print(F("Longest step tick % us of %"), StepTimer::getMaxTickUs(), StepTimer::TICK_US);
+    logger.print(F("Free RAM % bytes, low water % bytes"), RamMonitor::getFree(), RamMonitor::getLowWater());
+    logger.print(F("Heap % bytes"), RamMonitor::getHeapSize());
+    sendReply(formatStatsLine);  // The task table follows the lines above
+}
+
+#if PROFILER_ENABLED
+/**
+ * @brief Formats the next line of the timing report. A Logger reply source.
+ */
+bool formatProfileLine(byte& cursor, TextBuffer& line) {
+    return profiler.formatReport(cursor, line);
+}
+
+/**
+ * @brief Prints the timing zones, or clears them with "profile reset".
+ */
+void commandProfile(byte argc, char* argv[]) {
+    if (argc == 2 && strcmp_P(argv[1], PSTR("reset")) == 0) {
+        profiler.reset();
+        logger.print(F("Profile cleared."));
+        return;
+    }
+    sendReply(formatProfileLine);
+}
+#endif
+
+void commandLog(byte argc, char* argv[]) {
+    long level;
+    if (argc != 2 || !CommandConsole::parseLong(argv[1], level) || level < LOG_LEVEL_NONE || level > LOG_LEVEL_DEBUG) {
+        logger.print(F("[Console] Usage: log <0-4> (none, error, warn, info, debug)"));
+        return;
+    }
+    logger.setLevel(level);
+    logger.print(F("Log level %"), level);
+}
+
+const ConsoleCommand consoleCommands[] PROGMEM = {
+    { "help",     "List the commands",                       commandHelp },
+    { "status",   "Batch state, weight and timing",          commandStatus },
+    { "weight",   "Scale reading and calibration",           commandWeight },
+    { "tare",     "Zero the scale (idle only)",              commandTare },
+    { "axes",     "Axis positions",                          commandAxes },
+    { "switches", "Limit switch states",                     commandSwitches },
+    { "jog",      "<slider|sealer|tool|mixer> <steps>",      commandJog },
+    { "stop",     "Stop all axes",                           commandStop },
+    { "stage",    "[name|number] Enter or list states",     commandStage },
+    { "rtc",      "Print the RTC date and time",             commandRtc },
+    { "lcd",      "Scan the I2C bus for the LCD",            commandLcd },
+    { "eeprom",   "Print the persisted batch state",         commandEeprom },
+    { "stats",    "Task run times and free RAM",             commandStats },
+#if PROFILER_ENABLED
+    { "profile",  "[reset] Timing zones and histograms",     commandProfile },
+#endif
+    { "log",      "<0-4> Set the log level",                 commandLog },
+};
+
+CommandConsole console(Serial, consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]));
+
+/**
+ * @brief Reads typed commands and runs them.
+ */
+void serviceConsole() {
+    console.update();
+}
+
+/**
+ * @brief Writes queued log text as far as the serial TX buffer has room.
+ */
+void serviceLog() {
+    logger.update();
+}
+
+/**
+ * @brief Plays the queued buzzer sounds.
+ */
+void serviceBuzzer() {
+    buzzer.update();
+}
+
+/**
+ * @brief Times the batch stages from entering one to entering the next.
+ *
+ * A stage is only recorded when the batch moves on to a later stage or finishes; a stage left by reset or a fault
+ * is dropped so aborted runs do not skew the times.
+ */
+void profileStage() {
+    static byte profiledState = BATCH_IDLE;
+    byte state = batch.getState();
+    if (state == profiledState) {
+        return;
+    }
+    bool isCompleted = state != BATCH_IDLE && state != BATCH_FAULT;
+    if (isCompleted && profiledState >= BATCH_HOMING && profiledState <= BATCH_SEAL) {
+        PROFILE_STOP(ZONE_HOMING + profiledState - BATCH_HOMING);
+    }
+    if (state >= BATCH_HOMING && state <= BATCH_SEAL) {
+        PROFILE_START(ZONE_HOMING + state - BATCH_HOMING);
+    }
+    profiledState = state;
+}
+
+/**
+ * @brief Names the timing zones for the profile report.
+ */
+void setupProfiler() {
+    PROFILE_NAME(ZONE_LOOP, "loop");
+    PROFILE_NAME(ZONE_MACHINE, "machine");
+    PROFILE_NAME(ZONE_SCALE, "scale");
+    PROFILE_NAME(ZONE_LCD, "lcd");
+    PROFILE_NAME(ZONE_TELEMETRY, "telemetry");
+    PROFILE_NAME(ZONE_HOMING, "stage homing");
+    PROFILE_NAME(ZONE_ADD_BANANA, "stage banana");
+    PROFILE_NAME(ZONE_ADD_MOLASSES, "stage molasses");
+    PROFILE_NAME(ZONE_MIX, "stage mix");
+    PROFILE_NAME(ZONE_SEAL, "stage seal");
+}
+
+/**
+ * @brief Handles the start and reset buttons and runs the FFJ process.
+ */
+void runMachine() {
+    PROFILE_SCOPE(ZONE_MACHINE);
+    if (startButton.wasPressed()){
+        LOG_DEBUG("Start button is pressed");
+        if (batch.getState() == BATCH_IDLE){
+            LOG_INFO("Process started");
+            batch.transitionTo(BATCH_HOMING);
+        } else if (batch.getState() == BATCH_CALIBRATE) {
+            isCalibrationConfirmed = true;
         } else {
-            Serial.println("Process is already going on.");
+            LOG_INFO("Process is already going on.");
         }
     }
 
-    if(processStarted){
-        //turn on chopper
-        addBanana();
-        addMolasses();
-        mix();
-    } else {
-        lcdPrint("MACHINE READY.","PRESS START");
+    static bool isResetPressedInIdle = false;  // A hold that stopped a batch must not go on into calibration
+    if (resetButton.wasPressed()){
+        LOG_DEBUG("Reset button is pressed");
+        isResetPressedInIdle = (batch.getState() == BATCH_IDLE);
+        bool wasRunning = isProcessRunning();
+        if (wasRunning){
+            LOG_INFO("Process stopped");
+            motion.stop();
+        }
+        if (batch.getState() != BATCH_IDLE){
+            LOG_INFO("Resetting machine now");
+            batch.transitionTo(BATCH_IDLE);  // Exit actions turn the chopper and pump off
+        }
+        if (wasRunning){
+            turnOffCamera();  // Beeps from its task once the camera is down
+        }
     }
 
-    if (resetButton.isPressed()){
-        Serial.println("Start button is pressed");
-        if (processStarted){
-            Serial.println("Process stopped");
-            turnOffCamera();
-            turnOffChopper();
-        } 
+    if (resetButton.wasLongPressed() && isResetPressedInIdle && batch.getState() == BATCH_IDLE){
+        LOG_INFO("Reset button is held, calibrating the scale");
+        batch.transitionTo(BATCH_CALIBRATE);
+    }
 
-        if (processCompleted){
-            Serial.println("Resetting machine now");
-        }
+    batch.update();
+    profileStage();
+}
+
+/**
+ * @brief Sends the run time of every task through the log.
+ */
+void printTaskStats() {
+    logger.startReply(formatStatsLine);  // Skipped while a console reply is still being sent
+}
+
+/**
+ * @brief Registers the machine's work with the scheduler.
+ *
+ * The input and buzzer tasks run from the start so setup's waits keep them serviced; the camera button and the
+ * process only start once setup() is done.
+ */
+void setupScheduler() {
+    scheduler.addTask("inputs", serviceInputs, inputsPeriod);
+    scheduler.addTask("log", serviceLog, logPeriod);
+    scheduler.addTask("telemetry", serviceTelemetry, telemetryPeriod);
+    scheduler.addTask("console", serviceConsole, consolePeriod);
+    scheduler.addTask("buzzer", serviceBuzzer, buzzerPeriod);
+    scheduler.addTask("scale", serviceScale, scalePeriod);
+    lcdTask = scheduler.addTask("lcd", serviceLcd, lcdPeriod, false);  // Enabled once the LCD is initialized
+    lcdClearTask = scheduler.addTask("lcd-clear", clearLcd, 0, false);
+    cameraPowerTask = scheduler.addTask("camera-power", serviceCameraPower, 0, false);
+    cameraTask = scheduler.addTask("camera", loopCamera, cameraPeriod, false);
+    machineTask = scheduler.addTask("machine", runMachine, machinePeriod, false);
+    if (taskStatsPeriod > 0) {
+        scheduler.addTask("stats", printTaskStats, taskStatsPeriod);
     }
-    //Serial.print(".");
+}
 
-    delay(100);
+void setup() {
+    RamMonitor::paint();  // Before anything else runs, so the low-water mark covers all of it
+    Serial.begin(9600);
+    Serial1.begin(telemetryBaud);
+    logger.setBlocking(true);  // Nothing runs yet that the log could hold up, so keep every setup message
+    Wire.begin();
+    setupProfiler();
+    setupScheduler();
+    setupBuzzer();
 
+    powerOnBeep();
+    setupRelay();
+    setupLimitSwitches();
+    setupStepperMotors();
+    setupMotors();
+    setupWeighingScale();
+    setupLcd();
+    setupRtc();
+    powerUpMotors();
+
+    bananaDosing.configure(bananaStopLatency, 0.0f, dosingLearningRate);
+    molassesDosing.configure(molassesStopLatency, molassesTrickleBand, dosingLearningRate);
+    loadDosing(bananaDosing, bananaTarget, bananaCorrectionAddress);
+    loadDosing(molassesDosing, molassesTarget, molassesCorrectionAddress);
 
+    // Continue an interrupted batch where it stopped; axes are only homed when a step needs them
+    if (batch.begin()) {
+        LOG_INFO("[Setup] Resuming batch at %, sub-step %", batch.getStateName(), batch.getSubStep());
+    }
+    if (batch.getState() == BATCH_FERMENTING) {
+        lcdPrint(F("FERMENTING"), F("WAIT FOR DAYS"));
+    }
+
+    logger.setBlocking(false);
+    scheduler.enableTask(cameraTask);
+    scheduler.enableTask(machineTask);
+}
+
+void loop() {
+    PROFILE_SCOPE(ZONE_LOOP);
+    scheduler.run();
 }
-  
@@ -0,0 +1,165 @@
+/**
+ * @file test_main.cpp
+ * @brief Bytes LcdFrameBuffer sends to the display, counted on a fake LCD.
+ *
+ * The fake LCD is a HalDevice that keeps the characters written to it and counts them. Cursor moves do not reach
+ * the device, so every byte on the bus is counted from the virtual time instead: NativeHal charges LCD_BYTE_US for
+ * each character and each setCursor().
+ *
+ *     pio test -e native -f test_lcd_framebuffer
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LcdFrameBuffer.h"
+
+namespace {
+
+const byte lcdAddress = 0x20;
+const byte cols = LcdFrameBuffer::COLS;
+const byte rows = LcdFrameBuffer::ROWS;
+
+/**
+ * @class FakeLcd
+ * @brief Character LCD that records what is written to it.
+ */
+class FakeLcd : public HalDevice {
+public:
+    FakeLcd() {
+        this->writes = 0;
+        memset(screen, ' ', sizeof(screen));
+    }
+
+    void advance(unsigned long us) override {
+        (void)us;
+    }
+
+    void onLcdWrite(uint8_t address, uint8_t col, uint8_t row, char c) override {
+        if (address == lcdAddress && col < cols && row < rows) {
+            screen[row][col] = c;
+            writes++;
+        }
+    }
+
+    /**
+     * @brief Checks a line of the display.
+     *
+     * @param row Line to check.
+     * @param text Expected text, COLS characters long.
+     * @return true if the line shows exactly the text.
+     */
+    bool shows(byte row, const char* text) const {
+        return memcmp(screen[row], text, cols) == 0;
+    }
+
+    unsigned long writes;       ///< Characters written since construction or the last reset
+    char screen[rows][cols];    ///< Characters on the display
+};
+
+FakeLcd fakeLcd;
+LiquidCrystal_I2C lcd(lcdAddress, cols, rows);
+LcdFrameBuffer frameBuffer(lcd);
+
+/**
+ * @brief Draws a full frame and flushes it, so every test starts from the same screen.
+ */
+void drawBaseFrame() {
+    frameBuffer.print(0, 0, "Weight  500.0 g ");
+    frameBuffer.print(1, 0, "ADD BANANA      ");
+    frameBuffer.flush();
+}
+
+/**
+ * @brief Flushes the buffer and counts what reached the display.
+ *
+ * @param writes Receives the characters written.
+ * @return Bytes sent on the bus, cursor moves included.
+ */
+unsigned long flushAndCount(unsigned long& writes) {
+    fakeLcd.writes = 0;
+    uint64_t startUs = NativeHal::nowUs();
+    unsigned long sentBefore = frameBuffer.getBytesSent();
+    frameBuffer.flush();
+    unsigned long busBytes = (unsigned long)((NativeHal::nowUs() - startUs) / NativeHal::LCD_BYTE_US);
+    TEST_ASSERT_EQUAL(busBytes, frameBuffer.getBytesSent() - sentBefore);
+    writes = fakeLcd.writes;
+    return busBytes;
+}
+
+}  // namespace
+
+void setUp() {
+    lcd.init();
+    frameBuffer.begin();
+    drawBaseFrame();
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Writing the same text again sends nothing.
+ */
+void testUnchangedFrame() {
+    drawBaseFrame();
+    TEST_ASSERT_FALSE(frameBuffer.isDirty());
+
+    unsigned long writes;
+    TEST_ASSERT_EQUAL(0, flushAndCount(writes));
+    TEST_ASSERT_EQUAL(0, writes);
+}
+
+/**
+ * @brief Changing one digit costs one cursor move and one character.
+ */
+void testSingleCharacterChange() {
+    frameBuffer.print(0, 8, "6");
+
+    unsigned long writes;
+    TEST_ASSERT_EQUAL(2, flushAndCount(writes));
+    TEST_ASSERT_EQUAL(1, writes);
+    TEST_ASSERT_TRUE(fakeLcd.shows(0, "Weight  600.0 g "));
+    TEST_ASSERT_TRUE(fakeLcd.shows(1, "ADD BANANA      "));
+}
+
+/**
+ * @brief Replacing every character costs one cursor move per line and all 32 characters, with no clear.
+ */
+void testFullRedraw() {
+    frameBuffer.print(0, 0, "abcdefghijklmnop");
+    frameBuffer.print(1, 0, "0123456789012345");
+
+    unsigned long writes;
+    TEST_ASSERT_EQUAL(rows + rows * cols, flushAndCount(writes));
+    TEST_ASSERT_EQUAL(rows * cols, writes);
+    TEST_ASSERT_TRUE(fakeLcd.shows(0, "abcdefghijklmnop"));
+    TEST_ASSERT_TRUE(fakeLcd.shows(1, "0123456789012345"));
+}
+
+/**
+ * @brief A limited flush sends a slice of the changes and the next calls finish them.
+ */
+void testLimitedFlush() {
+    frameBuffer.printCentered(1, "FERMENTING");
+
+    unsigned long sentBefore = frameBuffer.getBytesSent();
+    fakeLcd.writes = 0;
+    TEST_ASSERT_TRUE(frameBuffer.flush(4));
+    TEST_ASSERT_EQUAL(4, frameBuffer.getBytesSent() - sentBefore);
+    TEST_ASSERT_TRUE(frameBuffer.isDirty());
+    while (frameBuffer.flush(4)) {
+    }
+    TEST_ASSERT_FALSE(frameBuffer.isDirty());
+    TEST_ASSERT_TRUE(fakeLcd.shows(1, "   FERMENTING   "));
+}
+
+int main() {
+    NativeHal::attach(&fakeLcd);
+
+    UNITY_BEGIN();
+    RUN_TEST(testUnchangedFrame);
+    RUN_TEST(testSingleCharacterChange);
+    RUN_TEST(testFullRedraw);
+    RUN_TEST(testLimitedFlush);
+    return UNITY_END();
+}
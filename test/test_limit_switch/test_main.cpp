@@ -0,0 +1,155 @@
+/**
+ * @file test_main.cpp
+ * @brief Debouncing and the press, release and long-press events of LimitSwitch.
+ *
+ * Each test replays a trace of input edges on a switch pin, sampling it with update() every inputPeriodMs as the
+ * firmware's input task does, and reads the events after every sample. Contact bounce must give exactly one press
+ * and one release per burst, and a hold exactly one long press, however long it lasts.
+ *
+ *     pio test -e native -f test_limit_switch
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "LimitSwitch.h"
+
+namespace {
+
+const byte switchPin = 30;
+const unsigned long inputPeriodMs = 2;  ///< Sampling period of the input task in src/main.cpp
+const unsigned long debounceMs = LimitSwitch::DEFAULT_DEBOUNCE_MS;
+const unsigned long longPressMs = LimitSwitch::DEFAULT_LONG_PRESS_MS;
+
+LimitSwitch limit(switchPin);
+
+/**
+ * @brief A change of the input level, in milliseconds from the start of the trace.
+ */
+struct Edge {
+    unsigned long atMs;  ///< Time of the change
+    bool isHigh;         ///< Level from then on (HIGH = closed)
+};
+
+/**
+ * @brief The events a trace produced, and when the first of each came.
+ */
+struct EventLog {
+    byte presses;               ///< Press events
+    byte releases;              ///< Release events
+    byte longPresses;           ///< Long-press events
+    unsigned long firstPressMs; ///< Time of the first press
+    unsigned long firstLongMs;  ///< Time of the first long press
+};
+
+/**
+ * @brief Replays a trace on the switch, initialized afresh with the input open, and counts its events.
+ *
+ * @param edges Input changes, in time order.
+ * @param edgeCount Number of changes.
+ * @param endMs Time the replay runs to.
+ * @return The counted events.
+ */
+EventLog replay(const Edge* edges, byte edgeCount, unsigned long endMs) {
+    NativeHal::setInput(switchPin, false);
+    limit.init();
+
+    EventLog log = { 0, 0, 0, 0, 0 };
+    unsigned long startMs = millis();
+    byte next = 0;
+    for (unsigned long t = 0; t <= endMs; t += inputPeriodMs) {
+        while (next < edgeCount && edges[next].atMs <= t) {
+            NativeHal::setInput(switchPin, edges[next++].isHigh);
+        }
+        limit.update(startMs + t);
+        if (limit.wasPressed()) {
+            if (log.presses++ == 0) {
+                log.firstPressMs = t;
+            }
+        }
+        if (limit.wasReleased()) {
+            log.releases++;
+        }
+        if (limit.wasLongPressed()) {
+            if (log.longPresses++ == 0) {
+                log.firstLongMs = t;
+            }
+        }
+    }
+    return log;
+}
+
+}  // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief A press and a release that each bounce for a few milliseconds give one press and one release.
+ */
+void testBounceBursts() {
+    const Edge edges[] = {
+        { 100, true }, { 101, false }, { 103, true }, { 104, false }, { 107, true },  // Press burst
+        { 600, false }, { 602, true }, { 603, false }, { 606, true }, { 608, false }, // Release burst
+    };
+    EventLog log = replay(edges, sizeof(edges) / sizeof(edges[0]), 1000);
+    TEST_ASSERT_EQUAL(1, log.presses);
+    TEST_ASSERT_EQUAL(1, log.releases);
+    TEST_ASSERT_EQUAL(0, log.longPresses);
+    // The press is accepted once the input has been stable for the debounce time after the last bounce.
+    TEST_ASSERT_UINT32_WITHIN(inputPeriodMs, 107 + debounceMs, log.firstPressMs);
+}
+
+/**
+ * @brief Spikes shorter than the debounce time, e.g. noise on the cable, give no events at all.
+ */
+void testShortSpikesIgnored() {
+    const Edge edges[] = {
+        { 100, true }, { 110, false }, { 300, true }, { 320, false }, { 500, true }, { 502, false },
+    };
+    EventLog log = replay(edges, sizeof(edges) / sizeof(edges[0]), 1000);
+    TEST_ASSERT_EQUAL(0, log.presses);
+    TEST_ASSERT_EQUAL(0, log.releases);
+    TEST_ASSERT_EQUAL(0, log.longPresses);
+}
+
+/**
+ * @brief A bouncy hold of three times the long-press time gives one long press, at the long-press time.
+ */
+void testLongPressOncePerHold() {
+    const Edge edges[] = {
+        { 100, true }, { 102, false }, { 105, true },
+        { 100 + 3 * longPressMs, false }, { 101 + 3 * longPressMs, true }, { 104 + 3 * longPressMs, false },
+    };
+    EventLog log = replay(edges, sizeof(edges) / sizeof(edges[0]), 4 * longPressMs);
+    TEST_ASSERT_EQUAL(1, log.presses);
+    TEST_ASSERT_EQUAL(1, log.releases);
+    TEST_ASSERT_EQUAL(1, log.longPresses);
+    TEST_ASSERT_UINT32_WITHIN(inputPeriodMs, log.firstPressMs + longPressMs, log.firstLongMs);
+}
+
+/**
+ * @brief Each of several holds gives its own long press, and a hold released early gives none.
+ */
+void testLongPressPerHold() {
+    const Edge edges[] = {
+        { 100, true }, { 100 + longPressMs + 500, false },                         // Long hold
+        { 3000, true }, { 3000 + longPressMs / 2, false },                         // Short hold
+        { 6000, true }, { 6003, false }, { 6005, true }, { 6000 + longPressMs + 500, false },  // Bouncy long hold
+    };
+    EventLog log = replay(edges, sizeof(edges) / sizeof(edges[0]), 10000);
+    TEST_ASSERT_EQUAL(3, log.presses);
+    TEST_ASSERT_EQUAL(3, log.releases);
+    TEST_ASSERT_EQUAL(2, log.longPresses);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testBounceBursts);
+    RUN_TEST(testShortSpikesIgnored);
+    RUN_TEST(testLongPressOncePerHold);
+    RUN_TEST(testLongPressPerHold);
+    return UNITY_END();
+}
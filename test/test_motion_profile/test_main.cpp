@@ -0,0 +1,267 @@
+/**
+ * @file test_main.cpp
+ * @brief Step timing of the acceleration profiles, checked on the mock StepTimer.
+ *
+ * A StepperController is moved tick by tick with StepTimer::advance() and the tick of every step is recorded from
+ * its position. The tests check the step count of the move and the step intervals of its acceleration, cruise and
+ * deceleration phases against the speeds they were configured with, also for a move stopped at speed.
+ *
+ *     pio test -e native -f test_motion_profile
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <vector>
+#include "StepperController.h"
+
+namespace {
+
+// The slider's settings from src/main.cpp: 1 ms pulse interval (500 steps/s start speed), 2000 steps/s cruise.
+const unsigned long startIntervalUs = 2000;
+const unsigned long startSpeed = 1000000UL / startIntervalUs;
+const unsigned long maxSpeed = 2000;
+const unsigned long acceleration = 4000;
+const unsigned long jerk = 20000;
+
+const unsigned long ticksPerSecond = MotionProfile::TICKS_PER_SECOND;
+const unsigned long startIntervalTicks = ticksPerSecond / startSpeed;  ///< 40 ticks (2 ms)
+const unsigned long cruiseIntervalTicks = ticksPerSecond / maxSpeed;   ///< 10 ticks (500 us)
+const unsigned long probeTicks = 1000;                                  ///< 50 ms into the move
+
+StepperController stepper(2, 3);
+
+/**
+ * @brief Step times and speeds of one move.
+ */
+struct MoveRecord {
+    std::vector<unsigned long> stepTicks;   ///< Tick at which each step was taken
+    std::vector<unsigned long> stepSpeeds;  ///< Profile speed at each step (steps/s)
+    unsigned long probeSpeed;               ///< Speed probeTicks after the start (steps/s)
+    long endPosition;                       ///< Position after the move
+};
+
+/**
+ * @brief Runs a move to completion on the mock timer and records every step.
+ *
+ * @param steps Number of steps to move.
+ * @param profileAcceleration Acceleration of the profile, or 0 for a constant step interval.
+ * @param profileJerk Jerk of the profile, or 0 for a trapezoid.
+ * @param stopTick Tick at which stop() is called, or 0 to let the move finish.
+ * @return The recorded move.
+ */
+MoveRecord runMove(long steps, unsigned long profileAcceleration, unsigned long profileJerk,
+                   unsigned long stopTick = 0) {
+    MoveRecord record;
+    record.probeSpeed = 0;
+
+    stepper.setStepInterval(startIntervalUs);
+    stepper.setMotionProfile(maxSpeed, profileAcceleration, profileJerk);
+    long position = stepper.getPosition();
+    long startPosition = position;
+    stepper.moveTo(steps);
+
+    unsigned long tick = 0;
+    unsigned long tickLimit = 2 * ticksPerSecond * (unsigned long)abs(steps) / startSpeed;
+    while (stepper.poll() && tick < tickLimit) {
+        unsigned long speed = stepper.getSpeed();
+        StepTimer::advance(StepTimer::TICK_US);
+        tick++;
+        if (tick == probeTicks) {
+            record.probeSpeed = speed;
+        }
+        if (tick == stopTick) {
+            stepper.stop();
+        }
+        if (stepper.getPosition() != position) {
+            position = stepper.getPosition();
+            record.stepTicks.push_back(tick);
+            record.stepSpeeds.push_back(speed);
+        }
+    }
+    StepTimer::advance(StepTimer::TICK_US);  ///< End the last pulse
+    record.endPosition = position - startPosition;
+    return record;
+}
+
+/**
+ * @brief Returns the interval before a step, in ticks.
+ *
+ * @param record The recorded move.
+ * @param step Index of the step; the first step is timed from the start of the move.
+ * @return Ticks since the previous step.
+ */
+unsigned long intervalBefore(const MoveRecord& record, size_t step) {
+    return record.stepTicks[step] - (step == 0 ? 0 : record.stepTicks[step - 1]);
+}
+
+/**
+ * @brief Returns the highest speed of a move, which it cruises at if it is long enough.
+ *
+ * @param record The recorded move.
+ * @return The peak speed (steps/s).
+ */
+unsigned long peakSpeed(const MoveRecord& record) {
+    unsigned long peak = 0;
+    for (size_t i = 0; i < record.stepSpeeds.size(); i++) {
+        if (record.stepSpeeds[i] > peak) {
+            peak = record.stepSpeeds[i];
+        }
+    }
+    return peak;
+}
+
+/**
+ * @brief Counts the steps taken below the peak speed at the start and at the end of a move.
+ *
+ * @param record The recorded move.
+ * @param accelSteps Receives the steps before the peak speed was first reached.
+ * @param decelSteps Receives the steps after the peak speed was last held.
+ */
+void countRampSteps(const MoveRecord& record, size_t& accelSteps, size_t& decelSteps) {
+    unsigned long peak = peakSpeed(record);
+    size_t count = record.stepSpeeds.size();
+    accelSteps = 0;
+    while (accelSteps < count && record.stepSpeeds[accelSteps] < peak) {
+        accelSteps++;
+    }
+    decelSteps = 0;
+    while (decelSteps < count && record.stepSpeeds[count - 1 - decelSteps] < peak) {
+        decelSteps++;
+    }
+}
+
+/**
+ * @brief Checks a full-length move: step count, start, cruise and stop intervals, and symmetric ramps.
+ *
+ * @param record The recorded move.
+ * @param steps Steps the move was started with.
+ * @param expectedRampSteps Steps an ideal profile takes to reach the cruise speed.
+ */
+void checkFullMove(const MoveRecord& record, long steps, unsigned long expectedRampSteps) {
+    TEST_ASSERT_EQUAL(steps, (long)record.stepTicks.size());
+    TEST_ASSERT_EQUAL(steps, record.endPosition);
+
+    // Steps land on the 50 us tick grid, so every interval may be one tick off the ideal one.
+    TEST_ASSERT_UINT32_WITHIN(1, startIntervalTicks, intervalBefore(record, 0));
+    TEST_ASSERT_UINT32_WITHIN(1, startIntervalTicks, intervalBefore(record, record.stepTicks.size() - 1));
+
+    // The fixed-point ramp levels off just below the cruise speed rather than overshooting it.
+    TEST_ASSERT_UINT32_WITHIN(maxSpeed / 100, maxSpeed, peakSpeed(record));
+    TEST_ASSERT_LESS_OR_EQUAL(maxSpeed, peakSpeed(record));
+
+    size_t accelSteps;
+    size_t decelSteps;
+    countRampSteps(record, accelSteps, decelSteps);
+    TEST_ASSERT_UINT32_WITHIN(expectedRampSteps / 50, expectedRampSteps, accelSteps);
+    TEST_ASSERT_UINT32_WITHIN(1, accelSteps, decelSteps);
+
+    for (size_t i = accelSteps + 1; i < record.stepTicks.size() - decelSteps; i++) {
+        TEST_ASSERT_UINT32_WITHIN(1, cruiseIntervalTicks, intervalBefore(record, i));
+    }
+    for (size_t i = 1; i < accelSteps; i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(intervalBefore(record, i - 1) + 1, intervalBefore(record, i));
+    }
+}
+
+}  // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief A trapezoid reaches the cruise speed in (v^2 - v0^2) / 2a = 469 steps, at a constant acceleration.
+ */
+void testTrapezoidTiming() {
+    MoveRecord record = runMove(3000, acceleration, 0);
+    checkFullMove(record, 3000, 469);
+    TEST_ASSERT_UINT32_WITHIN(5, startSpeed + acceleration * probeTicks / ticksPerSecond, record.probeSpeed);
+}
+
+/**
+ * @brief An S-curve ramps the acceleration with the jerk: it takes (v - v0) / a + a / j = 0.575 s to reach the cruise
+ * speed, at an average of (v + v0) / 2, i.e. 719 steps, and gains only j t^2 / 2 in the first 50 ms.
+ */
+void testSCurveTiming() {
+    MoveRecord record = runMove(3000, acceleration, jerk);
+    checkFullMove(record, 3000, 719);
+    TEST_ASSERT_UINT32_WITHIN(5, startSpeed + jerk * probeTicks * probeTicks / (2 * ticksPerSecond * ticksPerSecond),
+                              record.probeSpeed);
+}
+
+/**
+ * @brief A move too short to reach the cruise speed turns around halfway and still ends at the start speed.
+ */
+void testShortMoveTiming() {
+    const long steps = 400;
+    unsigned long jerks[] = { 0, jerk };
+    for (unsigned long profileJerk : jerks) {
+        MoveRecord record = runMove(steps, acceleration, profileJerk);
+        TEST_ASSERT_EQUAL(steps, (long)record.stepTicks.size());
+        TEST_ASSERT_EQUAL(steps, record.endPosition);
+
+        TEST_ASSERT_LESS_THAN(maxSpeed * 9 / 10, peakSpeed(record));  ///< Never near the cruise speed
+
+        unsigned long shortest = intervalBefore(record, 0);
+        size_t fastestStep = 0;
+        for (size_t i = 1; i < record.stepTicks.size(); i++) {
+            if (intervalBefore(record, i) < shortest) {
+                shortest = intervalBefore(record, i);
+                fastestStep = i;
+            }
+        }
+        TEST_ASSERT_GREATER_THAN(cruiseIntervalTicks, shortest);
+        TEST_ASSERT_UINT32_WITHIN(steps / 20, steps / 2, fastestStep);
+        TEST_ASSERT_UINT32_WITHIN(1, startIntervalTicks, intervalBefore(record, record.stepTicks.size() - 1));
+    }
+}
+
+/**
+ * @brief A move stopped while cruising decelerates over as many steps as it accelerated, back to the start speed.
+ */
+void testStopAtSpeed() {
+    const long steps = 20000;
+    const unsigned long stopTick = ticksPerSecond;  ///< 1 s in, well past the 0.575 s ramp
+    MoveRecord record = runMove(steps, acceleration, jerk, stopTick);
+    TEST_ASSERT_EQUAL((long)record.stepTicks.size(), record.endPosition);
+    TEST_ASSERT_LESS_THAN(steps, record.endPosition);
+
+    size_t stopStep = 0;
+    while (record.stepTicks[stopStep] <= stopTick) {
+        stopStep++;
+    }
+    size_t accelSteps;
+    size_t decelSteps;
+    countRampSteps(record, accelSteps, decelSteps);
+    TEST_ASSERT_UINT32_WITHIN(accelSteps / 50, accelSteps, record.stepTicks.size() - stopStep);
+    TEST_ASSERT_UINT32_WITHIN(1, startIntervalTicks, intervalBefore(record, record.stepTicks.size() - 1));
+    for (size_t i = stopStep + 1; i < record.stepTicks.size(); i++) {
+        TEST_ASSERT_LESS_OR_EQUAL(intervalBefore(record, i) + 1, intervalBefore(record, i - 1));
+    }
+}
+
+/**
+ * @brief A move without a profile steps at the start interval throughout.
+ */
+void testConstantIntervalTiming() {
+    MoveRecord record = runMove(-200, 0, 0);
+    TEST_ASSERT_EQUAL(-200, record.endPosition);
+    TEST_ASSERT_EQUAL(200, (long)record.stepTicks.size());
+    for (size_t i = 0; i < record.stepTicks.size(); i++) {
+        TEST_ASSERT_EQUAL(startIntervalTicks, intervalBefore(record, i));
+    }
+}
+
+int main() {
+    stepper.init();
+
+    UNITY_BEGIN();
+    RUN_TEST(testTrapezoidTiming);
+    RUN_TEST(testSCurveTiming);
+    RUN_TEST(testShortMoveTiming);
+    RUN_TEST(testStopAtSpeed);
+    RUN_TEST(testConstantIntervalTiming);
+    return UNITY_END();
+}
@@ -0,0 +1,142 @@
+/**
+ * @file test_main.cpp
+ * @brief Heap use and free RAM of the firmware.
+ *
+ * On the host the firmware runs a full batch against the simulated machine while every operator new is counted;
+ * the count must stay at zero. The host has no AVR stack to measure, so the free RAM test is ignored there.
+ *
+ * On the board the test boots the firmware and runs its loop for a while, then checks that the heap was never used
+ * and that the free RAM never fell below the budget (see RamMonitor). Without the machine attached the batch stays
+ * idle, so this covers start-up, the idle loop and the interrupts; check a full batch with the console's stats
+ * command on the machine.
+ *
+ *     pio test -e native -f test_ram_watermark
+ *     pio test -e megaatmega2560 -f test_ram_watermark
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "RamMonitor.h"
+
+#if !defined(__AVR__)
+#include <new>
+#include <stdlib.h>
+#include "SimFirmware.h"
+#include "SimMachine.h"
+#endif
+
+namespace {
+
+#if defined(__AVR__)
+const unsigned int ramBudget = 1024;        ///< Least free RAM allowed at the low-water mark, in bytes
+const unsigned long boardRunMs = 10000;     ///< Time the firmware runs on the board before the checks
+#else
+const unsigned long batchTimeLimitS = 900;  ///< Virtual time allowed for the batch
+unsigned long allocationCount = 0;          ///< Calls of operator new since start-up
+#endif
+
+}  // namespace
+
+#if !defined(__AVR__)
+void* operator new(size_t size) {
+    allocationCount++;
+    void* block = malloc(size > 0 ? size : 1);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    return block;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    free(block);
+}
+#endif
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+#if defined(__AVR__)
+
+/**
+ * @brief Nothing was allocated on the heap since start-up.
+ */
+void testHeapUnused() {
+    TEST_ASSERT_EQUAL(0, RamMonitor::getHeapSize());
+}
+
+/**
+ * @brief The free RAM never fell below the budget.
+ */
+void testRamLowWater() {
+    unsigned int lowWater = RamMonitor::getLowWater();
+    char message[48];
+    snprintf_P(message, sizeof(message), PSTR("low water %u bytes, free %u bytes"), lowWater, RamMonitor::getFree());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_OR_EQUAL_MESSAGE(ramBudget, lowWater, message);
+}
+
+int main() {
+    init();
+    setup();  // Paints the free RAM first
+    unsigned long start = millis();
+    while (millis() - start < boardRunMs) {
+        loop();
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(testHeapUnused);
+    RUN_TEST(testRamLowWater);
+    UNITY_END();
+    for (;;) {
+    }
+}
+
+#else
+
+/**
+ * @brief A full batch, from start-up to FERMENTING, makes no heap allocation.
+ */
+void testHeapUnused() {
+    SimMachine sim(SimFirmware::MOTOR_RELAY_PIN);
+    SimFirmware::wire(sim, 20.0f, 25.0f);
+    NativeHal::attach(&sim);
+    NativeHal::setSerialOutput(nullptr);
+
+    setup();
+    TEST_ASSERT_EQUAL(0, allocationCount);
+
+    sim.press(SimFirmware::START_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+    uint64_t deadline = NativeHal::nowUs() + batchTimeLimitS * 1000000ULL;
+    TEST_ASSERT_TRUE(SimFirmware::runUntil("FERMENTING", "FAULT", deadline));
+    TEST_ASSERT_TRUE(SimFirmware::isInState("FERMENTING"));
+    TEST_ASSERT_EQUAL(0, allocationCount);
+
+    NativeHal::attach(nullptr);
+}
+
+/**
+ * @brief Free RAM is only measured on the board.
+ */
+void testRamLowWater() {
+    TEST_IGNORE_MESSAGE("The host has no AVR stack; run on the board with -e megaatmega2560");
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testHeapUnused);
+    RUN_TEST(testRamLowWater);
+    return UNITY_END();
+}
+
+#endif
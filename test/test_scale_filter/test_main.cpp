@@ -0,0 +1,165 @@
+/**
+ * @file test_main.cpp
+ * @brief The weighing scale's filter pipeline on recorded-style sample traces.
+ *
+ * The median, average and step detector are chained as in src/main.cpp and sized as configureScaleFilter() sizes
+ * them at 80 SPS. Noisy traces with chopper spikes must come through without the spikes, and a step of load must
+ * settle in a fraction of the time the average alone would take, because the step detector restarts it.
+ *
+ *     pio test -e native -f test_scale_filter
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "SampleFilter.h"
+
+namespace {
+
+// Stage sizes configureScaleFilter() and applyScaleThresholds() in src/main.cpp pick at 80 SPS with the default
+// calibration factor of 13.40 counts/g.
+const unsigned int sampleMs = 1000 / 80;
+const byte medianSize = 9;             ///< 500 ms capped at MedianFilter::MAX_SIZE
+const byte averageShift = 5;           ///< 400 ms is 32 samples
+const byte stepConfirmSamples = 12;    ///< 150 ms
+const long countsPerGram = 134 / 10;   ///< Rounded; only used to state the tolerances in grams
+const long stepThreshold = 134;        ///< 10 g
+
+const long emptyCounts = 84000;                         ///< Raw reading of the empty container
+const long loadCounts = emptyCounts + 500 * 134 / 10;   ///< 500 g on the scale
+const long noiseCounts = 6;                             ///< Peak noise, about 0.5 g
+const long settledCounts = countsPerGram;               ///< 1 g, the tolerance of a settled reading
+
+MedianFilter median(medianSize);
+EmaFilter average(averageShift);
+StepChangeDetector stepDetector(average, stepThreshold, stepConfirmSamples);
+
+unsigned long noiseState = 1;  ///< State of the noise generator
+
+/**
+ * @brief Returns the next noise sample, uniform in [-noiseCounts, noiseCounts] and the same on every run.
+ *
+ * @return Noise in raw counts.
+ */
+long noise() {
+    noiseState = noiseState * 1103515245UL + 12345UL;
+    return (long)((noiseState >> 16) % (2 * noiseCounts + 1)) - noiseCounts;
+}
+
+/**
+ * @brief Builds the pipeline afresh, with or without the step detector.
+ *
+ * @param pipeline The pipeline to fill; it must be empty.
+ * @param isStepDetected Whether the step detector runs between the median and the average.
+ */
+void buildPipeline(FilterPipeline& pipeline, bool isStepDetected) {
+    pipeline.addStage(median);
+    if (isStepDetected) {
+        pipeline.addStage(stepDetector);
+    }
+    pipeline.addStage(average);
+    pipeline.reset();
+    noiseState = 1;
+}
+
+/**
+ * @brief Runs a noisy step of load through a pipeline and finds when the output settled on the new load.
+ *
+ * One second of the empty container is followed by two seconds with the load on it.
+ *
+ * @param isStepDetected Whether the step detector runs in the pipeline.
+ * @param stepSample Receives the sample at which the step detector fired, or 0 if it did not.
+ * @return Milliseconds from the step until the output stayed within settledCounts of the load.
+ */
+unsigned long settleAfterStep(bool isStepDetected, unsigned long& stepSample) {
+    FilterPipeline pipeline;
+    buildPipeline(pipeline, isStepDetected);
+
+    const unsigned long stepAt = 80;
+    const unsigned long sampleCount = 3 * 80;
+    unsigned long lastUnsettled = stepAt;
+    stepSample = 0;
+    for (unsigned long i = 0; i < sampleCount; i++) {
+        long truth = (i < stepAt) ? emptyCounts : loadCounts;
+        long output = pipeline.apply(truth + noise());
+        if (isStepDetected && stepDetector.isStepDetected() && stepSample == 0) {
+            stepSample = i;
+        }
+        if (i >= stepAt && labs(output - truth) > settledCounts) {
+            lastUnsettled = i;
+        }
+    }
+    return (lastUnsettled + 1 - stepAt) * sampleMs;
+}
+
+}  // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Chopper spikes, single ones and bursts shorter than half the median window, never reach the output.
+ */
+void testSpikesRejected() {
+    FilterPipeline pipeline;
+    buildPipeline(pipeline, true);
+
+    const long spikeCounts = 3000;  ///< About 220 g, a hard knock on the container
+    long worst = 0;
+    for (unsigned long i = 0; i < 4 * 80; i++) {
+        long sample = loadCounts + noise();
+        if (i % 37 == 20) {
+            sample += (i % 2 == 0) ? spikeCounts : -spikeCounts;  // Single spikes of either sign
+        }
+        if (i >= 200 && i < 200 + medianSize / 2) {
+            sample += spikeCounts;  // The longest burst the median can still hide
+        }
+        long output = pipeline.apply(sample);
+        TEST_ASSERT_FALSE_MESSAGE(stepDetector.isStepDetected(), "a spike was taken for a step");
+        if (i >= 40 && labs(output - loadCounts) > worst) {
+            worst = labs(output - loadCounts);
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(noiseCounts, worst);
+}
+
+/**
+ * @brief A step of load fires the step detector once the median has passed it and the confirmation time is up, and
+ * the output then settles at once instead of creeping up with the average's time constant.
+ */
+void testStepSettles() {
+    unsigned long stepSample;
+    unsigned long bypassedMs = settleAfterStep(true, stepSample);
+    unsigned long plainStepSample;
+    unsigned long averagedMs = settleAfterStep(false, plainStepSample);
+
+    // The median lets the new load through after half its window, and the detector then waits for its confirmation.
+    TEST_ASSERT_NOT_EQUAL(0, stepSample);
+    TEST_ASSERT_UINT32_WITHIN(2, 80 + medianSize / 2 + stepConfirmSamples - 1, stepSample);
+
+    // Settled within the detection time plus a few samples, against about ln(670) * 32 samples without the bypass.
+    TEST_ASSERT_LESS_OR_EQUAL((medianSize / 2 + stepConfirmSamples + 4) * sampleMs, bypassedMs);
+    TEST_ASSERT_GREATER_THAN(1500, averagedMs);
+}
+
+/**
+ * @brief Noise on a steady load stays below the threshold, so the step detector never fires on it.
+ */
+void testNoiseNoStep() {
+    FilterPipeline pipeline;
+    buildPipeline(pipeline, true);
+    for (unsigned long i = 0; i < 10 * 80; i++) {
+        pipeline.apply(loadCounts + 2 * noise());
+        TEST_ASSERT_FALSE(i > 0 && stepDetector.isStepDetected());
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testSpikesRejected);
+    RUN_TEST(testStepSettles);
+    RUN_TEST(testNoiseNoStep);
+    return UNITY_END();
+}
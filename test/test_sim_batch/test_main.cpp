@@ -0,0 +1,163 @@
+/**
+ * @file test_main.cpp
+ * @brief Full batches of the firmware on the simulated machine.
+ *
+ * The firmware is booted with setup() and runs two batches back to back, with a reset and an emptied container in
+ * between, as an operator would. Every loop the test notes the batch state, and at each change of state the slider
+ * position of the simulated machine, i.e. where the slider physically is. Each batch must dose both ingredients
+ * to their targets with the slider at the dosing station, and carry the container to the mixer and the sealer.
+ *
+ *     pio test -e native -f test_sim_batch
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include "BatchStateMachine.h"
+#include "SimFirmware.h"
+#include "SimMachine.h"
+
+extern BatchStateMachine batch;  ///< The firmware's batch process (src/main.cpp)
+
+namespace {
+
+// Stations and targets from src/main.cpp.
+const long dosingStation = 0;
+const long mixerStation = 18000;
+const long sealerStation = 57000;
+const float doseTarget = 500.0f;
+const float doseTolerance = 15.0f;          ///< g; the chopper's spin-down lands about 10 g late
+const unsigned long batchTimeLimitS = 900;  ///< Virtual time allowed for a batch
+const byte batchCount = 2;
+
+/**
+ * @brief Where the slider was when the batch entered and left a state.
+ */
+struct StateVisit {
+    const char* name;   ///< State name as the firmware shows it
+    bool isEntered;     ///< Whether the state was entered in this batch
+    long entrySlider;   ///< Slider position when the state was entered
+    long exitSlider;    ///< Slider position when the state was left
+};
+
+StateVisit visits[] = {
+    { "ADD BANANA", false, 0, 0 },
+    { "ADD MOLASSES", false, 0, 0 },
+    { "MIX", false, 0, 0 },
+    { "SEAL", false, 0, 0 },
+    { "FERMENTING", false, 0, 0 },
+};
+const byte visitCount = sizeof(visits) / sizeof(visits[0]);
+
+SimMachine* machine = nullptr;
+const __FlashStringHelper* lastState = nullptr;  ///< State at the previous loop
+
+/**
+ * @brief Returns the visit record of a state.
+ *
+ * @param name State name as the firmware shows it.
+ * @return The record, or nullptr for a state that is not checked.
+ */
+StateVisit* findVisit(const __FlashStringHelper* name) {
+    for (byte i = 0; i < visitCount; i++) {
+        if (strcmp_P(visits[i].name, reinterpret_cast<const char*>(name)) == 0) {
+            return &visits[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Notes the slider position whenever the batch changes state. Called after every loop().
+ */
+void watchStates() {
+    const __FlashStringHelper* state = batch.getStateName();
+    if (state == lastState) {
+        return;
+    }
+    long slider = machine->getAxisPosition(SimFirmware::AXIS_SLIDER);
+    StateVisit* left = (lastState != nullptr) ? findVisit(lastState) : nullptr;
+    if (left != nullptr) {
+        left->exitSlider = slider;
+    }
+    StateVisit* entered = findVisit(state);
+    if (entered != nullptr) {
+        entered->isEntered = true;
+        entered->entrySlider = slider;
+    }
+    lastState = state;
+}
+
+/**
+ * @brief Checks that a state was entered with the slider at a station, and left with it still there.
+ *
+ * @param name State to check.
+ * @param station Expected slider position.
+ * @param isExitChecked Whether the state must also have been left at the station.
+ */
+void checkStation(const char* name, long station, bool isExitChecked) {
+    StateVisit* visit = findVisit(reinterpret_cast<const __FlashStringHelper*>(name));
+    TEST_ASSERT_NOT_NULL(visit);
+    TEST_ASSERT_TRUE_MESSAGE(visit->isEntered, name);
+    TEST_ASSERT_EQUAL_MESSAGE(station, visit->entrySlider, name);
+    if (isExitChecked) {
+        TEST_ASSERT_EQUAL_MESSAGE(station, visit->exitSlider, name);
+    }
+}
+
+}  // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Runs the batches one after the other and checks each of them.
+ */
+void testBatches() {
+    SimMachine sim(SimFirmware::MOTOR_RELAY_PIN);
+    SimFirmware::wire(sim, 20.0f, 25.0f);
+    machine = &sim;
+    NativeHal::attach(&sim);
+    NativeHal::setSerialOutput(nullptr);
+    setup();
+    TEST_ASSERT_TRUE(SimFirmware::isInState("IDLE"));
+
+    for (byte i = 0; i < batchCount; i++) {
+        uint64_t deadline = NativeHal::nowUs() + batchTimeLimitS * 1000000ULL;
+        if (i > 0) {
+            sim.press(SimFirmware::RESET_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+            TEST_ASSERT_TRUE(SimFirmware::runUntil("IDLE", nullptr, deadline, watchStates));
+        }
+        sim.emptyContainer();
+        SimFirmware::runFor(SimFirmware::BUTTON_PRESS_MS, watchStates);
+        for (byte v = 0; v < visitCount; v++) {
+            visits[v].isEntered = false;
+        }
+
+        sim.press(SimFirmware::START_BUTTON_PIN, SimFirmware::BUTTON_PRESS_MS);
+        TEST_ASSERT_TRUE(SimFirmware::runUntil("FERMENTING", "FAULT", deadline, watchStates));
+        TEST_ASSERT_TRUE_MESSAGE(SimFirmware::isInState("FERMENTING"), "batch stopped in FAULT");
+        SimFirmware::runFor(2000, watchStates);  // Let material still falling land before it is weighed
+
+        // The slider goes back to the dosing station before every dose, also after the previous batch left it
+        // at the sealer, and only leaves it once both ingredients are in.
+        checkStation("ADD BANANA", dosingStation, true);
+        checkStation("ADD MOLASSES", dosingStation, true);
+        TEST_ASSERT_EQUAL(mixerStation, findVisit(reinterpret_cast<const __FlashStringHelper*>("MIX"))->exitSlider);
+        checkStation("FERMENTING", sealerStation, false);
+
+        TEST_ASSERT_FLOAT_WITHIN(doseTolerance, doseTarget, sim.getFedGrams(SimFirmware::FEEDER_BANANA));
+        TEST_ASSERT_FLOAT_WITHIN(doseTolerance, doseTarget, sim.getFedGrams(SimFirmware::FEEDER_MOLASSES));
+    }
+
+    NativeHal::attach(nullptr);
+    machine = nullptr;
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testBatches);
+    return UNITY_END();
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_main.cpp
+ * @brief Round trip of Telemetry records through tools/telemetry_decode.py.
+ *
+ * Records of every type are framed by Telemetry into a file, which the decoder then reads with --csv. The test
+ * compares its output field by field, so the record layouts, the CRC and the COBS framing on both sides have to
+ * agree. Payload values include zero bytes, which COBS has to move out of the frame.
+ *
+ *     pio test -e native -f test_telemetry
+ *
+ * The decoder runs as python3 from the project directory; the test is ignored if it cannot be started.
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Telemetry.h"
+
+namespace {
+
+const char* decoderPath = "tools/telemetry_decode.py";
+
+/**
+ * @class CaptureFile
+ * @brief Port that writes the records into a temporary file, and can refuse them to test dropping.
+ */
+class CaptureFile : public Print {
+public:
+    CaptureFile() {
+        strcpy(path, "/tmp/telemetry_XXXXXX");
+        int handle = mkstemp(path);
+        this->file = (handle >= 0) ? fdopen(handle, "wb") : nullptr;
+        this->isFull = false;
+    }
+
+    ~CaptureFile() {
+        close();
+        unlink(path);
+    }
+
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return (file != nullptr) ? fwrite(buffer, 1, size, file) : 0;
+    }
+
+    int availableForWrite() override {
+        return isFull ? 0 : HardwareSerial::TX_BUFFER_FREE;
+    }
+
+    /**
+     * @brief Finishes the file so the decoder can read it.
+     */
+    void close() {
+        if (file != nullptr) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    char path[32];   ///< Name of the file
+    FILE* file;      ///< The open file, or nullptr once closed
+    bool isFull;     ///< Whether the port reports no room, so records are dropped
+};
+
+/**
+ * @brief Runs the decoder on a file and collects its output.
+ *
+ * @param path File to decode.
+ * @param output Receives the CSV lines and the summary line.
+ * @param size Size of the output buffer.
+ * @return true if the decoder ran and exited normally.
+ */
+bool decode(const char* path, char* output, size_t size) {
+    if (access(decoderPath, R_OK) != 0) {
+        return false;
+    }
+    char command[128];
+    snprintf(command, sizeof(command), "python3 %s --csv %s 2>&1", decoderPath, path);
+    FILE* pipe = popen(command, "r");
+    if (pipe == nullptr) {
+        return false;
+    }
+    size_t length = fread(output, 1, size - 1, pipe);
+    output[length] = '\0';
+    return pclose(pipe) == 0;
+}
+
+/**
+ * @brief Builds one record of every type, numbered from sequence 0.
+ *
+ * @param telemetry The framer to send the records with.
+ */
+void sendRecords(Telemetry& telemetry) {
+    telemetry.beginFrame(1, 1000);  // WEIGHT
+    telemetry.addInt16(256);
+    telemetry.addInt32(-84000);
+    telemetry.addInt32(50012);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+
+    telemetry.beginFrame(2, 70000);  // AXES
+    telemetry.addInt32(57000);
+    telemetry.addByte(1);
+    telemetry.addInt32(0);
+    telemetry.addByte(2);
+    telemetry.addInt32(-20000);
+    telemetry.addByte(0);
+    telemetry.addInt32(38000);
+    telemetry.addByte(1);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+
+    telemetry.beginFrame(3, 16777216UL);  // STATE
+    telemetry.addByte(3);
+    telemetry.addByte(1);
+    telemetry.addByte(1);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+
+    telemetry.beginFrame(4, 4294967295UL);  // TIMING
+    telemetry.addInt32(1234);
+    telemetry.addInt32(0);
+    telemetry.addInt32(65536);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+}
+
+}  // namespace
+
+void setUp() {
+}
+
+void tearDown() {
+}
+
+/**
+ * @brief Every record type decodes to the values it was built with, with no bad or lost frames.
+ */
+void testRoundTrip() {
+    CaptureFile capture;
+    TEST_ASSERT_NOT_NULL(capture.file);
+    Telemetry telemetry(capture);
+    sendRecords(telemetry);
+    capture.close();
+
+    char output[1024];
+    if (!decode(capture.path, output, sizeof(output))) {
+        TEST_IGNORE_MESSAGE("python3 tools/telemetry_decode.py could not be run");
+    }
+    TEST_ASSERT_EQUAL_STRING(
+        "1000,0,WEIGHT,samples=256,raw=-84000,weight_g=500.12\n"
+        "70000,1,AXES,slider=57000,slider_state=KNOWN,sealer=0,sealer_state=HOMED,"
+        "mixing_tool=-20000,mixing_tool_state=LOST,mixer=38000,mixer_state=KNOWN\n"
+        "16777216,2,STATE,state=ADD_MOLASSES,sub_step=1,dosing=TRICKLE\n"
+        "4294967295,3,TIMING,max_latency_us=1234,log_drops=0,telemetry_drops=65536\n"
+        "Bad frames: 0, lost records: 0\n",
+        output);
+    TEST_ASSERT_EQUAL(4, telemetry.getSentCount());
+    TEST_ASSERT_EQUAL(0, telemetry.getDropCount());
+}
+
+/**
+ * @brief A record dropped for want of room shows as a sequence gap, and a corrupted frame fails its CRC.
+ */
+void testDropAndCorruption() {
+    CaptureFile capture;
+    TEST_ASSERT_NOT_NULL(capture.file);
+    Telemetry telemetry(capture);
+
+    telemetry.beginFrame(3, 10);
+    telemetry.addByte(0);
+    telemetry.addByte(0);
+    telemetry.addByte(0);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+
+    capture.isFull = true;
+    telemetry.beginFrame(3, 20);
+    telemetry.addByte(1);
+    telemetry.addByte(0);
+    telemetry.addByte(0);
+    TEST_ASSERT_FALSE(telemetry.endFrame());
+    capture.isFull = false;
+
+    const byte corrupted[] = { 0x03, 0x03, 0x02, 0x01, 0x00 };  // Truncated frame with a valid delimiter
+    capture.write(corrupted, sizeof(corrupted));
+
+    telemetry.beginFrame(3, 30);
+    telemetry.addByte(6);
+    telemetry.addByte(0);
+    telemetry.addByte(2);
+    TEST_ASSERT_TRUE(telemetry.endFrame());
+    capture.close();
+
+    char output[512];
+    if (!decode(capture.path, output, sizeof(output))) {
+        TEST_IGNORE_MESSAGE("python3 tools/telemetry_decode.py could not be run");
+    }
+    TEST_ASSERT_EQUAL_STRING(
+        "10,0,STATE,state=IDLE,sub_step=0,dosing=FAST\n"
+        "30,2,STATE,state=FERMENTING,sub_step=0,dosing=STOP\n"
+        "Bad frames: 1, lost records: 1\n",
+        output);
+    TEST_ASSERT_EQUAL(2, telemetry.getSentCount());
+    TEST_ASSERT_EQUAL(1, telemetry.getDropCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(testRoundTrip);
+    RUN_TEST(testDropAndCorruption);
+    return UNITY_END();
+}
@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Decodes the binary telemetry stream sent by the machine on Serial1.
+
+Each record is COBS-encoded and ends with a 0x00 byte. Decoded, it is:
+
+    type (u8) | sequence (u8) | time in ms (u32) | payload | CRC-16/CCITT (u16, over everything before it)
+
+All fields are little-endian. Record payloads (see TelemetryRecord in src/main.cpp):
+
+    1 WEIGHT  sample count (u16), raw reading (i32), filtered weight in 0.01 g (i32)
+    2 AXES    4 x (position in steps (i32), axis state (u8)) for slider, sealer, mixing tool, mixer
+    3 STATE   batch state (u8), sub-step (u8), dosing phase (u8)
+    4 TIMING  max loop latency in us (u32), log drops (u32), telemetry drops (u32)
+
+Usage:
+    telemetry_decode.py capture.bin          decode a recorded stream
+    telemetry_decode.py --port /dev/ttyUSB1  decode live (needs pyserial)
+    telemetry_decode.py --csv capture.bin    one CSV line per record
+"""
+
+import argparse
+import struct
+import sys
+
+WEIGHT, AXES, STATE, TIMING = 1, 2, 3, 4
+
+BATCH_STATES = ["IDLE", "HOMING", "ADD_BANANA", "ADD_MOLASSES", "MIX", "SEAL", "FERMENTING", "FAULT", "CALIBRATE"]
+DOSING_PHASES = ["FAST", "TRICKLE", "STOP"]
+AXIS_STATES = ["LOST", "KNOWN", "HOMED"]
+AXIS_NAMES = ["slider", "sealer", "mixing_tool", "mixer"]
+
+
+def crc16(data):
+    """CRC-16/CCITT, polynomial 0x1021, initial value 0xFFFF."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decodes one COBS frame without its 0x00 delimiter. Returns None if it is malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_payload(kind, payload):
+    """Turns a record payload into a dict of named fields."""
+    if kind == WEIGHT:
+        count, raw, weight = struct.unpack("<Hii", payload)
+        return {"samples": count, "raw": raw, "weight_g": weight / 100.0}
+    if kind == AXES:
+        fields = {}
+        for index, name in enumerate(AXIS_NAMES):
+            position, state = struct.unpack_from("<iB", payload, index * 5)
+            fields[name] = position
+            fields[name + "_state"] = AXIS_STATES[state] if state < len(AXIS_STATES) else state
+        return fields
+    if kind == STATE:
+        state, sub_step, phase = struct.unpack("<BBB", payload)
+        return {
+            "state": BATCH_STATES[state] if state < len(BATCH_STATES) else state,
+            "sub_step": sub_step,
+            "dosing": DOSING_PHASES[phase] if phase < len(DOSING_PHASES) else phase,
+        }
+    if kind == TIMING:
+        latency, log_drops, telemetry_drops = struct.unpack("<III", payload)
+        return {"max_latency_us": latency, "log_drops": log_drops, "telemetry_drops": telemetry_drops}
+    return {"payload": payload.hex()}
+
+
+RECORD_NAMES = {WEIGHT: "WEIGHT", AXES: "AXES", STATE: "STATE", TIMING: "TIMING"}
+
+
+class Decoder:
+    """Splits a byte stream into records and checks their CRC, length and sequence numbers."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_sequence = None
+        self.bad_frames = 0
+        self.lost_records = 0
+
+    def feed(self, data):
+        """Adds received bytes and yields every complete, valid record as (type, sequence, time_ms, fields)."""
+        self.buffer += data
+        while True:
+            end = self.buffer.find(0)
+            if end < 0:
+                return
+            encoded = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if not encoded:
+                continue
+            frame = cobs_decode(encoded)
+            if frame is None or len(frame) < 8 or crc16(frame[:-2]) != struct.unpack("<H", frame[-2:])[0]:
+                self.bad_frames += 1
+                continue
+
+            kind, sequence, time_ms = struct.unpack("<BBI", frame[:6])
+            if self.last_sequence is not None:
+                self.lost_records += (sequence - self.last_sequence - 1) % 256
+            self.last_sequence = sequence
+            try:
+                fields = parse_payload(kind, frame[6:-2])
+            except struct.error:
+                self.bad_frames += 1
+                continue
+            yield kind, sequence, time_ms, fields
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the machine's binary telemetry stream.")
+    parser.add_argument("file", nargs="?", help="recorded stream, '-' or omitted for stdin")
+    parser.add_argument("--port", help="serial port to read live instead of a file")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate for --port (default 115200)")
+    parser.add_argument("--csv", action="store_true", help="print one CSV line per record")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial  # pyserial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: source.read(256)
+    else:
+        source = open(args.file, "rb") if args.file and args.file != "-" else sys.stdin.buffer
+        read = lambda: source.read(4096)
+
+    decoder = Decoder()
+    try:
+        while True:
+            data = read()
+            if not data:
+                if args.port:
+                    continue
+                break
+            for kind, sequence, time_ms, fields in decoder.feed(data):
+                name = RECORD_NAMES.get(kind, str(kind))
+                if args.csv:
+                    values = ",".join("%s=%s" % item for item in fields.items())
+                    print("%d,%d,%s,%s" % (time_ms, sequence, name, values))
+                else:
+                    values = " ".join("%s=%s" % item for item in fields.items())
+                    print("%10.3f s #%3d %-6s %s" % (time_ms / 1000.0, sequence, name, values))
+    except KeyboardInterrupt:
+        pass
+
+    print("Bad frames: %d, lost records: %d" % (decoder.bad_frames, decoder.lost_records), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()